@@ -3,11 +3,10 @@ out vec4 FragColor;
 
 in vec3 ourColor;
 in vec3 vPos;
-in vec2 TexCoord;
+in vec3 TexCoord;
 
-uniform sampler2D texture1;
-uniform sampler2D texture2;
+uniform sampler2DArray blockTextures;
 
 void main() {
-	FragColor = mix(texture(texture1, TexCoord), texture(texture2, vec2(TexCoord.x, TexCoord.y)), 0.2);
+	FragColor = texture(blockTextures, TexCoord);
 }	
@@ -15,6 +15,11 @@ class Shader
 {
 public:
     unsigned int ID;
+    // wraps a program that was linked elsewhere, see ShaderManager
+    // ------------------------------------------------------------------------
+    explicit Shader(unsigned int program) : ID(program)
+    {
+    }
     // constructor generates the shader on the fly
     // ------------------------------------------------------------------------
     Shader(const char* vertexPath, const char* fragmentPath)
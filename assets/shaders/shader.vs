@@ -2,7 +2,7 @@
 layout (location = 0) in vec3 aPos;
 layout (location = 1) in vec3 aTexCoord;
 
-out vec2 TexCoord;
+out vec3 TexCoord; // z is the layer in the block texture array
 
 uniform mat4 model;
 uniform mat4 view;
@@ -11,5 +11,5 @@ uniform mat4 projection;
 void main()
 {
     gl_Position = projection * view * model * vec4(aPos, 1.0);  
-	TexCoord = vec2(aTexCoord.x, aTexCoord.y);
+	TexCoord = aTexCoord;
 }
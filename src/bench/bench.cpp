@@ -0,0 +1,1170 @@
+// Headless benchmarks for the engine. Nothing in here needs a window or a GPU.
+//
+//   scuffed_bench            runs everything
+//   scuffed_bench <name>...  runs only the named benchmarks
+//
+// Besides timings, most of them check their results along the way. The exit code
+// is 1 when any check failed.
+
+#include "../engine/asset_loader.h"
+#include "../engine/chunk_snapshot.h"
+#include "../engine/chunk_sync.h"
+#include "../engine/entities.h"
+#include "../engine/lod.h"
+#include "../engine/memory_governor.h"
+#include "../engine/physics.h"
+#include "../engine/raycast.h"
+#include "../engine/simulation.h"
+#include "../engine/texture_compression.h"
+#include "../engine/vertex_pool.h"
+#include "../engine/timestep.h"
+#include "../engine/visibility.h"
+#include "../engine/world_edit.h"
+#include "../engine/world_io.h"
+#include "../engine/worldgen.h"
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <iostream>
+#include <random>
+#include <stdlib.h>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+// every heap allocation in the process goes through here, so benchmarks can count them
+static std::atomic<uint64_t> heapAllocations(0);
+
+void* operator new(size_t size) {
+	heapAllocations.fetch_add(1, std::memory_order_relaxed);
+	void* memory = std::malloc(size != 0 ? size : 1);
+	if (memory == nullptr) throw std::bad_alloc();
+	return memory;
+}
+
+void operator delete(void* memory) noexcept {
+	std::free(memory);
+}
+
+void operator delete(void* memory, size_t) noexcept {
+	std::free(memory);
+}
+
+static double millisecondsSince(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
+
+// A block of solid stone riddled with tunnels, about as bad as it gets for culling.
+static void buildCaveWorld(World& world, int radius, int layers) {
+	CaveCarver carver(1337u, 0.03f);
+	for (int cy = 0; cy < layers; cy++) {
+		for (int cz = -radius; cz < radius; cz++) {
+			for (int cx = -radius; cx < radius; cx++) {
+				Chunk& chunk = world.createChunk(cx, cy, cz);
+				chunk.fill(BLOCK_STONE);
+				carver.carve(chunk);
+			}
+		}
+	}
+}
+
+static size_t benchCaveCulling() {
+	const int radius = 16;
+	const int layers = 4;
+	World world;
+	Clock::time_point start = Clock::now();
+	buildCaveWorld(world, radius, layers);
+	std::cout << "  generated " << world.chunkCount() << " chunks in " << millisecondsSince(start) << " ms\n";
+
+	CaveCuller culler;
+	culler.setRadius(radius);
+	start = Clock::now();
+	for (const auto& entry : world.allChunks()) {
+		culler.setConnectivity(entry.chunk->position, computeFaceConnectivity(*entry.chunk));
+	}
+	double connectivityMs = millisecondsSince(start);
+	std::cout << "  face connectivity: " << (connectivityMs * 1000.0 / world.chunkCount()) << " us per chunk\n";
+
+	// drop the camera into random cave air, looking in random directions
+	std::mt19937 rng(42);
+	std::uniform_int_distribution<int> coord(-radius * CHUNK_SIZE / 2, radius * CHUNK_SIZE / 2);
+	std::uniform_int_distribution<int> height(CHUNK_SIZE, (layers - 1) * CHUNK_SIZE - 1);
+	std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+	const int views = 200;
+	size_t visibleTotal = 0;
+	size_t reachableTotal = 0;
+	double updateMs = 0.0;
+	int placed = 0;
+	while (placed < views) {
+		glm::ivec3 block(coord(rng), height(rng), coord(rng));
+		if (world.getBlock(block.x, block.y, block.z) != BLOCK_AIR) continue;
+		placed++;
+		float yaw = angle(rng);
+		glm::vec3 dir(std::cos(yaw), 0.0f, std::sin(yaw));
+		glm::vec3 camera = glm::vec3(block) + 0.5f;
+
+		start = Clock::now();
+		culler.update(camera, dir);
+		updateMs += millisecondsSince(start);
+		visibleTotal += culler.visibleChunks().size();
+
+		// chunks in front of the camera within the radius, what we'd draw without culling
+		for (const auto& entry : world.allChunks()) {
+			glm::vec3 centre = (glm::vec3(entry.chunk->position) + 0.5f) * (float)CHUNK_SIZE;
+			glm::vec3 offset = centre - camera;
+			if (std::fabs(offset.x) > radius * CHUNK_SIZE || std::fabs(offset.z) > radius * CHUNK_SIZE) continue;
+			if (glm::dot(offset, dir) >= -CHUNK_SIZE * 0.8660254f) reachableTotal++;
+		}
+	}
+	std::cout << "  " << views << " underground views: " << (updateMs * 1000.0 / views) << " us per update\n";
+	std::cout << "  chunks in front of camera: " << (double)reachableTotal / views
+		<< ", visible after cave culling: " << (double)visibleTotal / views << "\n";
+	return 0;
+}
+
+// Mostly open space with a sprinkling of stone, rays get to travel a long way through it.
+static void buildScatterWorld(World& world, int radius, int layers, float density) {
+	std::mt19937 rng(99);
+	std::uniform_real_distribution<float> chance(0.0f, 1.0f);
+	for (int cy = 0; cy < layers; cy++) {
+		for (int cz = -radius; cz < radius; cz++) {
+			for (int cx = -radius; cx < radius; cx++) {
+				Chunk& chunk = world.createChunk(cx, cy, cz);
+				for (int i = 0; i < CHUNK_VOLUME; i++) {
+					if (chance(rng) < density) chunk.mutableBlocks()[i] = BLOCK_STONE;
+				}
+			}
+		}
+	}
+}
+
+static size_t benchRaycast() {
+	const int radius = 8;
+	const int layers = 4;
+	World world;
+	buildScatterWorld(world, radius, layers, 0.002f);
+
+	// rays start in open air and head off in any direction, long enough to cross several chunks
+	std::mt19937 rng(7);
+	std::uniform_int_distribution<int> coord(-radius * CHUNK_SIZE / 2, radius * CHUNK_SIZE / 2);
+	std::uniform_int_distribution<int> height(0, layers * CHUNK_SIZE - 1);
+	std::normal_distribution<float> gauss(0.0f, 1.0f);
+	const size_t count = 200000;
+	const float maxDistance = 96.0f;
+	std::vector<Ray> rays;
+	rays.reserve(count);
+	while (rays.size() < count) {
+		glm::ivec3 block(coord(rng), height(rng), coord(rng));
+		if (world.getBlock(block.x, block.y, block.z) != BLOCK_AIR) continue;
+		glm::vec3 dir(gauss(rng), gauss(rng), gauss(rng));
+		if (glm::length(dir) < 0.001f) continue;
+		rays.push_back({glm::vec3(block) + 0.5f, glm::normalize(dir), maxDistance});
+	}
+
+	std::vector<RayHit> hits;
+	Clock::time_point start = Clock::now();
+	raycastBatch(world, rays, hits, 1);
+	double singleMs = millisecondsSince(start);
+
+	start = Clock::now();
+	raycastBatch(world, rays, hits, 0);
+	double batchMs = millisecondsSince(start);
+
+	double travelled = 0.0;
+	size_t chunkCrossings = 0;
+	size_t hitCount = 0;
+	for (size_t i = 0; i < rays.size(); i++) {
+		travelled += hits[i].distance;
+		if (hits[i].hit) hitCount++;
+		glm::vec3 end = rays[i].origin + rays[i].direction * hits[i].distance;
+		for (int axis = 0; axis < 3; axis++) {
+			chunkCrossings += std::abs(floorDiv((int)std::floor(end[axis]), CHUNK_SIZE) - floorDiv((int)std::floor(rays[i].origin[axis]), CHUNK_SIZE));
+		}
+	}
+	std::cout << "  " << count << " rays, " << (100.0 * hitCount / count) << "% hit, average length " << travelled / count
+		<< " blocks, " << (double)chunkCrossings / count << " chunk crossings per ray\n";
+	std::cout << "  1 thread: " << (count / singleMs / 1000.0) << " M rays/s\n";
+	std::cout << "  " << std::thread::hardware_concurrency() << " threads: " << (count / batchMs / 1000.0) << " M rays/s\n";
+	return 0;
+}
+
+// Rolling hills with pillars sticking out, so bodies keep landing, climbing and sliding along walls.
+static void buildHillWorld(World& world, int radius, int layers) {
+	for (int cy = 0; cy < layers; cy++) {
+		for (int cz = -radius; cz < radius; cz++) {
+			for (int cx = -radius; cx < radius; cx++) {
+				Chunk& chunk = world.createChunk(cx, cy, cz);
+				for (int z = 0; z < CHUNK_SIZE; z++) {
+					for (int x = 0; x < CHUNK_SIZE; x++) {
+						int wx = cx * CHUNK_SIZE + x;
+						int wz = cz * CHUNK_SIZE + z;
+						int height = 12 + (int)(6.0f * std::sin(wx * 0.11f) * std::cos(wz * 0.07f));
+						if (wx % 9 == 0 && wz % 7 == 0) height += 4;
+						for (int y = 0; y < CHUNK_SIZE; y++) {
+							if (cy * CHUNK_SIZE + y < height) chunk.set(x, y, z, BLOCK_STONE);
+						}
+					}
+				}
+			}
+		}
+	}
+}
+
+static size_t benchEntityCollision() {
+	const int radius = 8;
+	const int layers = 2;
+	World world;
+	buildHillWorld(world, radius, layers);
+
+	// mob sized boxes dropped from above, each wandering off in its own direction
+	std::mt19937 rng(3);
+	std::uniform_real_distribution<float> coord(-radius * CHUNK_SIZE * 0.75f, radius * CHUNK_SIZE * 0.75f);
+	std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+	const size_t count = 4096;
+	const int ticks = 200;
+	const float tickSeconds = 1.0f / 20.0f;
+	std::vector<PhysicsBody> bodies(count);
+	for (PhysicsBody& body : bodies) {
+		body.position = glm::vec3(coord(rng), layers * CHUNK_SIZE - 2.0f, coord(rng));
+		body.velocity = glm::vec3(0.0f);
+		body.halfExtents = glm::vec3(0.3f, 1.8f, 0.3f);
+		body.onGround = false;
+		body.gravity = true;
+	}
+
+	size_t grounded = 0;
+	Clock::time_point start = Clock::now();
+	for (int tick = 0; tick < ticks; tick++) {
+		for (size_t i = 0; i < count; i++) {
+			PhysicsBody& body = bodies[i];
+			// change heading now and then, hop whenever something is in the way
+			if ((tick + i) % 40 == 0) {
+				float yaw = angle(rng);
+				body.velocity.x = 4.0f * std::cos(yaw);
+				body.velocity.z = 4.0f * std::sin(yaw);
+			}
+			if (body.onGround && (tick + i) % 10 == 0) body.velocity.y = 8.5f;
+			stepBody(world, body, tickSeconds);
+			if (body.onGround) grounded++;
+		}
+	}
+	double ms = millisecondsSince(start);
+
+	size_t fellThrough = 0;
+	for (const PhysicsBody& body : bodies) {
+		if (body.position.y < 0.0f) fellThrough++;
+	}
+	std::cout << "  " << count << " bodies x " << ticks << " ticks: " << (ms * 1000.0 / ((double)count * ticks)) << " us per body step\n";
+	std::cout << "  on the ground " << (100.0 * grounded / ((double)count * ticks)) << "% of steps, "
+		<< fellThrough << " fell through the floor\n";
+	return fellThrough;
+}
+
+// Runs the entity systems over a herd of mobs for a number of ticks, returns ms per tick.
+static double runHerd(EntityRegistry& entities, const World& world, SpatialHash& grid, int ticks, unsigned threads) {
+	Clock::time_point start = Clock::now();
+	for (int tick = 0; tick < ticks; tick++) {
+		steerWanderers(entities, threads);
+		stepBodies(entities, world, 1.0f / 20.0f, threads);
+		buildSpatialHash(entities, grid);
+	}
+	return millisecondsSince(start) / ticks;
+}
+
+static size_t benchEntities() {
+	const int radius = 8;
+	const int layers = 2;
+	World world;
+	buildHillWorld(world, radius, layers);
+
+	std::mt19937 rng(5);
+	std::uniform_real_distribution<float> coord(-radius * CHUNK_SIZE * 0.75f, radius * CHUNK_SIZE * 0.75f);
+	const size_t count = 50000;
+	EntityRegistry entities;
+	Clock::time_point start = Clock::now();
+	for (size_t i = 0; i < count; i++) {
+		spawnMob(entities, glm::vec3(coord(rng), layers * CHUNK_SIZE - 2.0f, coord(rng)), (uint32_t)i + 1);
+	}
+	std::cout << "  spawned " << count << " mobs in " << millisecondsSince(start) << " ms, "
+		<< entities.archetypeCount() << " archetypes\n";
+
+	SpatialHash grid;
+	// let them land first so both runs see the same kind of work
+	runHerd(entities, world, grid, 40, 0);
+	const int ticks = 100;
+	double singleMs = runHerd(entities, world, grid, ticks, 1);
+	double parallelMs = runHerd(entities, world, grid, ticks, 0);
+	std::cout << "  steer + step + hash, 1 thread: " << singleMs << " ms per tick\n";
+	std::cout << "  " << std::thread::hardware_concurrency() << " threads: " << parallelMs << " ms per tick\n";
+
+	// every mob asking who's within 4 blocks of it
+	std::vector<Entity> near;
+	size_t found = 0;
+	start = Clock::now();
+	entities.each<PhysicsBody>([&](Entity, PhysicsBody& body) {
+		near.clear();
+		grid.query(body.position, 4.0f, near);
+		found += near.size();
+	});
+	double queryMs = millisecondsSince(start);
+	std::cout << "  neighbour queries: " << (queryMs * 1000.0 / count) << " us each, "
+		<< (double)found / count << " neighbours on average, " << grid.cellCount() << " cells\n";
+
+	// a couple of batches on four threads, mostly the cost of getting the threads going
+	EntityRegistry few;
+	for (size_t i = 0; i < 2 * ENTITY_BATCH; i++) spawnMob(few, glm::vec3(coord(rng), layers * CHUNK_SIZE - 2.0f, coord(rng)), (uint32_t)i + 1);
+	const int calls = 2000;
+	start = Clock::now();
+	for (int i = 0; i < calls; i++) steerWanderers(few, 4);
+	std::cout << "  steering " << few.size() << " mobs on 4 threads: " << (millisecondsSince(start) * 1000.0 / calls) << " us per call\n";
+	return 0;
+}
+
+// Blocks that differ between a client's copy of the world and the real thing.
+static size_t countMismatches(const World& server, const World& mirror) {
+	size_t mismatched = 0;
+	for (const auto& entry : mirror.allChunks()) {
+		const Chunk& copy = *entry.chunk;
+		const Chunk* real = server.getChunk(copy.position.x, copy.position.y, copy.position.z);
+		for (int i = 0; i < CHUNK_VOLUME; i++) {
+			if (real == nullptr ? copy.blockData()[i] != BLOCK_AIR : copy.blockData()[i] != real->blockData()[i]) mismatched++;
+		}
+	}
+	return mismatched;
+}
+
+// Runs a server and a crowd of clients in this process over 127.0.0.1. Each
+// client wanders about and edits a block now and then. Returns how many blocks
+// the clients got wrong, or 1 when it couldn't get going.
+static size_t runNetSync(int clientCount) {
+	const int radius = 8;
+	const int viewRadius = 4;
+	World world;
+	buildHillWorld(world, radius, 2);
+	Simulation simulation(world, glm::vec3(0.5f, 40.0f, 0.5f), 1);
+	NetServer net;
+	if (!net.listen("127.0.0.1", 0)) return 1;
+	ChunkSyncServer sync(world, simulation.edits(), net);
+
+	struct Bot {
+		World mirror;
+		std::unique_ptr<ChunkSyncClient> client;
+		glm::vec3 position;
+		glm::vec3 heading;
+	};
+	std::mt19937 rng(clientCount);
+	std::uniform_real_distribution<float> coord(-radius * CHUNK_SIZE * 0.5f, radius * CHUNK_SIZE * 0.5f);
+	std::uniform_real_distribution<float> angle(0.0f, 6.2831853f);
+	std::uniform_int_distribution<int> nearby(-6, 6);
+	std::uniform_int_distribution<int> block(0, BLOCK_COUNT - 1);
+	std::vector<std::unique_ptr<Bot>> bots;
+	for (int i = 0; i < clientCount; i++) {
+		std::unique_ptr<Bot> bot(new Bot());
+		bot->client.reset(new ChunkSyncClient(bot->mirror));
+		if (!bot->client->connect("127.0.0.1", net.port(), viewRadius)) {
+			std::cout << "  client " << i << " couldn't connect\n";
+			return 1;
+		}
+		bot->position = glm::vec3(coord(rng), 14.0f, coord(rng));
+		float yaw = angle(rng);
+		bot->heading = glm::vec3(std::cos(yaw), 0.0f, std::sin(yaw));
+		bots.push_back(std::move(bot));
+	}
+
+	// one server tick plus everyone's network traffic, as fast as it'll go
+	const int streamTicks = 100;
+	const int ticks = 400;
+	RollingTimer tickTimer(ticks);
+	uint64_t bytesAtSteady = 0;
+	for (int tick = 0; tick < ticks + 20; tick++) {
+		bool editing = tick < ticks;
+		for (std::unique_ptr<Bot>& bot : bots) {
+			if (editing) {
+				bot->position += bot->heading * (4.0f / Simulation::TICKS_PER_SECOND);
+				if (std::fabs(bot->position.x) > radius * CHUNK_SIZE * 0.8f || std::fabs(bot->position.z) > radius * CHUNK_SIZE * 0.8f) bot->heading = -bot->heading;
+				bot->client->move(bot->position);
+				if ((tick + bot->client->id()) % 20 == 0) {
+					glm::ivec3 target = glm::ivec3(bot->position) + glm::ivec3(nearby(rng), nearby(rng), nearby(rng));
+					bot->client->setBlock(target, (BlockID)block(rng));
+				}
+			}
+			bot->client->update();
+		}
+
+		ScopedTimer tickTime;
+		net.poll(0);
+		sync.handleMessages();
+		simulation.tick();
+		sync.update((uint32_t)simulation.ticks());
+		if (tick >= streamTicks && tick < ticks) tickTimer.add(tickTime.elapsedMs());
+		if (tick == streamTicks) {
+			for (std::unique_ptr<Bot>& bot : bots) bytesAtSteady += bot->client->bytesReceived();
+		}
+	}
+
+	uint64_t bytesTotal = 0;
+	uint64_t chunks = 0;
+	size_t mismatched = 0;
+	for (std::unique_ptr<Bot>& bot : bots) {
+		bot->client->update();
+		bytesTotal += bot->client->bytesReceived();
+		chunks += bot->client->chunksReceived();
+		mismatched += countMismatches(world, bot->mirror);
+	}
+	double steadySeconds = (double)(ticks - streamTicks) / Simulation::TICKS_PER_SECOND;
+	std::cout << "  " << clientCount << " clients: server tick " << tickTimer.average() << " ms (max " << tickTimer.max() << ")"
+		<< ", first " << streamTicks << " ticks " << (bytesAtSteady / 1024.0 / clientCount) << " KiB per client"
+		<< ", then " << ((bytesTotal - bytesAtSteady) / 1024.0 / clientCount / steadySeconds) << " KiB/s per client"
+		<< ", " << (double)chunks / clientCount << " chunks each, " << mismatched << " blocks out of sync\n";
+	return mismatched;
+}
+
+static size_t benchNetSync() {
+	size_t failed = 0;
+	for (int clients : {1, 8, 32, 128}) failed += runNetSync(clients);
+	return failed;
+}
+
+// FNV-1a over every chunk's blocks, combined in a way that ignores map order
+static uint64_t hashWorld(const World& world) {
+	uint64_t total = 0;
+	for (const auto& entry : world.allChunks()) {
+		uint64_t h = 1469598103934665603ull ^ entry.key;
+		const BlockID* blocks = entry.chunk->blockData();
+		for (int i = 0; i < CHUNK_VOLUME; i++) h = (h ^ blocks[i]) * 1099511628211ull;
+		total += h;
+	}
+	return total;
+}
+
+static size_t benchWorldgen() {
+	// rolling hills, so plenty of columns are low enough for trees
+	const int mapSize = 256;
+	std::vector<unsigned char> pixels(mapSize * mapSize);
+	for (int z = 0; z < mapSize; z++) {
+		for (int x = 0; x < mapSize; x++) {
+			pixels[z * mapSize + x] = (unsigned char)(160 + 70 * std::sin(x * 0.05f) * std::cos(z * 0.04f));
+		}
+	}
+	TerrainGenerator generator(pixels.data(), mapSize, mapSize, 12345);
+	const int radius = 32;
+	glm::ivec3 min(-radius, 0, -radius);
+	glm::ivec3 max(radius - 1, 0, radius - 1);
+
+	World single;
+	Clock::time_point start = Clock::now();
+	generateArea(single, generator, min, max, 1);
+	double singleMs = millisecondsSince(start);
+
+	World parallel;
+	start = Clock::now();
+	generateArea(parallel, generator, min, max, 0);
+	double parallelMs = millisecondsSince(start);
+
+	// and once more back to front, one chunk at a time
+	World reversed;
+	for (int cz = max.z; cz >= min.z; cz--) {
+		for (int cx = max.x; cx >= min.x; cx--) generator.generate(reversed.createChunk(cx, 0, cz));
+	}
+
+	size_t count = single.chunkCount();
+	std::cout << "  " << count << " chunks, 1 thread: " << (count / singleMs * 1000.0) << " chunks/s\n";
+	std::cout << "  " << std::thread::hardware_concurrency() << " threads: " << (count / parallelMs * 1000.0) << " chunks/s\n";
+	bool same = hashWorld(single) == hashWorld(parallel) && hashWorld(single) == hashWorld(reversed);
+	std::cout << "  same blocks whatever the thread count or order: " << (same ? "yes" : "NO") << "\n";
+
+	// the cached per chunk biomes have to match a column by column lookup
+	std::array<size_t, BIOME_COUNT> share = {};
+	size_t wrong = 0;
+	for (const auto& entry : single.allChunks()) {
+		const Chunk& chunk = *entry.chunk;
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			for (int x = 0; x < CHUNK_SIZE; x++) {
+				uint8_t biome = chunk.biomeAt(x, z);
+				share[biome]++;
+				glm::ivec3 world = chunk.position * CHUNK_SIZE + glm::ivec3(x, 0, z);
+				if (generator.biomeAt(world.x, world.z) != biome) wrong++;
+			}
+		}
+	}
+	std::cout << "  biomes:";
+	for (int biome = 0; biome < BIOME_COUNT; biome++) {
+		std::cout << " " << biomeInfo(biome).name << " " << (100.0 * share[biome] / (count * CHUNK_AREA)) << "%";
+	}
+	std::cout << ", " << wrong << " columns differ from a direct lookup\n";
+	return (same ? 0 : 1) + wrong;
+}
+
+static size_t benchChunkLookup() {
+	const int radius = 32;
+	const int layers = 4;
+	World world;
+	// what World used to keep its chunks in, for comparison
+	std::unordered_map<uint64_t, std::unique_ptr<Chunk>> nodes;
+	for (int cy = 0; cy < layers; cy++) {
+		for (int cz = -radius; cz < radius; cz++) {
+			for (int cx = -radius; cx < radius; cx++) {
+				Chunk& chunk = world.createChunk(cx, cy, cz);
+				BlockID* blocks = chunk.mutableBlocks();
+				for (int i = 0; i < CHUNK_VOLUME; i++) blocks[i] = (BlockID)((i * 7 + cx * 3 + cz) % BLOCK_COUNT);
+				nodes[chunkKey(cx, cy, cz)].reset(new Chunk(chunk));
+			}
+		}
+	}
+	auto nodeBlock = [&](int x, int y, int z) -> BlockID {
+		auto it = nodes.find(chunkKey(floorDiv(x, CHUNK_SIZE), floorDiv(y, CHUNK_SIZE), floorDiv(z, CHUNK_SIZE)));
+		if (it == nodes.end()) return BLOCK_AIR;
+		return it->second->get(floorMod(x, CHUNK_SIZE), floorMod(y, CHUNK_SIZE), floorMod(z, CHUNK_SIZE));
+	};
+
+	// scattered reads, every one in a different chunk
+	std::mt19937 random(3);
+	int extent = radius * CHUNK_SIZE;
+	std::uniform_int_distribution<int> horizontal(-extent - CHUNK_SIZE, extent + CHUNK_SIZE - 1);
+	std::uniform_int_distribution<int> vertical(-CHUNK_SIZE, layers * CHUNK_SIZE + CHUNK_SIZE - 1);
+	const int reads = 2000000;
+	std::vector<glm::ivec3> points(reads);
+	for (glm::ivec3& point : points) point = glm::ivec3(horizontal(random), vertical(random), horizontal(random));
+	uint64_t sum = 0;
+	Clock::time_point start = Clock::now();
+	for (const glm::ivec3& point : points) sum += nodeBlock(point.x, point.y, point.z);
+	double nodeMs = millisecondsSince(start);
+	uint64_t check = 0;
+	start = Clock::now();
+	for (const glm::ivec3& point : points) check += world.getBlock(point.x, point.y, point.z);
+	double mapMs = millisecondsSince(start);
+	std::cout << "  scattered reads: unordered_map " << (nodeMs * 1e6 / reads) << " ns, ChunkMap "
+		<< (mapMs * 1e6 / reads) << " ns" << (sum == check ? "" : ", RESULTS DIFFER") << "\n";
+
+	// a box swept along x the way physics gathers blocks, crossing a chunk every 16
+	const int sweeps = 64;
+	sum = 0;
+	check = 0;
+	start = Clock::now();
+	for (int sweep = 0; sweep < sweeps; sweep++) {
+		for (int x = -extent; x < extent; x++) {
+			for (int y = 20; y < 24; y++) {
+				for (int z = sweep; z < sweep + 3; z++) sum += nodeBlock(x, y, z);
+			}
+		}
+	}
+	nodeMs = millisecondsSince(start);
+	start = Clock::now();
+	for (int sweep = 0; sweep < sweeps; sweep++) {
+		ConstBlockAccess blocks(world);
+		for (int x = -extent; x < extent; x++) {
+			for (int y = 20; y < 24; y++) {
+				for (int z = sweep; z < sweep + 3; z++) check += blocks.getBlock(x, y, z);
+			}
+		}
+	}
+	double accessMs = millisecondsSince(start);
+	size_t sweepReads = (size_t)sweeps * 2 * extent * 4 * 3;
+	std::cout << "  swept reads: unordered_map " << (nodeMs * 1e6 / sweepReads) << " ns, cached accessor "
+		<< (accessMs * 1e6 / sweepReads) << " ns" << (sum == check ? "" : ", RESULTS DIFFER") << "\n";
+
+	// chunks coming and going for a long time, checked against unordered_map
+	ChunkMap map;
+	std::unordered_map<uint64_t, Chunk*> reference;
+	Chunk stand(0, 0, 0);
+	Chunk* value = &stand; // only the keys matter
+	std::uniform_int_distribution<int> nearby(-40, 40);
+	size_t wrong = 0;
+	start = Clock::now();
+	for (int i = 0; i < 1000000; i++) {
+		uint64_t key = chunkKey(nearby(random), nearby(random) / 8, nearby(random));
+		if (random() % 3 == 0) {
+			if (map.erase(key) != (reference.erase(key) ? value : nullptr)) wrong++;
+		} else if (map.insert(key, value) != reference.emplace(key, value).second) {
+			wrong++;
+		}
+		if (map.find(key ^ 1) != (reference.count(key ^ 1) ? value : nullptr)) wrong++;
+	}
+	size_t iterated = 0;
+	for (const ChunkMap::Slot& slot : map) iterated += reference.count(slot.key);
+	if (iterated != reference.size() || map.size() != reference.size()) wrong++;
+	std::cout << "  1M random inserts, erases and finds in " << millisecondsSince(start) << " ms, " << map.size() << " left in "
+		<< map.capacity() << " slots, " << wrong << " disagreements with unordered_map\n";
+	return (sum == check ? 0 : 1) + wrong;
+}
+
+// the same terrain the client starts with, above a layer of caves
+static void buildTerrainWorld(World& world, int radius) {
+	const int mapSize = 256;
+	std::vector<unsigned char> pixels(mapSize * mapSize);
+	for (int z = 0; z < mapSize; z++) {
+		for (int x = 0; x < mapSize; x++) {
+			pixels[z * mapSize + x] = (unsigned char)(160 + 70 * std::sin(x * 0.05f) * std::cos(z * 0.04f));
+		}
+	}
+	TerrainGenerator generator(pixels.data(), mapSize, mapSize, 12345);
+	generateArea(world, generator, glm::ivec3(-radius, 0, -radius), glm::ivec3(radius - 1, 0, radius - 1), 0);
+	CaveCarver carver(1337u, 0.03f);
+	for (int cz = -radius; cz < radius; cz++) {
+		for (int cx = -radius; cx < radius; cx++) {
+			Chunk& chunk = world.createChunk(cx, -1, cz);
+			chunk.fill(BLOCK_STONE);
+			carver.carve(chunk);
+		}
+	}
+}
+
+static size_t benchMeshing() {
+	World world;
+	buildTerrainWorld(world, 12);
+
+	// meshed the way MeshScheduler does it: one arena, vectors out of the pool
+	ScratchArena arena;
+	VertexPool pool;
+	ChunkMeshData mesh;
+	size_t vertices = 0;
+	for (int pass = 0; pass < 3; pass++) {
+		for (int lod = 0; lod < LOD_LEVELS; lod++) {
+			uint64_t allocationsBefore = heapAllocations.load();
+			Clock::time_point start = Clock::now();
+			for (const auto& entry : world.allChunks()) {
+				mesh.vertices = pool.acquire();
+				if (lod == 0) meshChunk(world, *entry.chunk, mesh, arena);
+				else meshChunkLod(*entry.chunk, lod, mesh, arena);
+				vertices += mesh.vertices.size();
+				pool.release(std::move(mesh.vertices));
+			}
+			double ms = millisecondsSince(start);
+			double allocations = (double)(heapAllocations.load() - allocationsBefore) / world.chunkCount();
+			// the first pass warms the arena and the pool up, after that nothing should allocate
+			std::cout << "  " << (pass == 0 ? "cold" : "warm") << " lod " << lod << ": " << (world.chunkCount() / ms * 1000.0)
+				<< " chunks/s, " << allocations << " heap allocations per chunk\n";
+		}
+	}
+	std::cout << "  arena high water " << (arena.highWater() >> 10) << " KiB, " << pool.createdCount()
+		<< " vertex vectors made, new ones reserve " << pool.suggestedCapacity() << " vertices\n";
+	return 0;
+}
+
+// vertices of one slab's batch range, less the unused room at its end
+static uint32_t usedVertices(const ChunkMeshData& mesh, int texture, int slab) {
+	const BlockVertex* first = mesh.vertices.data() + mesh.slabs.start[texture][slab];
+	uint32_t count = mesh.slabs.capacity[texture][slab];
+	BlockVertex unused = BlockVertex();
+	while (count > 0 && std::memcmp(&first[count - 1], &unused, sizeof(BlockVertex)) == 0) count--;
+	return count;
+}
+
+static bool sameSlabs(const ChunkMeshData& a, const ChunkMeshData& b) {
+	for (int t = 0; t < TEXTURE_COUNT; t++) {
+		for (int slab = 0; slab < SLAB_COUNT; slab++) {
+			uint32_t count = usedVertices(a, t, slab);
+			if (count != usedVertices(b, t, slab)) return false;
+			const BlockVertex* first = a.vertices.data() + a.slabs.start[t][slab];
+			const BlockVertex* second = b.vertices.data() + b.slabs.start[t][slab];
+			if (std::memcmp(first, second, count * sizeof(BlockVertex)) != 0) return false;
+		}
+	}
+	return true;
+}
+
+static size_t benchSlabRemesh() {
+	World world;
+	const int radius = 8;
+	buildTerrainWorld(world, radius);
+	ScratchArena arena;
+	std::unordered_map<uint64_t, ChunkMeshData> meshes;
+	size_t vertices = 0;
+	size_t used = 0;
+	for (const auto& entry : world.allChunks()) {
+		ChunkMeshData& mesh = meshes[entry.key];
+		meshChunk(world, *entry.chunk, mesh, arena);
+		vertices += mesh.vertices.size();
+		if (!mesh.slabbed) continue;
+		for (int t = 0; t < TEXTURE_COUNT; t++) {
+			for (int slab = 0; slab < SLAB_COUNT; slab++) used += usedVertices(mesh, t, slab);
+		}
+	}
+	std::cout << "  " << vertices << " vertices meshed, " << (vertices - used) * 100.0 / vertices << "% of them spare room\n";
+
+	// players digging and building one block at a time, each edit remeshed on its
+	// own like the client does, once from scratch and once by patching slabs
+	WorldEditor editor(world);
+	std::mt19937 random(11);
+	std::uniform_int_distribution<int> across(-radius * CHUNK_SIZE, radius * CHUNK_SIZE - 1);
+	std::uniform_int_distribution<int> height(-CHUNK_SIZE, CHUNK_SIZE - 1);
+	std::vector<DirtyRegion> regions;
+	ChunkMeshData fresh;
+	MeshPatch patch;
+	size_t remeshes = 0;
+	size_t patched = 0;
+	size_t wrong = 0;
+	size_t fullUploaded = 0;
+	size_t patchUploaded = 0;
+	double fullMs = 0.0;
+	double patchMs = 0.0;
+	double worstPatchMs = 0.0;
+	for (int edit = 0; edit < 5000; edit++) {
+		glm::ivec3 position(across(random), height(random), across(random));
+		BlockID id = world.getBlock(position.x, position.y, position.z) == BLOCK_AIR ? BLOCK_STONE : BLOCK_AIR;
+		editor.setBlock(position, id);
+		editor.takeDirtyRegions(regions);
+		for (const DirtyRegion& region : regions) {
+			const Chunk* chunk = world.getChunk(region.chunk.x, region.chunk.y, region.chunk.z);
+			ChunkMeshData& mesh = meshes[chunkKey(region.chunk.x, region.chunk.y, region.chunk.z)];
+			Clock::time_point start = Clock::now();
+			meshChunk(world, *chunk, fresh, arena);
+			fullMs += millisecondsSince(start);
+			fullUploaded += fresh.vertices.size();
+			remeshes++;
+
+			start = Clock::now();
+			bool fits = mesh.slabbed && remeshSlabs(world, *chunk, region.slabs, mesh.slabs, patch, arena);
+			double ms = millisecondsSince(start);
+			if (!fits) {
+				mesh = fresh;
+				continue;
+			}
+			const BlockVertex* source = patch.vertices.data();
+			for (const MeshPatch::Range& range : patch.ranges) {
+				std::copy(source, source + range.count, mesh.vertices.begin() + range.start);
+				source += range.count;
+			}
+			mesh.connectivity = patch.connectivity;
+			patchMs += ms;
+			patchUploaded += patch.vertices.size();
+			worstPatchMs = std::max(worstPatchMs, ms);
+			patched++;
+			if (!sameSlabs(mesh, fresh) || mesh.connectivity != fresh.connectivity) wrong++;
+		}
+	}
+	std::cout << "  " << remeshes << " chunks remeshed after single block edits, " << (fullMs / remeshes * 1000.0)
+		<< " us each from scratch, " << fullUploaded / remeshes << " vertices to upload\n";
+	std::cout << "  " << patched * 100.0 / remeshes << "% patched in place, " << (patchMs / patched * 1000.0) << " us each, worst "
+		<< (worstPatchMs * 1000.0) << " us, " << patchUploaded / patched << " vertices to upload, " << wrong << " differ from a fresh mesh\n";
+	return wrong;
+}
+
+// One chunk handed to the meshing workers. The world's thread only touches a job
+// while it's free or done, a worker only while it's queued or being worked on.
+struct SnapshotJob {
+	enum State { FREE, QUEUED, WORKING, DONE };
+	std::atomic<int> state;
+	ChunkSnapshot snapshot;
+	ChunkMeshData mesh;
+	ChunkMeshData expected; // meshed from the world when the snapshot was taken
+};
+
+static bool sameMesh(const ChunkMeshData& a, const ChunkMeshData& b) {
+	return a.vertices.size() == b.vertices.size() && a.connectivity == b.connectivity
+		&& std::memcmp(a.vertices.data(), b.vertices.data(), a.vertices.size() * sizeof(BlockVertex)) == 0;
+}
+
+static size_t benchSnapshots() {
+	// the reclaimer goes last, the world's shared storage is retired into it
+	EpochReclaimer readers;
+	World world;
+	const int radius = 8;
+	buildTerrainWorld(world, radius);
+	std::vector<glm::ivec3> positions;
+	for (const auto& entry : world.allChunks()) positions.push_back(entry.chunk->position);
+
+	const int workerCount = 3;
+	std::vector<std::unique_ptr<SnapshotJob>> jobs;
+	for (int i = 0; i < workerCount * 4; i++) {
+		jobs.emplace_back(new SnapshotJob());
+		jobs.back()->state.store(SnapshotJob::FREE);
+	}
+	std::atomic<bool> stop(false);
+	std::atomic<size_t> meshed(0);
+	size_t failed = 0;
+	std::vector<std::thread> workers;
+	for (int w = 0; w < workerCount; w++) {
+		workers.emplace_back([&]() {
+			ScratchArena arena;
+			while (!stop.load(std::memory_order_relaxed)) {
+				bool found = false;
+				for (auto& job : jobs) {
+					int queued = SnapshotJob::QUEUED;
+					if (!job->state.compare_exchange_strong(queued, SnapshotJob::WORKING, std::memory_order_acquire)) continue;
+					meshChunk(job->snapshot.chunk(), job->snapshot.adjacent(), job->mesh, arena);
+					job->snapshot.release();
+					job->state.store(SnapshotJob::DONE, std::memory_order_release);
+					meshed++;
+					found = true;
+				}
+				if (!found) std::this_thread::yield();
+			}
+		});
+	}
+
+	// Edits on this thread the whole time the workers mesh. Every snapshot is checked
+	// against the world meshed right when it was taken, for the first run, and the
+	// second just edits and hands out snapshots as fast as it can.
+	std::mt19937 random(3);
+	std::uniform_int_distribution<int> across(-radius * CHUNK_SIZE, radius * CHUNK_SIZE - 1);
+	std::uniform_int_distribution<int> height(-CHUNK_SIZE, CHUNK_SIZE - 1);
+	std::uniform_int_distribution<size_t> pick(0, positions.size() - 1);
+	WorldEditor editor(world);
+	std::vector<glm::ivec3> dirty;
+	ScratchArena arena;
+	for (int run = 0; run < 2; run++) {
+		bool verify = run == 0;
+		size_t edits = 0;
+		size_t handedOut = 0;
+		size_t wrong = 0;
+		size_t mostRetired = 0;
+		size_t freedBefore = readers.freedCount();
+		size_t meshedBefore = meshed.load();
+		Clock::time_point start = Clock::now();
+		while (millisecondsSince(start) < 1000.0) {
+			for (int i = 0; i < 64; i++) {
+				glm::ivec3 position(across(random), height(random), across(random));
+				BlockID id = world.getBlock(position.x, position.y, position.z) == BLOCK_AIR ? BLOCK_STONE : BLOCK_AIR;
+				edits += editor.setBlock(position, id);
+			}
+			editor.takeDirtyChunks(dirty);
+			for (auto& job : jobs) {
+				int state = job->state.load(std::memory_order_acquire);
+				if (state == SnapshotJob::DONE) {
+					if (verify && !sameMesh(job->mesh, job->expected)) wrong++;
+					job->state.store(SnapshotJob::FREE, std::memory_order_relaxed);
+					state = SnapshotJob::FREE;
+				}
+				if (state != SnapshotJob::FREE) continue;
+				const glm::ivec3& position = positions[pick(random)];
+				job->snapshot.take(world, position, readers);
+				if (verify) meshChunk(world, *world.getChunk(position.x, position.y, position.z), job->expected, arena);
+				job->state.store(SnapshotJob::QUEUED, std::memory_order_release);
+				handedOut++;
+			}
+			readers.collect();
+			mostRetired = std::max(mostRetired, readers.retiredCount());
+		}
+		double ms = millisecondsSince(start);
+		std::cout << "  " << (verify ? "checked" : "unchecked") << ": " << (edits / ms) << "k edits/s while " << workerCount
+			<< " workers meshed " << ((meshed.load() - meshedBefore) / ms * 1000.0) << " snapshots/s, " << handedOut
+			<< " handed out\n";
+		std::cout << "    " << (readers.freedCount() - freedBefore) << " old copies freed after writes, at most " << mostRetired
+			<< " at once waiting on readers";
+		if (verify) std::cout << ", " << wrong << " meshes differ from the world when taken";
+		std::cout << "\n";
+		failed += wrong;
+	}
+	stop = true;
+	for (std::thread& worker : workers) worker.join();
+	return failed;
+}
+
+static size_t benchSections() {
+	// a tall world: solid rock under the terrain with caves in its top layer,
+	// and sky above, as if players had been building all the way up
+	const int mapSize = 256;
+	std::vector<unsigned char> pixels(mapSize * mapSize);
+	for (int z = 0; z < mapSize; z++) {
+		for (int x = 0; x < mapSize; x++) {
+			pixels[z * mapSize + x] = (unsigned char)(160 + 70 * std::sin(x * 0.05f) * std::cos(z * 0.04f));
+		}
+	}
+	TerrainGenerator generator(pixels.data(), mapSize, mapSize, 12345);
+	const int radius = 12;
+	const int bottom = -6;
+	const int top = 9;
+	World world;
+	generateArea(world, generator, glm::ivec3(-radius, bottom, -radius), glm::ivec3(radius - 1, top, radius - 1), 0);
+	CaveCarver carver(1337u, 0.03f);
+	for (int cz = -radius; cz < radius; cz++) {
+		for (int cx = -radius; cx < radius; cx++) {
+			for (int cy = bottom; cy <= top; cy++) {
+				if (TerrainGenerator::hasTerrain(cy)) continue;
+				Chunk& chunk = world.createChunk(cx, cy, cz);
+				if (cy > TerrainGenerator::TOP_SECTION) continue;
+				chunk.fill(BLOCK_STONE);
+				if (cy == TerrainGenerator::BOTTOM_SECTION - 1) {
+					carver.carve(chunk);
+					chunk.compact();
+				}
+			}
+		}
+	}
+
+	size_t uniform = 0;
+	size_t bytes = 0;
+	for (const auto& entry : world.allChunks()) {
+		if (entry.chunk->isUniform()) uniform++;
+		bytes += entry.chunk->memoryBytes();
+	}
+	size_t flatBytes = world.chunkCount() * (sizeof(Chunk) + CHUNK_VOLUME);
+	std::cout << "  " << world.chunkCount() << " sections, " << uniform << " uniform, " << (bytes >> 10) << " KiB of blocks, "
+		<< (flatBytes >> 10) << " KiB with 4 KiB in every section\n";
+
+	// the scheduler's pass over everything, and every section again with storage
+	// of its own so it has to go through the mesher, which must agree
+	ScratchArena arena;
+	ChunkMeshData mesh;
+	size_t meshed = 0;
+	size_t vertices = 0;
+	Clock::time_point start = Clock::now();
+	for (const auto& entry : world.allChunks()) {
+		if (!hasVisibleFaces(world, *entry.chunk)) continue;
+		meshChunk(world, *entry.chunk, mesh, arena);
+		meshed++;
+		vertices += mesh.vertices.size();
+	}
+	double skippingMs = millisecondsSince(start);
+	size_t fullVertices = 0;
+	size_t wrongConnectivity = 0;
+	double everyMs = 0.0;
+	for (const auto& entry : world.allChunks()) {
+		Chunk copy(*entry.chunk);
+		copy.mutableBlocks();
+		ChunkMeshData skipped;
+		meshChunk(world, *entry.chunk, skipped, arena);
+		start = Clock::now();
+		meshChunk(world, copy, mesh, arena);
+		everyMs += millisecondsSince(start);
+		fullVertices += mesh.vertices.size();
+		if (mesh.connectivity != skipped.connectivity) wrongConnectivity++;
+	}
+	std::cout << "  meshed " << meshed << " sections in " << skippingMs << " ms, " << everyMs << " ms meshing all of them, "
+		<< (vertices == fullVertices && wrongConnectivity == 0 ? "same" : "DIFFERENT") << " vertices and connectivity\n";
+
+	// rays dropped from the sky, most of their way is through empty sections
+	std::vector<Ray> rays;
+	std::mt19937 random(5);
+	std::uniform_real_distribution<float> across(-radius * CHUNK_SIZE * 0.9f, radius * CHUNK_SIZE * 0.9f);
+	for (int i = 0; i < 20000; i++) {
+		glm::vec3 direction(across(random) * 0.001f, -1.0f, across(random) * 0.001f);
+		rays.push_back({glm::vec3(across(random), top * CHUNK_SIZE + 8.0f, across(random)), direction, 400.0f});
+	}
+	std::vector<RayHit> hits;
+	start = Clock::now();
+	raycastBatch(world, rays, hits, 1);
+	double rayMs = millisecondsSince(start);
+	size_t landed = 0;
+	for (const RayHit& hit : hits) landed += hit.hit;
+	std::cout << "  " << rays.size() << " rays down from the sky: " << (rays.size() / rayMs / 1000.0) << " M rays/s, "
+		<< landed << " hit the ground\n";
+	return (vertices == fullVertices ? 0 : 1) + wrongConnectivity;
+}
+
+static size_t benchMemoryGovernor() {
+	// a player walking in a straight line for a long way, with a budget far smaller
+	// than everything they pass, editing the chunk under them as they go
+	const int mapSize = 128;
+	std::vector<unsigned char> pixels(mapSize * mapSize, 140);
+	TerrainGenerator generator(pixels.data(), mapSize, mapSize, 99);
+	char directory[] = "/tmp/scuffed_chunksXXXXXX";
+	if (mkdtemp(directory) == nullptr) {
+		std::cout << "  couldn't make a directory for the chunk store, skipping\n";
+		return 0;
+	}
+	const int radius = 8;
+	const int steps = 400;
+	const size_t budget = (size_t)(2 * radius + 1) * (2 * radius + 1) * 2 * (sizeof(Chunk) + CHUNK_VOLUME);
+	World world;
+	MemoryGovernor governor;
+	governor.setBudget(MEMORY_VOXELS, budget);
+	size_t saved = 0;
+	governor.setEvictor([&](const glm::ivec3& position, bool dirty) {
+		const Chunk* chunk = world.getChunk(position.x, position.y, position.z);
+		if (chunk != nullptr && dirty) {
+			if (!saveChunk(*chunk, directory)) return false;
+			saved++;
+		}
+		world.removeChunk(position.x, position.y, position.z);
+		return true;
+	});
+
+	size_t loads = 0;
+	size_t overAfterEnforce = 0;
+	Clock::time_point start = Clock::now();
+	// there and back again, so the way home comes out of the chunk store
+	for (int step = 0; step < 2 * steps; step++) {
+		int x = step < steps ? step : 2 * steps - 1 - step;
+		for (int dz = -radius; dz <= radius; dz++) {
+			for (int dx = -radius; dx <= radius; dx++) {
+				glm::ivec3 position(x + dx, 0, dz);
+				if (world.getChunk(position.x, 0, position.z) == nullptr) {
+					Chunk& chunk = world.createChunk(position.x, 0, position.z);
+					if (loadChunk(chunk, directory)) loads++;
+					else generator.generate(chunk);
+					governor.track(position, MEMORY_VOXELS, chunk.memoryBytes());
+				}
+				governor.markVisible(position);
+			}
+		}
+		if (step < steps) {
+			world.getChunk(x, 0, 0)->set(0, CHUNK_SIZE - 1, 0, BLOCK_LOG);
+			governor.markDirty(glm::ivec3(x, 0, 0));
+		}
+		governor.enforce(SIZE_MAX);
+		governor.nextFrame();
+		if (governor.stats(MEMORY_VOXELS).bytes > budget) overAfterEnforce++;
+	}
+	double ms = millisecondsSince(start);
+
+	// every edit is either still loaded or in the store
+	size_t kept = 0;
+	for (int x = 0; x < steps; x++) {
+		Chunk stored(x, 0, 0);
+		const Chunk* chunk = world.getChunk(x, 0, 0);
+		if (chunk == nullptr && loadChunk(stored, directory)) chunk = &stored;
+		if (chunk != nullptr && chunk->get(0, CHUNK_SIZE - 1, 0) == BLOCK_LOG) kept++;
+	}
+	const MemoryCategoryStats& stats = governor.stats(MEMORY_VOXELS);
+	std::cout << "  walked " << 2 * steps << " chunks in " << ms << " ms, budget " << (budget >> 10) << " KiB, peak "
+		<< (stats.peak >> 10) << " KiB, " << overAfterEnforce << " frames over budget after eviction\n";
+	std::cout << "  " << stats.evictions << " evictions, " << saved << " edited chunks saved, " << loads
+		<< " read back, " << world.chunkCount() << " loaded at the end\n";
+	std::cout << "  edits kept: " << kept << " of " << steps << "\n";
+
+	std::string command = std::string("rm -rf ") + directory;
+	if (std::system(command.c_str()) != 0) std::cout << "  couldn't clean up " << directory << "\n";
+	return overAfterEnforce + (steps - kept);
+}
+
+static size_t benchTextureLoading() {
+	// the client's block textures over and over, as if there were a few hundred
+	const char* directory = "../assets/textures/blocks/";
+	if (!std::ifstream(std::string(directory) + TEXTURE_FILES[0])) {
+		std::cout << "  run from the build directory, " << directory << " wasn't found\n";
+		return 0;
+	}
+	std::vector<std::string> paths;
+	for (int i = 0; i < 256; i++) paths.push_back(std::string(directory) + TEXTURE_FILES[i % TEXTURE_COUNT]);
+
+	size_t failed = 0;
+	for (unsigned threads : {1u, 0u}) {
+		TextureArrayData data;
+		Clock::time_point start = Clock::now();
+		bool ok = loadTextureArray(paths, BLOCK_TEXTURE_SIZE, threads, data);
+		double ms = millisecondsSince(start);
+		size_t bytes = 0;
+		for (const auto& level : data.levels) bytes += level.size();
+		std::cout << "  " << (threads == 0 ? std::thread::hardware_concurrency() : threads) << " threads: " << paths.size() << " layers in " << ms << " ms"
+			<< ", " << data.levels.size() << " mip levels, " << (bytes / 1024) << " KiB" << (ok ? "" : ", some failed") << "\n";
+		if (!ok) failed++;
+	}
+	return failed;
+}
+
+// PSNR in dB of the decoded colour against the source texels, alpha is left out since BC1 drops it.
+// opaqueOnly skips blocks with any texel that isn't fully opaque.
+static double compressionPsnr(const TextureArrayView& source, const TextureArrayData& compressed, bool opaqueOnly) {
+	double squared = 0.0;
+	size_t count = 0;
+	int size = source.size;
+	int blocks = (size + 3) / 4;
+	size_t blockBytes = textureBlockBytes(compressed.format);
+	unsigned char texels[64];
+	for (int layer = 0; layer < source.layerCount; layer++) {
+		const unsigned char* pixels = source.levels[0] + (size_t)layer * size * size * 4;
+		for (int by = 0; by < blocks; by++) {
+			for (int bx = 0; bx < blocks; bx++) {
+				size_t block = ((size_t)layer * blocks + by) * blocks + bx;
+				bool opaque = true;
+				for (int i = 0; i < 16; i++) opaque = opaque && pixels[((by * 4 + i / 4) * size + bx * 4 + i % 4) * 4 + 3] == 255;
+				if (opaqueOnly && !opaque) continue;
+				decodeBlock(compressed.format, compressed.levels[0].data() + block * blockBytes, texels);
+				for (int i = 0; i < 16; i++) {
+					const unsigned char* original = pixels + ((by * 4 + i / 4) * size + bx * 4 + i % 4) * 4;
+					for (int c = 0; c < 3; c++) {
+						double d = (double)texels[i * 4 + c] - original[c];
+						squared += d * d;
+						count++;
+					}
+				}
+			}
+		}
+	}
+	double mse = squared / count;
+	return mse == 0.0 ? 99.0 : 10.0 * std::log10(255.0 * 255.0 / mse);
+}
+
+static size_t benchTextureCompression() {
+	// smooth gradients with noise and hard edges on top, roughly what block art looks like
+	const int size = 256;
+	const int layers = 16;
+	TextureArrayData source;
+	source.format = TEXTURE_RGBA8;
+	source.size = size;
+	source.layerCount = layers;
+	source.levels.emplace_back((size_t)size * size * 4 * layers);
+	std::mt19937 random(7);
+	for (int layer = 0; layer < layers; layer++) {
+		for (int y = 0; y < size; y++) {
+			for (int x = 0; x < size; x++) {
+				unsigned char* texel = &source.levels[0][(((size_t)layer * size + y) * size + x) * 4];
+				int noise = (int)(random() % 24);
+				bool stripe = ((x / 16 + y / 16 + layer) % 3) == 0;
+				texel[0] = (unsigned char)std::min(255, x + noise);
+				texel[1] = (unsigned char)std::min(255, (stripe ? 200 : y) + noise);
+				texel[2] = (unsigned char)std::min(255, layer * 16 + noise);
+				// odd layers get cut out alpha like leaves
+				texel[3] = (layer % 2 == 1 && (x * 7 + y * 3) % 11 < 3) ? 0 : 255;
+			}
+		}
+	}
+	TextureArrayView view = source.view();
+	double megabytes = view.levelBytes[0] / (1024.0 * 1024.0);
+	const std::pair<TextureFormat, const char*> formats[] = {{TEXTURE_BC1, "BC1"}, {TEXTURE_BC3, "BC3"}, {TEXTURE_BC7, "BC7"}};
+	for (const auto& format : formats) {
+		TextureArrayData compressed;
+		Clock::time_point start = Clock::now();
+		compressTextureArray(view, format.first, 1, compressed);
+		double ms = millisecondsSince(start);
+		std::cout << "  " << format.second << ": " << (megabytes / ms * 1000.0) << " MiB/s on 1 thread, "
+			<< ((double)view.levelBytes[0] / compressed.levels[0].size()) << "x smaller, PSNR " << compressionPsnr(view, compressed, false) << " dB, "
+			<< compressionPsnr(view, compressed, true) << " dB on opaque blocks\n";
+	}
+	return 0;
+}
+
+struct Benchmark {
+	const char* name;
+	// returns how many of its checks failed, timings never fail
+	size_t (*run)();
+};
+
+static const Benchmark BENCHMARKS[] = {
+	{"cave_culling", benchCaveCulling},
+	{"raycast", benchRaycast},
+	{"entity_collision", benchEntityCollision},
+	{"entities", benchEntities},
+	{"net_sync", benchNetSync},
+	{"worldgen", benchWorldgen},
+	{"chunk_lookup", benchChunkLookup},
+	{"meshing", benchMeshing},
+	{"slab_remesh", benchSlabRemesh},
+	{"snapshots", benchSnapshots},
+	{"sections", benchSections},
+	{"memory_governor", benchMemoryGovernor},
+	{"texture_loading", benchTextureLoading},
+	{"texture_compression", benchTextureCompression},
+};
+
+int main(int argc, char** argv) {
+	size_t failed = 0;
+	for (const Benchmark& bench : BENCHMARKS) {
+		bool selected = argc < 2;
+		for (int i = 1; i < argc; i++) {
+			if (std::strcmp(argv[i], bench.name) == 0) selected = true;
+		}
+		if (!selected) continue;
+		std::cout << bench.name << "\n";
+		size_t benchFailed = bench.run();
+		if (benchFailed != 0) std::cout << "  " << benchFailed << " failed checks\n";
+		failed += benchFailed;
+	}
+	// so the checks can gate a build
+	if (failed != 0) {
+		std::cout << failed << " failed checks in all" << std::endl;
+		return 1;
+	}
+	return 0;
+}
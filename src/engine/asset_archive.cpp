@@ -0,0 +1,191 @@
+#include "asset_archive.h"
+#include "texture_compression.h"
+
+#include <cstdio>
+#include <cstring>
+#include <fcntl.h>
+#include <fstream>
+#include <iostream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+static const char ARCHIVE_MAGIC[4] = {'S', 'C', 'F', 'A'};
+static const uint32_t ARCHIVE_VERSION = 1;
+static const size_t HEADER_SIZE = 16;
+static const size_t ENTRY_SIZE = 64;
+static const size_t TEXTURE_HEADER_SIZE = 16;
+static const size_t DATA_ALIGNMENT = 64;
+
+static void writeU32(std::vector<unsigned char>& out, uint32_t value) {
+	for (int i = 0; i < 4; i++) out.push_back((unsigned char)(value >> (8 * i)));
+}
+
+static void writeU64(std::vector<unsigned char>& out, uint64_t value) {
+	for (int i = 0; i < 8; i++) out.push_back((unsigned char)(value >> (8 * i)));
+}
+
+static uint32_t readU32(const unsigned char* data) {
+	return data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+}
+
+static uint64_t readU64(const unsigned char* data) {
+	return readU32(data) | ((uint64_t)readU32(data + 4) << 32);
+}
+
+static size_t alignUp(size_t value, size_t alignment) {
+	return (value + alignment - 1) / alignment * alignment;
+}
+
+AssetArchive::AssetArchive() : mapping(nullptr), mappingSize(0) {
+}
+
+AssetArchive::~AssetArchive() {
+	close();
+}
+
+bool AssetArchive::open(const char* path) {
+	close();
+	int fd = ::open(path, O_RDONLY | O_CLOEXEC);
+	if (fd < 0) return false;
+	struct stat info;
+	if (fstat(fd, &info) != 0 || (size_t)info.st_size < HEADER_SIZE) {
+		::close(fd);
+		std::cout << path << " is too short to be an asset archive" << std::endl;
+		return false;
+	}
+	void* mapped = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping keeps the file alive, the descriptor isn't needed any more
+	::close(fd);
+	if (mapped == MAP_FAILED) {
+		std::cout << "Failed to map " << path << std::endl;
+		return false;
+	}
+	mapping = static_cast<unsigned char*>(mapped);
+	mappingSize = (size_t)info.st_size;
+
+	uint32_t count = readU32(mapping + 8);
+	if (std::memcmp(mapping, ARCHIVE_MAGIC, 4) != 0 || readU32(mapping + 4) != ARCHIVE_VERSION || count > (mappingSize - HEADER_SIZE) / ENTRY_SIZE) {
+		std::cout << path << " isn't an asset archive this version can read" << std::endl;
+		close();
+		return false;
+	}
+	for (uint32_t i = 0; i < count; i++) {
+		const unsigned char* record = mapping + HEADER_SIZE + i * ENTRY_SIZE;
+		uint64_t offset = readU64(record + 48);
+		uint64_t size = readU64(record + 56);
+		if (record[ASSET_NAME_LENGTH - 1] != '\0' || offset > mappingSize || size > mappingSize - offset) {
+			std::cout << path << " has a broken entry, ignoring the archive" << std::endl;
+			close();
+			return false;
+		}
+		table.push_back({std::string(reinterpret_cast<const char*>(record)), (AssetType)readU32(record + 40), mapping + offset, (size_t)size});
+	}
+	return true;
+}
+
+void AssetArchive::close() {
+	if (mapping != nullptr) munmap(mapping, mappingSize);
+	mapping = nullptr;
+	mappingSize = 0;
+	table.clear();
+}
+
+const AssetEntry* AssetArchive::find(const std::string& name) const {
+	// a handful of entries, a linear scan is plenty
+	for (const AssetEntry& entry : table) {
+		if (entry.name == name) return &entry;
+	}
+	return nullptr;
+}
+
+bool AssetArchive::text(const std::string& name, std::string& out) const {
+	const AssetEntry* entry = find(name);
+	if (entry == nullptr || entry->type != ASSET_TEXT) return false;
+	out.assign(reinterpret_cast<const char*>(entry->data), entry->size);
+	return true;
+}
+
+bool AssetArchive::textureArray(const std::string& name, TextureArrayView& out) const {
+	const AssetEntry* entry = find(name);
+	if (entry == nullptr || entry->type != ASSET_TEXTURE_ARRAY || entry->size < TEXTURE_HEADER_SIZE) return false;
+	out = TextureArrayView();
+	out.size = (int)readU32(entry->data);
+	out.layerCount = (int)readU32(entry->data + 4);
+	out.levelCount = (int)readU32(entry->data + 8);
+	out.format = (TextureFormat)readU32(entry->data + 12);
+	if (out.format > TEXTURE_BC7 || out.layerCount < 1 || out.levelCount < 1 || out.levelCount > MAX_TEXTURE_LEVELS || entry->size < TEXTURE_HEADER_SIZE + out.levelCount * 16) return false;
+	for (int level = 0; level < out.levelCount; level++) {
+		const unsigned char* record = entry->data + TEXTURE_HEADER_SIZE + level * 16;
+		uint64_t offset = readU64(record);
+		uint64_t size = readU64(record + 8);
+		if (offset > entry->size || size > entry->size - offset || size != textureLevelBytes(out.format, out.levelSize(level), out.layerCount)) return false;
+		out.levels[level] = entry->data + offset;
+		out.levelBytes[level] = (size_t)size;
+	}
+	return true;
+}
+
+void AssetArchiveWriter::addText(const std::string& name, const std::string& text) {
+	pending.push_back({name, ASSET_TEXT, std::vector<unsigned char>(text.begin(), text.end())});
+}
+
+void AssetArchiveWriter::addTextureArray(const std::string& name, const TextureArrayView& texture) {
+	Pending entry = {name, ASSET_TEXTURE_ARRAY, {}};
+	std::vector<unsigned char>& data = entry.data;
+	writeU32(data, (uint32_t)texture.size);
+	writeU32(data, (uint32_t)texture.layerCount);
+	writeU32(data, (uint32_t)texture.levelCount);
+	writeU32(data, texture.format);
+	size_t offset = alignUp(TEXTURE_HEADER_SIZE + texture.levelCount * 16, 16);
+	for (int level = 0; level < texture.levelCount; level++) {
+		writeU64(data, offset);
+		writeU64(data, texture.levelBytes[level]);
+		offset = alignUp(offset + texture.levelBytes[level], 16);
+	}
+	for (int level = 0; level < texture.levelCount; level++) {
+		data.resize(alignUp(data.size(), 16));
+		data.insert(data.end(), texture.levels[level], texture.levels[level] + texture.levelBytes[level]);
+	}
+	pending.push_back(std::move(entry));
+}
+
+bool AssetArchiveWriter::write(const char* path) const {
+	std::vector<unsigned char> file(ARCHIVE_MAGIC, ARCHIVE_MAGIC + 4);
+	writeU32(file, ARCHIVE_VERSION);
+	writeU32(file, (uint32_t)pending.size());
+	writeU32(file, 0);
+	size_t offset = alignUp(HEADER_SIZE + pending.size() * ENTRY_SIZE, DATA_ALIGNMENT);
+	for (const Pending& entry : pending) {
+		if (entry.name.size() >= (size_t)ASSET_NAME_LENGTH) {
+			std::cout << "Asset name " << entry.name << " is too long for the archive" << std::endl;
+			return false;
+		}
+		char name[ASSET_NAME_LENGTH] = {};
+		std::memcpy(name, entry.name.data(), entry.name.size());
+		file.insert(file.end(), name, name + ASSET_NAME_LENGTH);
+		writeU32(file, entry.type);
+		writeU32(file, 0);
+		writeU64(file, offset);
+		writeU64(file, entry.data.size());
+		offset = alignUp(offset + entry.data.size(), DATA_ALIGNMENT);
+	}
+	for (const Pending& entry : pending) {
+		file.resize(alignUp(file.size(), DATA_ALIGNMENT));
+		file.insert(file.end(), entry.data.begin(), entry.data.end());
+	}
+
+	std::string temporary = std::string(path) + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		if (!out.write(reinterpret_cast<const char*>(file.data()), file.size())) {
+			std::cout << "Failed to write " << temporary << std::endl;
+			return false;
+		}
+	}
+	if (std::rename(temporary.c_str(), path) != 0) {
+		std::cout << "Failed to replace " << path << std::endl;
+		return false;
+	}
+	return true;
+}
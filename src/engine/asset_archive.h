@@ -0,0 +1,82 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#include "asset_loader.h"
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// One file holding everything the client loads at startup, laid out so it can be
+// mapped and used in place: texture arrays already decoded and mipmapped, shader
+// sources as plain text. Made offline by scuffed_pack.
+//
+// Layout, little endian:
+//   "SCFA", u32 version, u32 entry count, u32 0
+//   entry count x {char name[40], u32 type, u32 0, u64 offset, u64 size}
+//   the entries' data, each starting on a 64 byte boundary
+// A texture array's data is u32 size, u32 layers, u32 levels, u32 TextureFormat,
+// then levels x {u64 offset from the start of the data, u64 size}, then the
+// levels themselves.
+
+enum AssetType : uint32_t {
+	ASSET_TEXT = 1,
+	ASSET_TEXTURE_ARRAY = 2,
+};
+
+const int ASSET_NAME_LENGTH = 40;
+
+struct AssetEntry {
+	std::string name;
+	AssetType type;
+	const unsigned char* data;
+	size_t size;
+};
+
+// Reads an archive through a single read-only mapping. Everything handed out
+// points into the mapping and stays valid until close().
+class AssetArchive {
+public:
+	AssetArchive();
+	~AssetArchive();
+	AssetArchive(const AssetArchive&) = delete;
+	AssetArchive& operator=(const AssetArchive&) = delete;
+
+	// false if the file is missing or isn't an archive this version can read
+	bool open(const char* path);
+	void close();
+	bool isOpen() const { return mapping != nullptr; }
+
+	// nullptr when there's no entry of that name
+	const AssetEntry* find(const std::string& name) const;
+	// false if the entry is missing or of another type
+	bool text(const std::string& name, std::string& out) const;
+	bool textureArray(const std::string& name, TextureArrayView& out) const;
+
+	size_t mappedBytes() const { return mappingSize; }
+	const std::vector<AssetEntry>& entries() const { return table; }
+
+private:
+	unsigned char* mapping;
+	size_t mappingSize;
+	std::vector<AssetEntry> table;
+};
+
+// Collects assets in memory and writes them out as an archive.
+class AssetArchiveWriter {
+public:
+	void addText(const std::string& name, const std::string& text);
+	void addTextureArray(const std::string& name, const TextureArrayView& texture);
+	// written to a temporary file first, so a failed pack never leaves half an archive
+	bool write(const char* path) const;
+
+private:
+	struct Pending {
+		std::string name;
+		AssetType type;
+		std::vector<unsigned char> data;
+	};
+	std::vector<Pending> pending;
+};
+
+#endif
@@ -0,0 +1,126 @@
+#include "asset_loader.h"
+
+#include "../../include/stb_image.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <iostream>
+#include <thread>
+
+int TextureArrayView::levelSize(int level) const {
+	return std::max(1, size >> level);
+}
+
+int TextureArrayData::levelSize(int level) const {
+	return std::max(1, size >> level);
+}
+
+TextureArrayView TextureArrayData::view() const {
+	TextureArrayView view = {};
+	view.format = format;
+	view.size = size;
+	view.layerCount = layerCount;
+	view.levelCount = (int)levels.size();
+	for (size_t level = 0; level < levels.size(); level++) {
+		view.levels[level] = levels[level].data();
+		view.levelBytes[level] = levels[level].size();
+	}
+	return view;
+}
+
+// Box filter down, nearest neighbour up. Each target pixel averages the source
+// pixels that land on it, which is at least one.
+static void resample(const unsigned char* source, int sourceWidth, int sourceHeight, unsigned char* target, int size) {
+	for (int y = 0; y < size; y++) {
+		int y0 = y * sourceHeight / size;
+		int y1 = std::max(y0 + 1, (y + 1) * sourceHeight / size);
+		for (int x = 0; x < size; x++) {
+			int x0 = x * sourceWidth / size;
+			int x1 = std::max(x0 + 1, (x + 1) * sourceWidth / size);
+			unsigned sum[4] = {0, 0, 0, 0};
+			for (int sy = y0; sy < y1; sy++) {
+				// stb hands rows over top first, GL wants the bottom row first
+				const unsigned char* row = source + (size_t)(sourceHeight - 1 - sy) * sourceWidth * 4;
+				for (int sx = x0; sx < x1; sx++) {
+					for (int c = 0; c < 4; c++) sum[c] += row[sx * 4 + c];
+				}
+			}
+			unsigned count = (unsigned)((y1 - y0) * (x1 - x0));
+			for (int c = 0; c < 4; c++) target[(y * size + x) * 4 + c] = (unsigned char)((sum[c] + count / 2) / count);
+		}
+	}
+}
+
+// 2 x 2 average, the last row or column is reused when the size is odd
+static void halve(const unsigned char* source, int sourceSize, unsigned char* target, int size) {
+	for (int y = 0; y < size; y++) {
+		int sy0 = std::min(y * 2, sourceSize - 1);
+		int sy1 = std::min(y * 2 + 1, sourceSize - 1);
+		for (int x = 0; x < size; x++) {
+			int sx0 = std::min(x * 2, sourceSize - 1);
+			int sx1 = std::min(x * 2 + 1, sourceSize - 1);
+			for (int c = 0; c < 4; c++) {
+				unsigned sum = source[(sy0 * sourceSize + sx0) * 4 + c] + source[(sy0 * sourceSize + sx1) * 4 + c]
+					+ source[(sy1 * sourceSize + sx0) * 4 + c] + source[(sy1 * sourceSize + sx1) * 4 + c];
+				target[(y * size + x) * 4 + c] = (unsigned char)((sum + 2) / 4);
+			}
+		}
+	}
+}
+
+static void fillMissing(unsigned char* target, int size) {
+	for (int i = 0; i < size * size; i++) {
+		target[i * 4 + 0] = 255;
+		target[i * 4 + 1] = 0;
+		target[i * 4 + 2] = 255;
+		target[i * 4 + 3] = 255;
+	}
+}
+
+bool loadTextureArray(const std::vector<std::string>& paths, int size, unsigned threads, TextureArrayData& out) {
+	out.format = TEXTURE_RGBA8;
+	out.size = size;
+	out.layerCount = (int)paths.size();
+	out.levels.clear();
+	for (int level = 0; level < MAX_TEXTURE_LEVELS; level++) {
+		int levelSize = out.levelSize(level);
+		out.levels.emplace_back((size_t)levelSize * levelSize * 4 * paths.size());
+		if (levelSize == 1) break;
+	}
+
+	// every layer has its own slice of each level, so the workers never share a byte
+	std::atomic<size_t> next(0);
+	std::atomic<bool> failed(false);
+	auto work = [&]() {
+		for (size_t layer = next++; layer < paths.size(); layer = next++) {
+			unsigned char* base = out.levels[0].data() + layer * size * size * 4;
+			int width, height, channels;
+			unsigned char* pixels = stbi_load(paths[layer].c_str(), &width, &height, &channels, 4);
+			if (pixels != nullptr) {
+				resample(pixels, width, height, base, size);
+				stbi_image_free(pixels);
+			} else {
+				// stb's failure reason isn't per thread, so just name the file
+				std::cout << "Failed to load texture " << paths[layer] << std::endl;
+				failed = true;
+				fillMissing(base, size);
+			}
+			for (size_t level = 1; level < out.levels.size(); level++) {
+				int sourceSize = out.levelSize((int)level - 1);
+				int targetSize = out.levelSize((int)level);
+				const unsigned char* source = out.levels[level - 1].data() + layer * sourceSize * sourceSize * 4;
+				halve(source, sourceSize, out.levels[level].data() + layer * targetSize * targetSize * 4, targetSize);
+			}
+		}
+	};
+
+	if (threads == 0) threads = std::thread::hardware_concurrency();
+	if (threads == 0) threads = 1;
+	if (threads > paths.size()) threads = (unsigned)paths.size();
+	std::vector<std::thread> workers;
+	for (unsigned i = 1; i < threads; i++) workers.emplace_back(work);
+	work();
+	for (std::thread& worker : workers) worker.join();
+	return !failed;
+}
@@ -0,0 +1,54 @@
+#ifndef ASSET_LOADER_H
+#define ASSET_LOADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// a 32768 pixel texture has 16 levels
+const int MAX_TEXTURE_LEVELS = 16;
+
+// How the texels are stored. The compressed ones are 4 x 4 blocks, see
+// texture_compression.h.
+enum TextureFormat : uint32_t {
+	TEXTURE_RGBA8 = 0,
+	TEXTURE_BC1 = 1, // opaque colour, 8 bytes a block
+	TEXTURE_BC3 = 2, // colour plus smooth alpha, 16 bytes a block
+	TEXTURE_BC7 = 3, // higher quality colour and alpha, 16 bytes a block
+};
+
+// Where the levels of a texture array live, a TextureArrayData or straight out of
+// an archive mapping. Level i holds every layer back to back.
+struct TextureArrayView {
+	TextureFormat format;
+	int size;
+	int layerCount;
+	int levelCount;
+	const unsigned char* levels[MAX_TEXTURE_LEVELS];
+	size_t levelBytes[MAX_TEXTURE_LEVELS];
+
+	int levelSize(int level) const;
+};
+
+// Every layer of a texture array with its full mip chain, ready to hand to GL one
+// level at a time.
+struct TextureArrayData {
+	TextureFormat format;
+	int size;       // width and height of level 0
+	int layerCount;
+	// levels[i] holds every layer of mip level i back to back
+	std::vector<std::vector<unsigned char>> levels;
+
+	int levelSize(int level) const;
+	TextureArrayView view() const;
+};
+
+// Decodes the images on worker threads (0 = one per core), scales each one to
+// size x size and builds its mipmaps, all on the CPU so the upload is a single
+// batch. Layers come out in the order of paths. An image that fails to load is
+// reported and left magenta, so the layers after it keep their slots. Returns
+// false if any failed.
+bool loadTextureArray(const std::vector<std::string>& paths, int size, unsigned threads, TextureArrayData& out);
+
+#endif
@@ -0,0 +1,93 @@
+#include "biome.h"
+#include "random.h"
+
+#include <vector>
+
+// climate changes over a few hundred blocks
+static const double CLIMATE_FREQUENCY = 1.0 / 256.0;
+
+static const BiomeInfo BIOMES[BIOME_COUNT] = {
+	// name, surface, filler, depth, trees, scale, offset
+	{"plains", BLOCK_GRASS, BLOCK_DIRT, 3, 1.0f / 80.0f, 0.5f, 3.0f},
+	{"forest", BLOCK_GRASS, BLOCK_DIRT, 3, 1.0f / 9.0f, 0.8f, 1.5f},
+	{"hills", BLOCK_GRASS, BLOCK_DIRT, 2, 1.0f / 31.0f, 1.0f, 0.0f},
+	{"barren", BLOCK_DIRT, BLOCK_DIRT, 4, 0.0f, 0.6f, 2.0f},
+	{"rocky", BLOCK_STONE, BLOCK_STONE, 0, 0.0f, 1.1f, 0.0f},
+};
+
+const BiomeInfo& biomeInfo(uint8_t biome) {
+	return BIOMES[biome < BIOME_COUNT ? (int)biome : (int)BIOME_PLAINS];
+}
+
+Biome biomeFor(const Climate& climate) {
+	// perlin noise mostly stays within 0.3..0.7, so the cut offs sit close to the middle
+	if (climate.temperature < 0.42f) return BIOME_ROCKY;
+	if (climate.humidity < 0.42f) return BIOME_BARREN;
+	if (climate.humidity > 0.55f) return BIOME_FOREST;
+	if (climate.temperature < 0.5f) return BIOME_HILLS;
+	return BIOME_PLAINS;
+}
+
+ClimateMap::ClimateMap(uint64_t seed)
+	: temperature((uint32_t)hashPosition(seed, glm::ivec3(0), 1)), humidity((uint32_t)hashPosition(seed, glm::ivec3(0), 2)) {
+}
+
+ColumnClimate ClimateMap::gridPoint(int gx, int gz) const {
+	double x = (double)gx * CLIMATE_STEP * CLIMATE_FREQUENCY;
+	double z = (double)gz * CLIMATE_STEP * CLIMATE_FREQUENCY;
+	ColumnClimate point;
+	point.climate.temperature = (float)temperature.octave2D_01(x, z, 2);
+	point.climate.humidity = (float)humidity.octave2D_01(x, z, 2);
+	point.biome = biomeFor(point.climate);
+	point.heightScale = biomeInfo(point.biome).heightScale;
+	point.heightOffset = biomeInfo(point.biome).heightOffset;
+	return point;
+}
+
+// bilinear blend of the four grid points around a column, fx and fz in 0..1
+static ColumnClimate blend(const ColumnClimate& a, const ColumnClimate& b, const ColumnClimate& c, const ColumnClimate& d, float fx, float fz) {
+	auto mix = [&](float va, float vb, float vc, float vd) {
+		float top = va + (vb - va) * fx;
+		float bottom = vc + (vd - vc) * fx;
+		return top + (bottom - top) * fz;
+	};
+	ColumnClimate result;
+	result.climate.temperature = mix(a.climate.temperature, b.climate.temperature, c.climate.temperature, d.climate.temperature);
+	result.climate.humidity = mix(a.climate.humidity, b.climate.humidity, c.climate.humidity, d.climate.humidity);
+	result.heightScale = mix(a.heightScale, b.heightScale, c.heightScale, d.heightScale);
+	result.heightOffset = mix(a.heightOffset, b.heightOffset, c.heightOffset, d.heightOffset);
+	result.biome = biomeFor(result.climate);
+	return result;
+}
+
+ColumnClimate ClimateMap::column(int x, int z) const {
+	int gx = floorDiv(x, CLIMATE_STEP);
+	int gz = floorDiv(z, CLIMATE_STEP);
+	float fx = (float)(x - gx * CLIMATE_STEP) / CLIMATE_STEP;
+	float fz = (float)(z - gz * CLIMATE_STEP) / CLIMATE_STEP;
+	return blend(gridPoint(gx, gz), gridPoint(gx + 1, gz), gridPoint(gx, gz + 1), gridPoint(gx + 1, gz + 1), fx, fz);
+}
+
+void ClimateMap::fillArea(int minX, int minZ, int width, int depth, ColumnClimate* out) const {
+	// sample every grid point the area touches once, then blend per column
+	int gx0 = floorDiv(minX, CLIMATE_STEP);
+	int gz0 = floorDiv(minZ, CLIMATE_STEP);
+	int gridWidth = floorDiv(minX + width - 1, CLIMATE_STEP) - gx0 + 2;
+	int gridDepth = floorDiv(minZ + depth - 1, CLIMATE_STEP) - gz0 + 2;
+	std::vector<ColumnClimate> grid(gridWidth * gridDepth);
+	for (int gz = 0; gz < gridDepth; gz++) {
+		for (int gx = 0; gx < gridWidth; gx++) grid[gz * gridWidth + gx] = gridPoint(gx0 + gx, gz0 + gz);
+	}
+
+	for (int z = 0; z < depth; z++) {
+		int gz = floorDiv(minZ + z, CLIMATE_STEP);
+		float fz = (float)(minZ + z - gz * CLIMATE_STEP) / CLIMATE_STEP;
+		const ColumnClimate* row = &grid[(gz - gz0) * gridWidth];
+		for (int x = 0; x < width; x++) {
+			int gx = floorDiv(minX + x, CLIMATE_STEP);
+			float fx = (float)(minX + x - gx * CLIMATE_STEP) / CLIMATE_STEP;
+			const ColumnClimate* corner = row + (gx - gx0);
+			out[z * width + x] = blend(corner[0], corner[1], corner[gridWidth], corner[gridWidth + 1], fx, fz);
+		}
+	}
+}
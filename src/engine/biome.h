@@ -0,0 +1,68 @@
+#ifndef BIOME_H
+#define BIOME_H
+
+#include "core.h"
+
+#include "../../include/PerlinNoise/PerlinNoise.hpp"
+
+enum Biome : uint8_t {
+	BIOME_PLAINS = 0,
+	BIOME_FOREST = 1,
+	BIOME_HILLS = 2,
+	BIOME_BARREN = 3, // hot and dry, bare dirt
+	BIOME_ROCKY = 4,  // cold, stone right up to the surface
+	BIOME_COUNT
+};
+
+// What a biome does to the ground it covers.
+struct BiomeInfo {
+	const char* name;
+	BlockID surface;
+	BlockID filler;
+	int fillerDepth;    // filler blocks under the surface before stone starts
+	float treeChance;   // per column, trees only grow on grass
+	float heightScale;  // applied to the heightmap's 0..15
+	float heightOffset;
+};
+
+const BiomeInfo& biomeInfo(uint8_t biome);
+
+// both in 0..1
+struct Climate {
+	float temperature;
+	float humidity;
+};
+
+Biome biomeFor(const Climate& climate);
+
+// Everything the generator needs to know about one column.
+struct ColumnClimate {
+	Climate climate;
+	float heightScale;
+	float heightOffset;
+	uint8_t biome;
+};
+
+// Temperature and humidity are two slow noise fields. They're only sampled every
+// CLIMATE_STEP blocks and blended in between, so filling an area costs a few
+// noise lookups per chunk instead of one per column. Height parameters are blended
+// along with the climate so biome borders slope rather than step.
+class ClimateMap {
+public:
+	explicit ClimateMap(uint64_t seed);
+
+	static const int CLIMATE_STEP = 8;
+
+	// a single column, samples its four grid points
+	ColumnClimate column(int x, int z) const;
+	// width x depth columns starting at (minX, minZ), row by row along x
+	void fillArea(int minX, int minZ, int width, int depth, ColumnClimate* out) const;
+
+private:
+	ColumnClimate gridPoint(int gx, int gz) const;
+
+	siv::PerlinNoise temperature;
+	siv::PerlinNoise humidity;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include "chunk_map.h"
+
+static const size_t INITIAL_SLOTS = 64;
+
+ChunkMap::ChunkMap() : slots(INITIAL_SLOTS, {NO_CHUNK_KEY, nullptr}), mask(INITIAL_SLOTS - 1), count(0) {
+}
+
+bool ChunkMap::insert(uint64_t key, Chunk* chunk) {
+	if ((count + 1) * 2 > slots.size()) grow();
+	size_t i = slotFor(key);
+	while (slots[i].key != NO_CHUNK_KEY) {
+		if (slots[i].key == key) return false;
+		i = (i + 1) & mask;
+	}
+	slots[i] = {key, chunk};
+	count++;
+	return true;
+}
+
+Chunk* ChunkMap::erase(uint64_t key) {
+	size_t i = slotFor(key);
+	while (slots[i].key != key) {
+		if (slots[i].key == NO_CHUNK_KEY) return nullptr;
+		i = (i + 1) & mask;
+	}
+	Chunk* chunk = slots[i].chunk;
+	count--;
+	// pull later entries of the same run back into the hole, as long as that
+	// doesn't move one in front of the slot it hashes to
+	size_t hole = i;
+	size_t next = (i + 1) & mask;
+	while (slots[next].key != NO_CHUNK_KEY) {
+		size_t home = slotFor(slots[next].key);
+		bool canMove = hole <= next ? (home <= hole || home > next) : (home <= hole && home > next);
+		if (canMove) {
+			slots[hole] = slots[next];
+			hole = next;
+		}
+		next = (next + 1) & mask;
+	}
+	slots[hole] = {NO_CHUNK_KEY, nullptr};
+	return chunk;
+}
+
+void ChunkMap::clear() {
+	for (Slot& slot : slots) slot = {NO_CHUNK_KEY, nullptr};
+	count = 0;
+}
+
+void ChunkMap::grow() {
+	std::vector<Slot> old(slots.size() * 2, {NO_CHUNK_KEY, nullptr});
+	old.swap(slots);
+	mask = slots.size() - 1;
+	for (const Slot& slot : old) {
+		if (slot.key == NO_CHUNK_KEY) continue;
+		size_t i = slotFor(slot.key);
+		while (slots[i].key != NO_CHUNK_KEY) i = (i + 1) & mask;
+		slots[i] = slot;
+	}
+}
@@ -0,0 +1,84 @@
+#ifndef CHUNK_MAP_H
+#define CHUNK_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+struct Chunk;
+
+// no packed chunk coordinate ever has the top bit set, so it marks a free slot
+const uint64_t NO_CHUNK_KEY = ~0ull;
+
+// Open addressing hash map from packed chunk coordinates (see chunkKey) to
+// chunks. One flat array of key and pointer pairs with linear probing, so a
+// lookup is one hash and usually one cache line, and adding a chunk never
+// allocates a node. Kept at most half full. Removal shifts the following
+// entries back instead of leaving tombstones, so lookups never slow down over
+// a long session of chunks coming and going. Doesn't own the chunks.
+class ChunkMap {
+public:
+	struct Slot {
+		uint64_t key;
+		Chunk* chunk;
+	};
+
+	// walks the occupied slots, in no particular order
+	class Iterator {
+	public:
+		Iterator(const Slot* slot, const Slot* end) : slot(slot), end(end) { skipFree(); }
+		const Slot& operator*() const { return *slot; }
+		const Slot* operator->() const { return slot; }
+		Iterator& operator++() {
+			++slot;
+			skipFree();
+			return *this;
+		}
+		bool operator!=(const Iterator& other) const { return slot != other.slot; }
+		bool operator==(const Iterator& other) const { return slot == other.slot; }
+
+	private:
+		void skipFree() {
+			while (slot != end && slot->key == NO_CHUNK_KEY) ++slot;
+		}
+		const Slot* slot;
+		const Slot* end;
+	};
+
+	ChunkMap();
+
+	Chunk* find(uint64_t key) const {
+		size_t i = slotFor(key);
+		while (slots[i].key != key) {
+			if (slots[i].key == NO_CHUNK_KEY) return nullptr;
+			i = (i + 1) & mask;
+		}
+		return slots[i].chunk;
+	}
+	// false if there already is a chunk under that key, the map is left alone then
+	bool insert(uint64_t key, Chunk* chunk);
+	// returns the chunk that was stored, nullptr if there was none
+	Chunk* erase(uint64_t key);
+	void clear();
+
+	size_t size() const { return count; }
+	size_t capacity() const { return slots.size(); }
+	Iterator begin() const { return Iterator(slots.data(), slots.data() + slots.size()); }
+	Iterator end() const { return Iterator(slots.data() + slots.size(), slots.data() + slots.size()); }
+
+private:
+	// murmur's finaliser, the packed coordinates have far too regular low bits on their own
+	size_t slotFor(uint64_t key) const {
+		key ^= key >> 33;
+		key *= 0xff51afd7ed558ccdull;
+		key ^= key >> 33;
+		return (size_t)key & mask;
+	}
+	void grow();
+
+	std::vector<Slot> slots;
+	size_t mask;
+	size_t count;
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include <glad/glad.h>
+
+#include "chunk_renderer.h"
+
+#include "../../include/glm/gtc/matrix_transform.hpp"
+
+#include <algorithm>
+
+// 256k vertices (6 MB) per page, roughly a few hundred terrain chunks
+static const uint32_t VERTICES_PER_PAGE = 256 * 1024;
+// how much the compactor may copy per frame
+static const uint32_t DEFRAG_VERTICES_PER_FRAME = 16 * 1024;
+
+static void setupBlockVertexAttributes() {
+	// position attribute
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(BlockVertex), (void*)0);
+	glEnableVertexAttribArray(0);
+	// texture coord attribute, z holds the texture slot
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(BlockVertex), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+}
+
+ChunkRenderer::ChunkRenderer()
+	: arena(sizeof(BlockVertex), VERTICES_PER_PAGE, setupBlockVertexAttributes), occlusionCulling(true), caveCulling(true), governor(nullptr), stats() {
+}
+
+void ChunkRenderer::upload(const Chunk& chunk, const ChunkMeshData& mesh) {
+	const glm::ivec3& p = chunk.position;
+	uint64_t key = chunkKey(p.x, p.y, p.z);
+	auto it = meshes.find(key);
+	if (it != meshes.end()) {
+		arena.release(it->second.handle);
+		meshes.erase(it);
+	}
+	// solid chunks have no faces but still block the view
+	caveCuller.setConnectivity(p, mesh.connectivity);
+	if (governor != nullptr) governor->track(p, MEMORY_GPU_MESHES, mesh.vertices.size() * sizeof(BlockVertex));
+	if (mesh.vertices.empty()) return;
+
+	ChunkMesh entry;
+	entry.position = p;
+	entry.handle = arena.allocate(mesh.vertices.data(), (uint32_t)mesh.vertices.size());
+	entry.batchStart = mesh.batchStart;
+	entry.batchCount = mesh.batchCount;
+	entry.slabbed = mesh.slabbed;
+	entry.slabs = mesh.slabs;
+	meshes[key] = entry;
+}
+
+bool ChunkRenderer::patch(const glm::ivec3& position, const MeshPatch& patch) {
+	auto it = meshes.find(chunkKey(position.x, position.y, position.z));
+	if (it == meshes.end() || !it->second.slabbed) return false;
+	const BlockVertex* vertices = patch.vertices.data();
+	for (const MeshPatch::Range& range : patch.ranges) {
+		arena.update(it->second.handle, range.start, vertices, range.count);
+		vertices += range.count;
+	}
+	caveCuller.setConnectivity(position, patch.connectivity);
+	return true;
+}
+
+void ChunkRenderer::remove(const glm::ivec3& position) {
+	uint64_t key = chunkKey(position.x, position.y, position.z);
+	auto it = meshes.find(key);
+	caveCuller.remove(position);
+	if (governor != nullptr) governor->track(position, MEMORY_GPU_MESHES, 0);
+	if (it == meshes.end()) return;
+	arena.release(it->second.handle);
+	meshes.erase(it);
+	occlusion.forget(key);
+}
+
+bool ChunkRenderer::hasMesh(const glm::ivec3& position) const {
+	return meshes.count(chunkKey(position.x, position.y, position.z)) != 0;
+}
+
+const SlabLayout* ChunkRenderer::slabLayout(const glm::ivec3& position) const {
+	auto it = meshes.find(chunkKey(position.x, position.y, position.z));
+	if (it == meshes.end() || !it->second.slabbed) return nullptr;
+	return &it->second.slabs;
+}
+
+void ChunkRenderer::draw(const Shader& shader, unsigned int blockTextures, const glm::mat4& viewProjection, const glm::vec3& cameraPos, const glm::vec3& viewDir) {
+	Frustum frustum(viewProjection);
+	occlusion.collect();
+	if (caveCulling) caveCuller.update(cameraPos, viewDir);
+	stats = RenderStats();
+	stats.meshes = meshes.size();
+
+	drawList.clear();
+	for (const auto& entry : meshes) {
+		glm::vec3 min = glm::vec3(entry.second.position * CHUNK_SIZE);
+		glm::vec3 max = min + glm::vec3((float)CHUNK_SIZE);
+		if (!frustum.containsBox(min, max)) continue;
+		stats.inFrustum++;
+		if (caveCulling && !caveCuller.isVisible(entry.second.position)) {
+			stats.caveCulled++;
+			continue;
+		}
+		// the camera's own chunk and its direct neighbours are never worth a query
+		glm::vec3 grown = glm::vec3(1.0f);
+		bool nearCamera = glm::all(glm::greaterThanEqual(cameraPos, min - grown)) && glm::all(glm::lessThanEqual(cameraPos, max + grown));
+		if (occlusionCulling && !nearCamera) {
+			occlusion.request(entry.first, min, max);
+			if (!occlusion.isVisible(entry.first)) {
+				stats.occluded++;
+				continue;
+			}
+		}
+		drawList.push_back(&entry.second);
+		if (governor != nullptr) governor->markVisible(entry.second.position);
+	}
+	stats.drawn = drawList.size();
+	// group by page so each VAO is bound once per texture
+	std::sort(drawList.begin(), drawList.end(), [this](const ChunkMesh* a, const ChunkMesh* b) {
+		return arena.get(a->handle).page < arena.get(b->handle).page;
+	});
+
+	// every slot is a layer of the one texture, batches only split for the leaves
+	glActiveTexture(GL_TEXTURE0);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, blockTextures);
+	for (int t = 0; t < TEXTURE_COUNT; t++) {
+		// We don't do culling for transparent blocks
+		if (t == TEX_LEAVES) glDisable(GL_CULL_FACE);
+		uint32_t boundPage = UINT32_MAX;
+		for (const ChunkMesh* mesh : drawList) {
+			if (mesh->batchCount[t] == 0) continue;
+			const MeshAllocation& allocation = arena.get(mesh->handle);
+			if (allocation.page != boundPage) {
+				arena.bindPage(allocation.page);
+				boundPage = allocation.page;
+			}
+			glm::mat4 model = glm::translate(glm::mat4(1.0f), glm::vec3(mesh->position * CHUNK_SIZE));
+			shader.setMat4("model", model);
+			glDrawArrays(GL_TRIANGLES, allocation.first + mesh->batchStart[t], mesh->batchCount[t]);
+		}
+		if (t == TEX_LEAVES) glEnable(GL_CULL_FACE);
+	}
+	glBindVertexArray(0);
+
+	// now that the depth buffer is full, test chunk boxes against it for next frame
+	occlusion.issue(shader);
+}
+
+void ChunkRenderer::maintain() {
+	arena.defragment(DEFRAG_VERTICES_PER_FRAME);
+}
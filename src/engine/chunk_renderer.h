@@ -0,0 +1,74 @@
+#ifndef CHUNK_RENDERER_H
+#define CHUNK_RENDERER_H
+
+#include "frustum.h"
+#include "memory_governor.h"
+#include "mesh_arena.h"
+#include "mesher.h"
+#include "occlusion.h"
+#include "visibility.h"
+
+#include "../../assets/shaders/shader.h"
+
+#include <unordered_map>
+#include <vector>
+
+struct ChunkMesh {
+	glm::ivec3 position;
+	MeshHandle handle;
+	std::array<uint32_t, TEXTURE_COUNT> batchStart;
+	std::array<uint32_t, TEXTURE_COUNT> batchCount;
+	bool slabbed;
+	SlabLayout slabs;
+};
+
+struct RenderStats {
+	size_t meshes;    // chunks with a mesh
+	size_t inFrustum; // of those, inside the view frustum
+	size_t caveCulled; // of those, unreachable through open space from the camera's chunk
+	size_t occluded;  // of those, hidden behind terrain according to the last query
+	size_t drawn;
+};
+
+// Keeps the GPU side copy of every meshed chunk and draws them.
+class ChunkRenderer {
+public:
+	ChunkRenderer();
+
+	// replaces whatever mesh the chunk had before
+	void upload(const Chunk& chunk, const ChunkMeshData& mesh);
+	// writes a remeshSlabs patch over the chunk's mesh, false if it has no slabbed mesh
+	bool patch(const glm::ivec3& position, const MeshPatch& patch);
+	void remove(const glm::ivec3& position);
+	bool hasMesh(const glm::ivec3& position) const;
+	// the layout of the chunk's mesh, nullptr unless it has one laid out by slabs
+	const SlabLayout* slabLayout(const glm::ivec3& position) const;
+
+	// blockTextures is a texture array with one layer per TextureSlot. Chunks outside
+	// the frustum or hidden by occlusion queries from earlier frames are skipped.
+	void draw(const Shader& shader, unsigned int blockTextures, const glm::mat4& viewProjection, const glm::vec3& cameraPos, const glm::vec3& viewDir);
+	void setOcclusionCulling(bool enabled) { occlusionCulling = enabled; }
+	void setCaveCulling(bool enabled, int radius) { caveCulling = enabled; caveCuller.setRadius(radius); }
+	// reports the vertex bytes of every mesh, and marks the chunks drawn each frame visible
+	void setMemoryGovernor(MemoryGovernor* governor) { this->governor = governor; }
+
+	// call once per frame, compacts the mesh arena a little at a time
+	void maintain();
+
+	MeshArenaStats arenaStats() const { return arena.stats(); }
+	size_t meshCount() const { return meshes.size(); }
+	const RenderStats& lastFrameStats() const { return stats; }
+
+private:
+	MeshArena arena;
+	std::unordered_map<uint64_t, ChunkMesh> meshes;
+	std::vector<const ChunkMesh*> drawList;
+	OcclusionCuller occlusion;
+	bool occlusionCulling;
+	CaveCuller caveCuller;
+	bool caveCulling;
+	MemoryGovernor* governor;
+	RenderStats stats;
+};
+
+#endif
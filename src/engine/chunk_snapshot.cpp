@@ -0,0 +1,86 @@
+#include "chunk_snapshot.h"
+
+EpochReclaimer::EpochReclaimer() : current(0), oldest(0), freed(0) {
+	pins.fill(0);
+	for (Unpins& slot : unpins) slot.count.store(0, std::memory_order_relaxed);
+}
+
+EpochReclaimer::~EpochReclaimer() {
+	for (const Retired& entry : retired) delete[] entry.blocks;
+}
+
+uint64_t EpochReclaimer::pin() {
+	pins[current % EPOCH_RING]++;
+	return current;
+}
+
+void EpochReclaimer::unpin(uint64_t epoch) {
+	// release: our reads of the blocks happen before whoever sees the count frees them
+	unpins[epoch % EPOCH_RING].count.fetch_add(1, std::memory_order_release);
+}
+
+void EpochReclaimer::retire(BlockID* blocks) {
+	if (oldest == current && pins[current % EPOCH_RING] == 0) {
+		// no snapshot is out, nobody can be reading it
+		delete[] blocks;
+		freed++;
+		return;
+	}
+	retired.push_back({blocks, current});
+}
+
+size_t EpochReclaimer::collect() {
+	// close the current epoch, unless that would reuse the slot of one still being read
+	if (current + 1 - oldest < EPOCH_RING) current++;
+	while (oldest < current) {
+		int slot = oldest % EPOCH_RING;
+		if (unpins[slot].count.load(std::memory_order_acquire) != pins[slot]) break;
+		pins[slot] = 0;
+		unpins[slot].count.store(0, std::memory_order_relaxed);
+		oldest++;
+	}
+
+	size_t done = 0;
+	while (done < retired.size() && retired[done].epoch < oldest) {
+		delete[] retired[done].blocks;
+		done++;
+	}
+	retired.erase(retired.begin(), retired.begin() + done);
+	freed += done;
+	return done;
+}
+
+ChunkSnapshot::ChunkSnapshot()
+	: centre(0, 0, 0), around{{{0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}, {0, 0, 0}}}, readers(nullptr), epoch(0) {
+	for (int face = 0; face < FACE_COUNT; face++) neighbours[face] = nullptr;
+}
+
+ChunkSnapshot::~ChunkSnapshot() {
+	release();
+}
+
+bool ChunkSnapshot::take(World& world, const glm::ivec3& position, EpochReclaimer& readers) {
+	release();
+	Chunk* chunk = world.getChunk(position.x, position.y, position.z);
+	if (chunk == nullptr) return false;
+	chunk->shareWith(readers, centre);
+	for (int face = 0; face < FACE_COUNT; face++) {
+		Chunk* neighbour = world.getChunk(position.x + FACE_NORMALS[face][0], position.y + FACE_NORMALS[face][1],
+			position.z + FACE_NORMALS[face][2]);
+		if (neighbour != nullptr) {
+			neighbour->shareWith(readers, around[face]);
+			neighbours[face] = &around[face];
+		} else {
+			neighbours[face] = nullptr;
+		}
+	}
+	this->readers = &readers;
+	epoch = readers.pin();
+	return true;
+}
+
+void ChunkSnapshot::release() {
+	if (readers == nullptr) return;
+	readers->unpin(epoch);
+	readers = nullptr;
+}
@@ -0,0 +1,92 @@
+#ifndef CHUNK_SNAPSHOT_H
+#define CHUNK_SNAPSHOT_H
+
+#include "mesher.h"
+
+#include <array>
+#include <atomic>
+#include <vector>
+
+// Frees chunk storage that snapshots may still be reading, once they're done.
+// Time is split into epochs, advanced by collect(). Every snapshot pins the
+// epoch it was taken in and unpins it when it's done, from whatever thread read
+// it. Storage retired in some epoch can only be read by snapshots taken in that
+// epoch or before, so it's freed once all of those have been unpinned.
+//
+// Everything but unpin() belongs to the thread that owns the world. Readers only
+// ever bump one counter, nobody takes a lock or waits for anybody else. Has to
+// outlive the chunks sharing storage through it.
+class EpochReclaimer {
+public:
+	// epochs that can have snapshots out at once, the epoch stops advancing while
+	// the oldest of them still has readers
+	static constexpr int EPOCH_RING = 8;
+
+	EpochReclaimer();
+	// frees everything retired, no snapshot may be left
+	~EpochReclaimer();
+	EpochReclaimer(const EpochReclaimer&) = delete;
+	EpochReclaimer& operator=(const EpochReclaimer&) = delete;
+
+	// one more reader in the current epoch, returns the epoch to unpin
+	uint64_t pin();
+	// any thread, once for every pin
+	void unpin(uint64_t epoch);
+	// storage no chunk reads any more, freed as soon as no snapshot can
+	void retire(BlockID* blocks);
+	// call once a frame: starts a new epoch if it can and frees what's safe to,
+	// returns how many buffers went
+	size_t collect();
+
+	uint64_t epoch() const { return current; }
+	size_t retiredCount() const { return retired.size(); }
+	size_t freedCount() const { return freed; }
+
+private:
+	struct Retired {
+		BlockID* blocks;
+		uint64_t epoch;
+	};
+	// on a cache line of its own, readers on different cores unpin different epochs
+	struct alignas(64) Unpins {
+		std::atomic<uint32_t> count;
+	};
+
+	uint64_t current;
+	uint64_t oldest; // readers of every epoch before this one are done
+	std::array<uint32_t, EPOCH_RING> pins; // of epoch e at e % EPOCH_RING
+	std::array<Unpins, EPOCH_RING> unpins;
+	std::vector<Retired> retired; // oldest first
+	size_t freed;
+};
+
+// A chunk and its six neighbours as they were when the snapshot was taken, to be
+// read on another thread while the world goes on changing. Taking one copies no
+// blocks, and holding one doesn't stop anyone writing to the world.
+class ChunkSnapshot {
+public:
+	ChunkSnapshot();
+	~ChunkSnapshot();
+	ChunkSnapshot(const ChunkSnapshot&) = delete;
+	ChunkSnapshot& operator=(const ChunkSnapshot&) = delete;
+
+	// On the world's thread. False if the chunk isn't loaded, the snapshot is
+	// empty then. Releases whatever it held before.
+	bool take(World& world, const glm::ivec3& position, EpochReclaimer& readers);
+	// On the reading thread, once done with it. Nothing it handed out may be read after.
+	void release();
+
+	bool isHeld() const { return readers != nullptr; }
+	const Chunk& chunk() const { return centre; }
+	// the neighbour across each Face, nullptr where none was loaded, laid out for meshChunk
+	const Chunk* const* adjacent() const { return neighbours; }
+
+private:
+	Chunk centre;
+	std::array<Chunk, FACE_COUNT> around;
+	const Chunk* neighbours[FACE_COUNT];
+	EpochReclaimer* readers;
+	uint64_t epoch;
+};
+
+#endif
@@ -0,0 +1,403 @@
+#include "chunk_sync.h"
+
+#include <algorithm>
+#include <cmath>
+
+ChunkSyncServer::ChunkSyncServer(World& world, WorldEditor& editor, NetServer& net)
+	: world(world), editor(editor), net(net), governor(nullptr), currentTick(0), generateBudget(0), sentCount(0), generatedCount(0) {
+	editor.recordChanges(true);
+	editor.setChunkSource([this](const glm::ivec3& position) { return sectionForEdit(position); });
+}
+
+void ChunkSyncServer::handleMessages() {
+	net.takeClosed(scratchIds);
+	for (uint32_t id : scratchIds) clients.erase(id);
+
+	net.takeAccepted(scratchIds);
+	for (uint32_t id : scratchIds) {
+		ClientView& client = clients[id];
+		client.position = glm::vec3(0.0f);
+		client.radius = 0;
+		client.centreKnown = false;
+		scratch.clear();
+		ByteWriter writer(scratch);
+		writer.beginFrame(MSG_WELCOME);
+		writer.u32(id);
+		writer.u32(currentTick);
+		writer.endFrame();
+		net.send(id, scratch.data(), scratch.size());
+	}
+
+	for (auto& entry : clients) {
+		Connection* connection = net.connection(entry.first);
+		if (connection == nullptr) continue;
+		size_t offset = 0;
+		Frame frame;
+		bool error;
+		while (nextFrame(connection->in, offset, frame, error)) {
+			handleFrame(entry.first, entry.second, frame);
+		}
+		if (error) {
+			// the client is dropped on the next call, when the close shows up
+			net.close(entry.first);
+			continue;
+		}
+		connection->consumeInput(offset);
+	}
+}
+
+static glm::ivec3 chunkOf(const glm::vec3& position) {
+	return glm::ivec3(floorDiv((int)std::floor(position.x), CHUNK_SIZE),
+		floorDiv((int)std::floor(position.y), CHUNK_SIZE),
+		floorDiv((int)std::floor(position.z), CHUNK_SIZE));
+}
+
+void ChunkSyncServer::handleFrame(uint32_t, ClientView& client, const Frame& frame) {
+	ByteReader reader(frame.payload, frame.size);
+	if (frame.type == MSG_HELLO) {
+		int radius = reader.u8();
+		if (reader.failed()) return;
+		client.radius = std::max(1, std::min(radius, MAX_VIEW_RADIUS));
+		client.centreKnown = false;
+	} else if (frame.type == MSG_MOVE) {
+		glm::vec3 position;
+		position.x = reader.f32();
+		position.y = reader.f32();
+		position.z = reader.f32();
+		if (reader.failed() || !std::isfinite(position.x) || !std::isfinite(position.y) || !std::isfinite(position.z)) return;
+		client.position = position;
+	} else if (frame.type == MSG_SET_BLOCK) {
+		glm::ivec3 position;
+		position.x = reader.i32();
+		position.y = reader.i32();
+		position.z = reader.i32();
+		BlockID id = reader.u8();
+		if (reader.failed() || id >= BLOCK_COUNT) return;
+		// only within the client's view, it has no business loading sections anywhere else
+		glm::ivec3 offset = glm::abs(glm::ivec3(floorDiv(position.x, CHUNK_SIZE), floorDiv(position.y, CHUNK_SIZE),
+			floorDiv(position.z, CHUNK_SIZE)) - chunkOf(client.position));
+		if (client.radius == 0 || glm::max(offset.x, glm::max(offset.y, offset.z)) > client.radius) return;
+		editor.setBlock(position, id);
+	}
+	// anything else isn't for us, skip it
+}
+
+Chunk* ChunkSyncServer::sectionForEdit(const glm::ivec3& position) {
+	// without a generator only what's loaded can be edited, the rest may be stored somewhere
+	if (!generator) return nullptr;
+	Chunk* chunk = generator(position.x, position.y, position.z);
+	if (chunk != nullptr) {
+		generatedCount++;
+		return chunk;
+	}
+	// open space nothing was ever built in, a blank section loses nothing
+	chunk = &world.createChunk(position.x, position.y, position.z);
+	if (governor != nullptr) governor->track(position, MEMORY_VOXELS, chunk->memoryBytes());
+	return chunk;
+}
+
+bool ChunkSyncServer::clientHolds(const glm::ivec3& position) const {
+	uint64_t key = chunkKey(position.x, position.y, position.z);
+	for (const auto& entry : clients) {
+		if (entry.second.sent.count(key) != 0) return true;
+	}
+	return false;
+}
+
+void ChunkSyncServer::update(uint32_t tick) {
+	currentTick = tick;
+	generateBudget = GENERATE_PER_TICK;
+	frameCache.clear();
+	sendDeltas(tick);
+	for (auto& entry : clients) stream(entry.first, entry.second);
+	if (governor == nullptr) return;
+	for (const auto& entry : clients) {
+		for (const auto& sent : entry.second.sent) governor->markVisible(sent.second);
+	}
+}
+
+void ChunkSyncServer::sendDeltas(uint32_t tick) {
+	editor.takeChanges(changes);
+	if (changes.empty()) return;
+
+	// group the changes by chunk, keeping their order within each chunk
+	struct Group {
+		glm::ivec3 chunk;
+		uint64_t key;
+		size_t count;
+		std::vector<uint8_t> bytes; // this chunk's part of a MSG_DELTAS payload
+	};
+	std::vector<Group> groups;
+	std::unordered_map<uint64_t, size_t> groupOf;
+	for (const BlockChange& change : changes) {
+		uint64_t key = chunkKey(change.chunk.x, change.chunk.y, change.chunk.z);
+		auto found = groupOf.find(key);
+		if (found == groupOf.end()) {
+			found = groupOf.emplace(key, groups.size()).first;
+			groups.push_back({change.chunk, key, 0, std::vector<uint8_t>()});
+		}
+		Group& group = groups[found->second];
+		group.count++;
+		if (group.count > FULL_RESEND_CHANGES) continue;
+		ByteWriter writer(group.bytes);
+		if (group.count == 1) {
+			writer.i32(change.chunk.x);
+			writer.i32(change.chunk.y);
+			writer.i32(change.chunk.z);
+			writer.u16(0); // count, patched below
+		}
+		writer.u16(change.index);
+		writer.u8(change.id);
+	}
+	for (Group& group : groups) {
+		if (group.count > FULL_RESEND_CHANGES) continue;
+		group.bytes[12] = (uint8_t)group.count;
+		group.bytes[13] = (uint8_t)(group.count >> 8);
+	}
+
+	for (auto& entry : clients) {
+		ClientView& client = entry.second;
+		scratch.clear();
+		ByteWriter writer(scratch);
+		// a busy tick can take several frames, each has to stay under MAX_FRAME_SIZE
+		// and its group count has to fit in a u16
+		size_t frameStart = 0;
+		uint16_t included = 0;
+		auto openFrame = [&]() {
+			frameStart = scratch.size();
+			writer.beginFrame(MSG_DELTAS);
+			writer.u32(tick);
+			writer.u16(0);
+			included = 0;
+		};
+		// an empty frame isn't worth sending, it's dropped
+		auto closeFrame = [&]() {
+			if (included == 0) {
+				scratch.resize(frameStart);
+				return;
+			}
+			writer.endFrame();
+			scratch[frameStart + 9] = (uint8_t)included;
+			scratch[frameStart + 10] = (uint8_t)(included >> 8);
+		};
+		openFrame();
+		for (const Group& group : groups) {
+			if (client.sent.count(group.key) == 0) {
+				// a new chunk near the client, or one it hasn't got to yet
+				glm::ivec3 offset = glm::abs(group.chunk - client.centre);
+				bool inView = client.centreKnown && offset.x <= client.radius && offset.y <= client.radius && offset.z <= client.radius;
+				if (inView) client.queue.push_back(group.chunk);
+				continue;
+			}
+			if (group.count > FULL_RESEND_CHANGES) {
+				const Chunk* chunk = world.getChunk(group.chunk.x, group.chunk.y, group.chunk.z);
+				if (chunk == nullptr) continue;
+				const std::vector<uint8_t>& frame = chunkFrame(*chunk);
+				net.send(entry.first, frame.data(), frame.size());
+				continue;
+			}
+			// the frame's length covers everything after its own 4 bytes
+			if (included == UINT16_MAX || scratch.size() - frameStart - 4 + group.bytes.size() > MAX_FRAME_SIZE) {
+				closeFrame();
+				openFrame();
+			}
+			writer.bytes(group.bytes.data(), group.bytes.size());
+			included++;
+		}
+		closeFrame();
+		if (scratch.empty()) continue;
+		net.send(entry.first, scratch.data(), scratch.size());
+	}
+}
+
+void ChunkSyncServer::refreshQueue(uint32_t id, ClientView& client) {
+	client.centre = chunkOf(client.position);
+	client.centreKnown = true;
+
+	// chunks a step past the radius stay, so walking back and forth over a border doesn't thrash
+	int keep = client.radius + 1;
+	scratch.clear();
+	ByteWriter writer(scratch);
+	for (auto it = client.sent.begin(); it != client.sent.end();) {
+		glm::ivec3 offset = glm::abs(it->second - client.centre);
+		if (offset.x > keep || offset.y > keep || offset.z > keep) {
+			writer.beginFrame(MSG_UNLOAD);
+			writer.i32(it->second.x);
+			writer.i32(it->second.y);
+			writer.i32(it->second.z);
+			writer.endFrame();
+			it = client.sent.erase(it);
+		} else {
+			++it;
+		}
+	}
+	net.send(id, scratch.data(), scratch.size());
+
+	client.queue.clear();
+	int r = client.radius;
+	for (int cy = client.centre.y - r; cy <= client.centre.y + r; cy++) {
+		for (int cz = client.centre.z - r; cz <= client.centre.z + r; cz++) {
+			for (int cx = client.centre.x - r; cx <= client.centre.x + r; cx++) {
+				if (!generator && world.getChunk(cx, cy, cz) == nullptr) continue;
+				if (client.sent.count(chunkKey(cx, cy, cz)) != 0) continue;
+				client.queue.push_back(glm::ivec3(cx, cy, cz));
+			}
+		}
+	}
+	glm::ivec3 centre = client.centre;
+	std::sort(client.queue.begin(), client.queue.end(), [&](const glm::ivec3& a, const glm::ivec3& b) {
+		glm::ivec3 da = a - centre;
+		glm::ivec3 db = b - centre;
+		return glm::dot(glm::vec3(da), glm::vec3(da)) > glm::dot(glm::vec3(db), glm::vec3(db));
+	});
+}
+
+void ChunkSyncServer::stream(uint32_t id, ClientView& client) {
+	if (client.radius == 0) return;
+	if (!client.centreKnown || chunkOf(client.position) != client.centre) refreshQueue(id, client);
+
+	int budget = CHUNKS_PER_TICK;
+	while (budget > 0 && !client.queue.empty()) {
+		Connection* connection = net.connection(id);
+		if (connection == nullptr || connection->pending() > MAX_BACKLOG) return;
+		glm::ivec3 position = client.queue.back();
+		uint64_t key = chunkKey(position.x, position.y, position.z);
+		const Chunk* chunk = world.getChunk(position.x, position.y, position.z);
+		if (chunk == nullptr && generator && client.sent.count(key) == 0) {
+			// out of generation time this tick, pick it up again next tick.
+			// empty space is quick to rule out, so only real chunks count
+			if (generateBudget == 0) return;
+			chunk = generator(position.x, position.y, position.z);
+			if (chunk != nullptr) {
+				generateBudget--;
+				generatedCount++;
+			}
+		}
+		client.queue.pop_back();
+		if (chunk == nullptr || client.sent.count(key) != 0) continue;
+		if (chunk->isEmpty()) {
+			// reads as air without being sent, edits to it still go out as deltas
+			client.sent[key] = position;
+			continue;
+		}
+		const std::vector<uint8_t>& frame = chunkFrame(*chunk);
+		net.send(id, frame.data(), frame.size());
+		client.sent[key] = position;
+		sentCount++;
+		budget--;
+	}
+}
+
+const std::vector<uint8_t>& ChunkSyncServer::chunkFrame(const Chunk& chunk) {
+	std::vector<uint8_t>& frame = frameCache[chunkKey(chunk.position.x, chunk.position.y, chunk.position.z)];
+	if (frame.empty()) {
+		ByteWriter writer(frame);
+		writer.beginFrame(MSG_CHUNK);
+		writer.i32(chunk.position.x);
+		writer.i32(chunk.position.y);
+		writer.i32(chunk.position.z);
+		writeSection(writer, chunk);
+		writer.endFrame();
+	}
+	return frame;
+}
+
+ChunkSyncClient::ChunkSyncClient(World& world)
+	: world(world), clientId(0), tick(0), chunkCount(0), changeCount(0), discardChunks(false), discarded(new Chunk(0, 0, 0)) {
+}
+
+bool ChunkSyncClient::connect(const char* address, uint16_t port, int viewRadius) {
+	if (!net.connect(address, port)) return false;
+	ByteWriter writer(outgoing);
+	writer.beginFrame(MSG_HELLO);
+	writer.u8((uint8_t)viewRadius);
+	writer.endFrame();
+	return true;
+}
+
+void ChunkSyncClient::move(const glm::vec3& position) {
+	ByteWriter writer(outgoing);
+	writer.beginFrame(MSG_MOVE);
+	writer.f32(position.x);
+	writer.f32(position.y);
+	writer.f32(position.z);
+	writer.endFrame();
+}
+
+void ChunkSyncClient::setBlock(const glm::ivec3& position, BlockID id) {
+	ByteWriter writer(outgoing);
+	writer.beginFrame(MSG_SET_BLOCK);
+	writer.i32(position.x);
+	writer.i32(position.y);
+	writer.i32(position.z);
+	writer.u8(id);
+	writer.endFrame();
+}
+
+bool ChunkSyncClient::update() {
+	if (!outgoing.empty()) {
+		net.send(outgoing.data(), outgoing.size());
+		outgoing.clear();
+	}
+	if (!net.update()) return false;
+
+	Connection& connection = net.connection();
+	size_t offset = 0;
+	Frame frame;
+	bool error;
+	while (nextFrame(connection.in, offset, frame, error)) {
+		if (!handleFrame(frame)) {
+			error = true;
+			break;
+		}
+	}
+	if (error) {
+		net.disconnect();
+		return false;
+	}
+	connection.consumeInput(offset);
+	return true;
+}
+
+bool ChunkSyncClient::handleFrame(const Frame& frame) {
+	ByteReader reader(frame.payload, frame.size);
+	if (frame.type == MSG_WELCOME) {
+		clientId = reader.u32();
+		tick = reader.u32();
+	} else if (frame.type == MSG_CHUNK) {
+		int cx = reader.i32();
+		int cy = reader.i32();
+		int cz = reader.i32();
+		if (reader.failed()) return false;
+		Chunk& chunk = discardChunks ? *discarded : world.createChunk(cx, cy, cz);
+		if (!readSection(reader, chunk)) return false;
+		chunkCount++;
+	} else if (frame.type == MSG_UNLOAD) {
+		int cx = reader.i32();
+		int cy = reader.i32();
+		int cz = reader.i32();
+		if (reader.failed()) return false;
+		world.removeChunk(cx, cy, cz);
+	} else if (frame.type == MSG_DELTAS) {
+		tick = reader.u32();
+		int groups = reader.u16();
+		for (int g = 0; g < groups && !reader.failed(); g++) {
+			int cx = reader.i32();
+			int cy = reader.i32();
+			int cz = reader.i32();
+			int count = reader.u16();
+			Chunk* chunk = world.getChunk(cx, cy, cz);
+			// empty sections aren't sent, the first edit to one is where it starts
+			if (chunk == nullptr && !discardChunks && !reader.failed()) chunk = &world.createChunk(cx, cy, cz);
+			for (int i = 0; i < count && !reader.failed(); i++) {
+				uint16_t index = reader.u16();
+				BlockID id = reader.u8();
+				if (index >= CHUNK_VOLUME || id >= BLOCK_COUNT) return false;
+				if (chunk != nullptr) chunk->set(index % CHUNK_SIZE, index / CHUNK_AREA, (index / CHUNK_SIZE) % CHUNK_SIZE, id);
+				changeCount++;
+			}
+			if (chunk != nullptr) chunk->compact();
+		}
+	}
+	return !reader.failed();
+}
@@ -0,0 +1,128 @@
+#ifndef CHUNK_SYNC_H
+#define CHUNK_SYNC_H
+
+#include "memory_governor.h"
+#include "net.h"
+#include "protocol.h"
+#include "world_edit.h"
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// Server half of keeping clients' worlds in step with ours. Each client gets the
+// chunks around it streamed nearest first, a few per tick, and from then on only
+// the blocks that change in them, batched into one delta message per tick (more
+// when a busy tick would make it too big for one frame).
+class ChunkSyncServer {
+public:
+	// new chunks sent to one client per tick
+	static const int CHUNKS_PER_TICK = 16;
+	// stop streaming to a client while this much is still waiting to go out
+	static const size_t MAX_BACKLOG = 512 * 1024;
+	// past this many changes in one tick a chunk is cheaper to resend whole
+	static const size_t FULL_RESEND_CHANGES = 512;
+	static constexpr int MAX_VIEW_RADIUS = 16;
+	// chunks generated on demand per update, across all clients
+	static const int GENERATE_PER_TICK = 32;
+
+	// makes the chunk at a position that isn't loaded yet, nullptr if there's
+	// nothing there (which should be cheap to find out). The chunk has to be
+	// added to the world.
+	typedef std::function<Chunk*(int cx, int cy, int cz)> ChunkGenerator;
+
+	// turns on change recording in editor, client edits go through it too. Edits
+	// to sections that aren't loaded get them from the generator first
+	ChunkSyncServer(World& world, WorldEditor& editor, NetServer& net);
+
+	// picks up new and dropped clients and applies what they sent
+	void handleMessages();
+	// call after the tick: sends out this tick's changes, then streams new chunks
+	void update(uint32_t tick);
+	size_t clientCount() const { return clients.size(); }
+	// without one, clients only ever see chunks that are already loaded
+	void setGenerator(ChunkGenerator generator) { this->generator = generator; }
+	// Every chunk a client holds gets marked visible on each update. It's never
+	// evicted as long as the governor's enforce() and nextFrame() only run in
+	// frames that had an update.
+	void setMemoryGovernor(MemoryGovernor* governor) { this->governor = governor; }
+	// some client was sent the chunk and still has it
+	bool clientHolds(const glm::ivec3& position) const;
+
+	uint64_t chunksSent() const { return sentCount; }
+	uint64_t chunksGenerated() const { return generatedCount; }
+
+private:
+	struct ClientView {
+		glm::vec3 position;
+		int radius; // 0 until the client said hello
+		glm::ivec3 centre;
+		bool centreKnown;
+		std::unordered_map<uint64_t, glm::ivec3> sent;
+		// chunks still to send, nearest last so they pop off the back
+		std::vector<glm::ivec3> queue;
+	};
+
+	void handleFrame(uint32_t id, ClientView& client, const Frame& frame);
+	// the editor's ChunkSource
+	Chunk* sectionForEdit(const glm::ivec3& position);
+	void sendDeltas(uint32_t tick);
+	void stream(uint32_t id, ClientView& client);
+	void refreshQueue(uint32_t id, ClientView& client);
+	// one encoded MSG_CHUNK frame per chunk per update, however many clients want it
+	const std::vector<uint8_t>& chunkFrame(const Chunk& chunk);
+
+	World& world;
+	WorldEditor& editor;
+	NetServer& net;
+	ChunkGenerator generator;
+	MemoryGovernor* governor;
+	std::unordered_map<uint32_t, ClientView> clients;
+	std::unordered_map<uint64_t, std::vector<uint8_t>> frameCache;
+	std::vector<BlockChange> changes;
+	uint32_t currentTick;
+	int generateBudget;
+	uint64_t sentCount;
+	uint64_t generatedCount;
+	std::vector<uint32_t> scratchIds;
+	std::vector<uint8_t> scratch;
+};
+
+// Client half: keeps a mirror of the chunks the server sent us.
+class ChunkSyncClient {
+public:
+	explicit ChunkSyncClient(World& world);
+
+	// decode chunks and then throw them away instead of keeping them in the world,
+	// for simulated players that only need to look like real ones to the server
+	void setDiscardChunks(bool discard) { discardChunks = discard; }
+
+	bool connect(const char* address, uint16_t port, int viewRadius);
+	bool connected() const { return net.connected(); }
+	void move(const glm::vec3& position);
+	void setBlock(const glm::ivec3& position, BlockID id);
+	// sends what we queued and applies everything that arrived, false once disconnected
+	bool update();
+
+	uint32_t id() const { return clientId; }
+	uint32_t serverTick() const { return tick; }
+	uint64_t chunksReceived() const { return chunkCount; }
+	uint64_t changesReceived() const { return changeCount; }
+	uint64_t bytesReceived() { return net.connection().bytesReceived; }
+	uint64_t bytesSent() { return net.connection().bytesSent; }
+
+private:
+	bool handleFrame(const Frame& frame);
+
+	World& world;
+	NetClient net;
+	std::vector<uint8_t> outgoing;
+	uint32_t clientId;
+	uint32_t tick;
+	uint64_t chunkCount;
+	uint64_t changeCount;
+	bool discardChunks;
+	std::unique_ptr<Chunk> discarded;
+};
+
+#endif
@@ -1 +1,68 @@
+#ifndef CORE_H
+#define CORE_H
 
+#include <cstdint>
+
+// The world is built out of columns of 16 x 16 x 16 chunklets (sections), with
+// 21 bits of chunk coordinate per axis, so a column runs a million sections up
+// and down. Sections only exist where something is, missing ones read as air.
+// Blocks inside a chunklet are indexed y*256 + z*16 + x.
+const int CHUNK_SIZE = 16;
+const int CHUNK_AREA = CHUNK_SIZE * CHUNK_SIZE;
+const int CHUNK_VOLUME = CHUNK_AREA * CHUNK_SIZE;
+
+typedef uint8_t BlockID;
+
+enum Block : BlockID {
+	BLOCK_AIR = 0,
+	BLOCK_GRASS = 1,
+	BLOCK_DIRT = 2,
+	BLOCK_STONE = 3,
+	BLOCK_LOG = 4,
+	BLOCK_LEAVES = 5,
+	BLOCK_COUNT
+};
+
+inline int blockIndex(int x, int y, int z) {
+	return y * CHUNK_AREA + z * CHUNK_SIZE + x;
+}
+
+// Chunks are split into horizontal slabs of 16 x 4 x 16 blocks for tracking what
+// an edit touched, so a small edit only has its slab remeshed, not the chunk.
+const int SLAB_HEIGHT = 4;
+const int SLAB_COUNT = CHUNK_SIZE / SLAB_HEIGHT;
+typedef uint8_t SlabMask; // bit s for slab s, the one holding y s*4 .. s*4+3
+const SlabMask ALL_SLABS = (1 << SLAB_COUNT) - 1;
+
+// the slabs holding any of the rows loY..hiY, clamped to the chunk
+inline SlabMask slabsBetween(int loY, int hiY) {
+	if (loY < 0) loY = 0;
+	if (hiY > CHUNK_SIZE - 1) hiY = CHUNK_SIZE - 1;
+	if (loY > hiY) return 0;
+	int first = loY / SLAB_HEIGHT;
+	int last = hiY / SLAB_HEIGHT;
+	return (SlabMask)(((1 << (last + 1)) - 1) & ~((1 << first) - 1));
+}
+
+// Leaves are see-through, so we still draw the faces of whatever is behind them.
+inline bool isOpaque(BlockID id) {
+	return id != BLOCK_AIR && id != BLOCK_LEAVES;
+}
+
+// Anything that isn't air stops movement, leaves included.
+inline bool isSolid(BlockID id) {
+	return id != BLOCK_AIR;
+}
+
+// Floor division so that negative world coordinates land in the right chunk.
+inline int floorDiv(int value, int divisor) {
+	int q = value / divisor;
+	if ((value % divisor != 0) && ((value < 0) != (divisor < 0))) q--;
+	return q;
+}
+
+inline int floorMod(int value, int divisor) {
+	return value - floorDiv(value, divisor) * divisor;
+}
+
+#endif
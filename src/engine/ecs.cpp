@@ -0,0 +1,100 @@
+#include "ecs.h"
+
+#include <cstdlib>
+
+int nextComponentId() {
+	static std::atomic<int> count(0);
+	int id = count++;
+	if (id >= MAX_COMPONENTS) std::abort();
+	return id;
+}
+
+EntityRegistry::EntityRegistry() : living(0) {
+	std::memset(componentSize, 0, sizeof(componentSize));
+	// archetype 0 holds entities without any components
+	archetypeFor(0);
+}
+
+Entity EntityRegistry::create() {
+	uint32_t index;
+	if (!freeIndices.empty()) {
+		index = freeIndices.back();
+		freeIndices.pop_back();
+	} else {
+		index = (uint32_t)locations.size();
+		locations.push_back({0, 0, 0, false});
+	}
+	Location& location = locations[index];
+	Entity entity = {index, location.generation};
+	Archetype& empty = *archetypes[0];
+	location.archetype = 0;
+	location.row = (uint32_t)empty.size();
+	location.alive = true;
+	empty.entities.push_back(entity);
+	living++;
+	return entity;
+}
+
+void EntityRegistry::destroy(Entity entity) {
+	if (!alive(entity)) return;
+	Location& location = locations[entity.index];
+	removeRow(location.archetype, location.row);
+	location.alive = false;
+	location.generation++;
+	freeIndices.push_back(entity.index);
+	living--;
+}
+
+bool EntityRegistry::alive(Entity entity) const {
+	if (entity.index >= locations.size()) return false;
+	const Location& location = locations[entity.index];
+	return location.alive && location.generation == entity.generation;
+}
+
+uint32_t EntityRegistry::archetypeFor(ComponentMask mask) {
+	auto found = archetypeByMask.find(mask);
+	if (found != archetypeByMask.end()) return found->second;
+	uint32_t index = (uint32_t)archetypes.size();
+	archetypes.emplace_back(new Archetype());
+	archetypes.back()->mask = mask;
+	archetypeByMask[mask] = index;
+	return index;
+}
+
+uint32_t EntityRegistry::moveEntity(Entity entity, uint32_t target) {
+	Location& location = locations[entity.index];
+	Archetype& from = *archetypes[location.archetype];
+	Archetype& to = *archetypes[target];
+	uint32_t row = (uint32_t)to.size();
+	to.entities.push_back(entity);
+	for (int id = 0; id < MAX_COMPONENTS; id++) {
+		if (!((to.mask >> id) & 1)) continue;
+		size_t size = componentSize[id];
+		to.columns[id].resize(to.columns[id].size() + size);
+		if ((from.mask >> id) & 1) {
+			std::memcpy(to.columns[id].data() + (size_t)row * size, from.columns[id].data() + (size_t)location.row * size, size);
+		}
+	}
+	removeRow(location.archetype, location.row);
+	location.archetype = target;
+	location.row = row;
+	return row;
+}
+
+void EntityRegistry::removeRow(uint32_t archetypeIndex, uint32_t row) {
+	Archetype& archetype = *archetypes[archetypeIndex];
+	uint32_t last = (uint32_t)archetype.size() - 1;
+	for (int id = 0; id < MAX_COMPONENTS; id++) {
+		if (!((archetype.mask >> id) & 1)) continue;
+		size_t size = componentSize[id];
+		std::vector<unsigned char>& column = archetype.columns[id];
+		if (row != last) std::memcpy(column.data() + (size_t)row * size, column.data() + (size_t)last * size, size);
+		column.resize(column.size() - size);
+	}
+	if (row != last) {
+		Entity moved = archetype.entities[last];
+		archetype.entities[row] = moved;
+		locations[moved.index].row = row;
+	}
+	archetype.entities.pop_back();
+}
@@ -0,0 +1,217 @@
+#ifndef ECS_H
+#define ECS_H
+
+#include "worker_pool.h"
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+// Handle to an entity. The generation goes up every time an index is reused, so a
+// stale handle never ends up looking at somebody else's components.
+struct Entity {
+	uint32_t index;
+	uint32_t generation;
+
+	bool operator==(const Entity& other) const { return index == other.index && generation == other.generation; }
+	bool operator!=(const Entity& other) const { return !(*this == other); }
+};
+
+const Entity NO_ENTITY = {UINT32_MAX, 0};
+
+typedef uint64_t ComponentMask;
+const int MAX_COMPONENTS = 64;
+
+// entities handed to one thread at a time by parallelEach
+const size_t ENTITY_BATCH = 1024;
+
+// Every component type gets a small id the first time it's used.
+int nextComponentId();
+
+template <typename T>
+int componentId() {
+	static const int id = nextComponentId();
+	return id;
+}
+
+template <typename... Ts>
+ComponentMask componentMask() {
+	ComponentMask mask = 0;
+	for (int id : {componentId<Ts>()...}) mask |= (ComponentMask)1 << id;
+	return mask;
+}
+
+// All entities with exactly the same set of components. Each component type has
+// its own tightly packed array, row i of every array belongs to entities[i].
+struct Archetype {
+	ComponentMask mask;
+	std::vector<Entity> entities;
+	// indexed by component id, left empty for components this archetype doesn't have
+	std::vector<unsigned char> columns[MAX_COMPONENTS];
+
+	size_t size() const { return entities.size(); }
+
+	template <typename T>
+	T* column() { return reinterpret_cast<T*>(columns[componentId<T>()].data()); }
+};
+
+// Owns every entity and its components. Components are plain structs that get
+// moved around with memcpy whenever an entity changes archetype.
+//
+// Creating and destroying entities or adding and removing components while
+// inside each() or parallelEach() isn't allowed, collect them and do it afterwards.
+class EntityRegistry {
+public:
+	EntityRegistry();
+
+	Entity create();
+	void destroy(Entity entity);
+	bool alive(Entity entity) const;
+	size_t size() const { return living; }
+	size_t archetypeCount() const { return archetypes.size(); }
+
+	// adds the component, or overwrites it when the entity already has one
+	template <typename T>
+	void add(Entity entity, const T& value);
+	template <typename T>
+	void remove(Entity entity);
+	template <typename T>
+	bool has(Entity entity) const;
+	// nullptr when the entity is dead or doesn't have the component
+	template <typename T>
+	T* get(Entity entity);
+
+	// calls fn(Entity, Ts&...) for every entity that has all of Ts
+	template <typename... Ts, typename Fn>
+	void each(Fn fn);
+	// same, but batches of entities are spread over threads (0 = one per core).
+	// fn runs concurrently, so it may only write to the components it was handed.
+	// The threads belong to the registry and wait for the next call in between.
+	template <typename... Ts, typename Fn>
+	void parallelEach(Fn fn, unsigned threads = 0);
+
+private:
+	struct Location {
+		uint32_t archetype;
+		uint32_t row;
+		uint32_t generation;
+		bool alive;
+	};
+
+	uint32_t archetypeFor(ComponentMask mask);
+	// moves the entity's row into another archetype, copying the components both share
+	uint32_t moveEntity(Entity entity, uint32_t target);
+	// swaps the last row into the hole so the arrays stay packed
+	void removeRow(uint32_t archetype, uint32_t row);
+	template <typename T>
+	void registerComponent();
+
+	std::vector<Location> locations;
+	std::vector<uint32_t> freeIndices;
+	std::vector<std::unique_ptr<Archetype>> archetypes;
+	std::unordered_map<ComponentMask, uint32_t> archetypeByMask;
+	size_t componentSize[MAX_COMPONENTS];
+	size_t living;
+	std::unique_ptr<WorkerPool> workers; // made by the first parallelEach that wants threads
+};
+
+template <typename T>
+void EntityRegistry::registerComponent() {
+	static_assert(std::is_trivially_copyable<T>::value, "components get moved with memcpy");
+	static_assert(alignof(T) <= alignof(std::max_align_t), "component is over-aligned");
+	componentSize[componentId<T>()] = sizeof(T);
+}
+
+template <typename T>
+void EntityRegistry::add(Entity entity, const T& value) {
+	if (!alive(entity)) return;
+	registerComponent<T>();
+	int id = componentId<T>();
+	Location& location = locations[entity.index];
+	ComponentMask mask = archetypes[location.archetype]->mask;
+	if (!(mask & ((ComponentMask)1 << id))) {
+		uint32_t target = archetypeFor(mask | ((ComponentMask)1 << id));
+		moveEntity(entity, target);
+	}
+	Archetype& archetype = *archetypes[location.archetype];
+	std::memcpy(archetype.columns[id].data() + (size_t)location.row * sizeof(T), &value, sizeof(T));
+}
+
+template <typename T>
+void EntityRegistry::remove(Entity entity) {
+	if (!has<T>(entity)) return;
+	ComponentMask mask = archetypes[locations[entity.index].archetype]->mask;
+	moveEntity(entity, archetypeFor(mask & ~((ComponentMask)1 << componentId<T>())));
+}
+
+template <typename T>
+bool EntityRegistry::has(Entity entity) const {
+	if (!alive(entity)) return false;
+	return (archetypes[locations[entity.index].archetype]->mask >> componentId<T>()) & 1;
+}
+
+template <typename T>
+T* EntityRegistry::get(Entity entity) {
+	if (!has<T>(entity)) return nullptr;
+	const Location& location = locations[entity.index];
+	return archetypes[location.archetype]->column<T>() + location.row;
+}
+
+template <typename Fn, typename... Columns>
+void runRows(const Entity* entities, size_t begin, size_t end, Fn& fn, Columns... columns) {
+	for (size_t i = begin; i < end; i++) fn(entities[i], columns[i]...);
+}
+
+template <typename... Ts, typename Fn>
+void EntityRegistry::each(Fn fn) {
+	ComponentMask wanted = componentMask<Ts...>();
+	for (const std::unique_ptr<Archetype>& archetype : archetypes) {
+		if ((archetype->mask & wanted) != wanted || archetype->size() == 0) continue;
+		runRows(archetype->entities.data(), 0, archetype->size(), fn, archetype->column<Ts>()...);
+	}
+}
+
+template <typename... Ts, typename Fn>
+void EntityRegistry::parallelEach(Fn fn, unsigned threads) {
+	struct Batch {
+		Archetype* archetype;
+		size_t begin;
+		size_t end;
+	};
+	ComponentMask wanted = componentMask<Ts...>();
+	std::vector<Batch> batches;
+	for (const std::unique_ptr<Archetype>& archetype : archetypes) {
+		if ((archetype->mask & wanted) != wanted) continue;
+		for (size_t begin = 0; begin < archetype->size(); begin += ENTITY_BATCH) {
+			size_t end = begin + ENTITY_BATCH < archetype->size() ? begin + ENTITY_BATCH : archetype->size();
+			batches.push_back({archetype.get(), begin, end});
+		}
+	}
+
+	if (threads == 0) threads = std::thread::hardware_concurrency();
+	if (threads == 0) threads = 1;
+	if (threads > batches.size()) threads = (unsigned)batches.size();
+
+	// threads grab the next batch as they finish, so uneven work evens out
+	std::atomic<size_t> next(0);
+	auto work = [&]() {
+		for (size_t i = next++; i < batches.size(); i = next++) {
+			Archetype& archetype = *batches[i].archetype;
+			runRows(archetype.entities.data(), batches[i].begin, batches[i].end, fn, archetype.column<Ts>()...);
+		}
+	};
+	if (threads <= 1) {
+		work();
+		return;
+	}
+	if (!workers) workers.reset(new WorkerPool());
+	workers->run(work, threads - 1);
+}
+
+#endif
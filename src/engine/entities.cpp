@@ -0,0 +1,83 @@
+#include "entities.h"
+
+#include <cmath>
+
+// xorshift, small enough to live inside a component
+static uint32_t nextRandom(uint32_t& state) {
+	state ^= state << 13;
+	state ^= state >> 17;
+	state ^= state << 5;
+	return state;
+}
+
+Entity spawnItem(EntityRegistry& entities, const glm::vec3& position, BlockID id) {
+	Entity entity = entities.create();
+	PhysicsBody body;
+	body.position = position;
+	// a little hop so it doesn't just appear on the floor
+	body.velocity = glm::vec3(0.0f, 4.0f, 0.0f);
+	body.halfExtents = glm::vec3(0.125f, 0.25f, 0.125f);
+	body.onGround = false;
+	body.gravity = true;
+	entities.add(entity, body);
+	entities.add(entity, ItemDrop{id, 0});
+	return entity;
+}
+
+Entity spawnMob(EntityRegistry& entities, const glm::vec3& position, uint32_t seed) {
+	Entity entity = entities.create();
+	PhysicsBody body;
+	body.position = position;
+	body.velocity = glm::vec3(0.0f);
+	body.halfExtents = glm::vec3(0.45f, 1.4f, 0.45f);
+	body.onGround = false;
+	body.gravity = true;
+	entities.add(entity, body);
+	// xorshift gets stuck on zero
+	entities.add(entity, Wanderer{seed != 0 ? seed : 1u, 0, 2.0f, glm::vec2(0.0f)});
+	return entity;
+}
+
+void steerWanderers(EntityRegistry& entities, unsigned threads) {
+	entities.parallelEach<PhysicsBody, Wanderer>([](Entity, PhysicsBody& body, Wanderer& wanderer) {
+		// the last step zeroed our velocity, so something's in the way. try hopping over it
+		bool walking = wanderer.heading != glm::vec2(0.0f);
+		bool stuck = walking && body.velocity.x == 0.0f && body.velocity.z == 0.0f;
+		if (stuck && body.onGround) body.velocity.y = 8.5f;
+
+		if (wanderer.ticksLeft == 0) {
+			uint32_t roll = nextRandom(wanderer.seed);
+			// stand around about a quarter of the time
+			if (roll % 4 == 0) {
+				wanderer.heading = glm::vec2(0.0f);
+			} else {
+				float yaw = (roll >> 8) * (6.2831853f / 16777216.0f);
+				wanderer.heading = glm::vec2(std::cos(yaw), std::sin(yaw));
+			}
+			wanderer.ticksLeft = 20 + nextRandom(wanderer.seed) % 80;
+		}
+		wanderer.ticksLeft--;
+		body.velocity.x = wanderer.heading.x * wanderer.speed;
+		body.velocity.z = wanderer.heading.y * wanderer.speed;
+	}, threads);
+}
+
+void stepBodies(EntityRegistry& entities, const World& world, float seconds, unsigned threads) {
+	entities.parallelEach<PhysicsBody>([&](Entity, PhysicsBody& body) {
+		stepBody(world, body, seconds);
+	}, threads);
+}
+
+void ageItems(EntityRegistry& entities, std::vector<Entity>& expired) {
+	entities.each<ItemDrop>([&](Entity entity, ItemDrop& item) {
+		item.age++;
+		if (item.age >= ITEM_LIFETIME) expired.push_back(entity);
+	});
+}
+
+void buildSpatialHash(EntityRegistry& entities, SpatialHash& hash) {
+	hash.clear();
+	entities.each<PhysicsBody>([&](Entity entity, PhysicsBody& body) {
+		hash.insert(entity, body.position);
+	});
+}
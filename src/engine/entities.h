@@ -0,0 +1,36 @@
+#ifndef ENTITIES_H
+#define ENTITIES_H
+
+#include "ecs.h"
+#include "physics.h"
+#include "spatial_hash.h"
+
+// A block lying on the ground waiting to be picked up.
+struct ItemDrop {
+	BlockID id;
+	uint32_t age; // in ticks
+};
+
+// A mob that walks in a straight line for a while, then picks a new direction.
+// Carries its own random state so wanderers can be steered from several threads.
+struct Wanderer {
+	uint32_t seed;
+	uint32_t ticksLeft;
+	float speed;
+	glm::vec2 heading; // x and z, zero while standing still
+};
+
+const uint32_t ITEM_LIFETIME = 20 * 60 * 5; // ticks
+const float ITEM_PICKUP_RADIUS = 1.5f;
+
+Entity spawnItem(EntityRegistry& entities, const glm::vec3& position, BlockID id);
+Entity spawnMob(EntityRegistry& entities, const glm::vec3& position, uint32_t seed);
+
+// the systems, run once per tick in this order. threads as for parallelEach.
+void steerWanderers(EntityRegistry& entities, unsigned threads);
+void stepBodies(EntityRegistry& entities, const World& world, float seconds, unsigned threads);
+// items that have been around for too long end up in expired
+void ageItems(EntityRegistry& entities, std::vector<Entity>& expired);
+void buildSpatialHash(EntityRegistry& entities, SpatialHash& hash);
+
+#endif
@@ -0,0 +1,33 @@
+#ifndef FRUSTUM_H
+#define FRUSTUM_H
+
+#include "../../include/glm/glm.hpp"
+
+// The six planes of a view frustum, pulled out of a projection * view matrix
+// (Gribb & Hartmann). Plane normals point inwards.
+struct Frustum {
+	glm::vec4 planes[6];
+
+	explicit Frustum(const glm::mat4& viewProjection) {
+		glm::mat4 m = glm::transpose(viewProjection);
+		planes[0] = m[3] + m[0]; // left
+		planes[1] = m[3] - m[0]; // right
+		planes[2] = m[3] + m[1]; // bottom
+		planes[3] = m[3] - m[1]; // top
+		planes[4] = m[3] + m[2]; // near
+		planes[5] = m[3] - m[2]; // far
+	}
+
+	// true unless the box is fully outside one of the planes
+	bool containsBox(const glm::vec3& min, const glm::vec3& max) const {
+		for (int i = 0; i < 6; i++) {
+			const glm::vec4& p = planes[i];
+			// corner of the box furthest along the plane normal
+			glm::vec3 corner(p.x > 0 ? max.x : min.x, p.y > 0 ? max.y : min.y, p.z > 0 ? max.z : min.z);
+			if (p.x * corner.x + p.y * corner.y + p.z * corner.z + p.w < 0) return false;
+		}
+		return true;
+	}
+};
+
+#endif
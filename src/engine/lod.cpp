@@ -0,0 +1,91 @@
+#include "lod.h"
+#include "visibility.h"
+
+#include <algorithm>
+
+int chooseLod(float distance, int current, const LodSettings& settings) {
+	int lod = 0;
+	while (lod < LOD_LEVELS - 1 && distance > settings.distances[lod]) lod++;
+	if (current < 0 || lod == current) return lod;
+
+	if (lod > current) {
+		// getting coarser, we must be clearly past the far edge of our current level
+		if (distance <= settings.distances[current] + settings.hysteresis) return current;
+	} else {
+		// getting finer, we must be clearly inside the near edge of our current level
+		if (distance >= settings.distances[current - 1] - settings.hysteresis) return current;
+	}
+	return lod;
+}
+
+void downsampleChunk(const Chunk& chunk, int scale, BlockID* out) {
+	int size = CHUNK_SIZE / scale;
+	std::fill(out, out + size * size * size, (BlockID)BLOCK_AIR);
+	int half = (scale * scale * scale) / 2;
+
+	for (int cy = 0; cy < size; cy++) {
+		for (int cz = 0; cz < size; cz++) {
+			for (int cx = 0; cx < size; cx++) {
+				int filled = 0;
+				int topLayer = -1;
+				int counts[BLOCK_COUNT] = {0};
+				for (int y = scale - 1; y >= 0; y--) {
+					for (int z = 0; z < scale; z++) {
+						for (int x = 0; x < scale; x++) {
+							BlockID id = chunk.get(cx * scale + x, cy * scale + y, cz * scale + z);
+							if (id == BLOCK_AIR) continue;
+							filled++;
+							if (topLayer < 0) topLayer = y;
+							if (y == topLayer && id < BLOCK_COUNT) counts[id]++;
+						}
+					}
+				}
+				if (filled == 0 || filled < half) continue;
+
+				BlockID best = BLOCK_STONE;
+				for (int id = 1; id < BLOCK_COUNT; id++) {
+					if (counts[id] > counts[best]) best = (BlockID)id;
+				}
+				out[(cy * size + cz) * size + cx] = best;
+			}
+		}
+	}
+}
+
+void meshChunkLod(const Chunk& chunk, int lod, ChunkMeshData& out, ScratchArena& arena) {
+	if (chunk.isEmpty()) {
+		emptyMesh(chunk, out);
+		return;
+	}
+	arena.reset();
+	int scale = lodScale(lod);
+	int size = CHUNK_SIZE / scale;
+	BlockID* cells = arena.allocate<BlockID>(size * size * size);
+	uint8_t* faces = arena.allocate<uint8_t>(size * size * size);
+	downsampleChunk(chunk, scale, cells);
+
+	for (int y = 0; y < size; y++) {
+		for (int z = 0; z < size; z++) {
+			for (int x = 0; x < size; x++) {
+				BlockID id = cells[(y * size + z) * size + x];
+				uint8_t mask = 0;
+				if (id != BLOCK_AIR) {
+					for (int face = 0; face < FACE_COUNT; face++) {
+						int nx = x + FACE_NORMALS[face][0];
+						int ny = y + FACE_NORMALS[face][1];
+						int nz = z + FACE_NORMALS[face][2];
+						// outside the chunk always counts as open, that's what gives us the skirts
+						if (nx >= 0 && nx < size && ny >= 0 && ny < size && nz >= 0 && nz < size) {
+							if (id != BLOCK_LEAVES && isOpaque(cells[(ny * size + nz) * size + nx])) continue;
+						}
+						mask |= 1 << face;
+					}
+				}
+				faces[(y * size + z) * size + x] = mask;
+			}
+		}
+	}
+
+	buildBatches(cells, faces, size, scale, out);
+	out.connectivity = computeFaceConnectivity(chunk, arena);
+}
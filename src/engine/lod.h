@@ -0,0 +1,38 @@
+#ifndef LOD_H
+#define LOD_H
+
+#include "mesher.h"
+
+// LOD 0 is full detail, every level after that halves the resolution: 1x, 2x, 4x, 8x.
+const int LOD_LEVELS = 4;
+
+inline int lodScale(int lod) {
+	return 1 << lod;
+}
+
+struct LodSettings {
+	// distance (in chunks, horizontal) past which level i+1 takes over from level i
+	float distances[LOD_LEVELS - 1];
+	// how far past a boundary the camera has to move before a chunk switches level,
+	// stops chunks on the boundary from flickering between two meshes
+	float hysteresis;
+};
+
+const LodSettings DEFAULT_LOD_SETTINGS = {{6.0f, 12.0f, 20.0f}, 1.0f};
+
+// Level of detail for a chunk at the given distance. current is the level the
+// chunk already has, or -1 if it has none yet.
+int chooseLod(float distance, int current, const LodSettings& settings);
+
+// Shrinks a chunk by scale on every axis. A cell becomes solid once at least half
+// of it is filled, and takes the most common block of its highest filled layer so
+// grass stays on top. out has room for (CHUNK_SIZE / scale)^3 cells.
+void downsampleChunk(const Chunk& chunk, int scale, BlockID* out);
+
+// Meshes a chunk at a reduced level of detail. Faces on the chunk border are never
+// culled, so every border column gets a full wall hanging under its surface.
+// Those walls act as skirts and hide the cracks between neighbours at different levels.
+// Memory is handled the same way as for meshChunk.
+void meshChunkLod(const Chunk& chunk, int lod, ChunkMeshData& out, ScratchArena& arena);
+
+#endif
@@ -0,0 +1,119 @@
+#include "memory_governor.h"
+
+const char* memoryCategoryName(MemoryCategory category) {
+	switch (category) {
+	case MEMORY_VOXELS: return "voxels";
+	case MEMORY_GPU_MESHES: return "gpu meshes";
+	default: return "?";
+	}
+}
+
+MemoryGovernor::MemoryGovernor() : totals(), frame(1) {
+}
+
+void MemoryGovernor::setBudget(MemoryCategory category, size_t bytes) {
+	totals[category].budget = bytes;
+}
+
+MemoryGovernor::EntryRef MemoryGovernor::entryFor(const glm::ivec3& position) {
+	uint64_t key = chunkKey(position.x, position.y, position.z);
+	auto it = index.find(key);
+	if (it != index.end()) return it->second;
+	Entry entry = {position, {}, frame, false, false};
+	recency.push_front(entry);
+	index[key] = recency.begin();
+	return recency.begin();
+}
+
+void MemoryGovernor::addBytes(MemoryCategory category, size_t bytes) {
+	MemoryCategoryStats& total = totals[category];
+	total.bytes += bytes;
+	if (total.bytes > total.peak) total.peak = total.bytes;
+}
+
+void MemoryGovernor::track(const glm::ivec3& position, MemoryCategory category, size_t bytes) {
+	// a chunk that's being evicted drops its meshes on the way out, nothing to count
+	if (bytes == 0 && index.count(chunkKey(position.x, position.y, position.z)) == 0) return;
+	Entry& entry = *entryFor(position);
+	totals[category].bytes -= entry.bytes[category];
+	entry.bytes[category] = bytes;
+	addBytes(category, bytes);
+}
+
+void MemoryGovernor::forget(const glm::ivec3& position) {
+	auto it = index.find(chunkKey(position.x, position.y, position.z));
+	if (it == index.end()) return;
+	for (int c = 0; c < MEMORY_CATEGORY_COUNT; c++) totals[c].bytes -= it->second->bytes[c];
+	recency.erase(it->second);
+	index.erase(it);
+}
+
+void MemoryGovernor::markVisible(const glm::ivec3& position) {
+	auto it = index.find(chunkKey(position.x, position.y, position.z));
+	if (it == index.end()) return;
+	it->second->lastVisible = frame;
+	recency.splice(recency.begin(), recency, it->second);
+}
+
+void MemoryGovernor::markDirty(const glm::ivec3& position) {
+	auto it = index.find(chunkKey(position.x, position.y, position.z));
+	if (it != index.end()) it->second->dirty = true;
+}
+
+void MemoryGovernor::setPinned(const glm::ivec3& position, bool pinned) {
+	auto it = index.find(chunkKey(position.x, position.y, position.z));
+	if (it != index.end()) it->second->pinned = pinned;
+}
+
+bool MemoryGovernor::overBudget(MemoryCategory category) const {
+	return totals[category].budget != 0 && totals[category].bytes > totals[category].budget;
+}
+
+bool MemoryGovernor::worthEvicting(const Entry& entry) const {
+	for (int c = 0; c < MEMORY_CATEGORY_COUNT; c++) {
+		if (entry.bytes[c] != 0 && overBudget((MemoryCategory)c)) return true;
+	}
+	return false;
+}
+
+size_t MemoryGovernor::enforce(size_t maxEvictions) {
+	if (!evictor) return 0;
+	// pick the victims and take them off the books first, so the evictor is free
+	// to call back in while it tears the chunks down
+	victims.clear();
+	auto it = recency.end();
+	while (victims.size() < maxEvictions && it != recency.begin()) {
+		--it;
+		// everything from here to the front was seen this frame
+		if (it->lastVisible == frame) break;
+		bool anyOver = false;
+		for (int c = 0; c < MEMORY_CATEGORY_COUNT; c++) anyOver = anyOver || overBudget((MemoryCategory)c);
+		if (!anyOver) break;
+		if (it->pinned || !worthEvicting(*it)) continue;
+		victims.push_back(*it);
+		for (int c = 0; c < MEMORY_CATEGORY_COUNT; c++) totals[c].bytes -= it->bytes[c];
+		index.erase(chunkKey(it->position.x, it->position.y, it->position.z));
+		it = recency.erase(it);
+	}
+
+	size_t evicted = 0;
+	for (const Entry& victim : victims) {
+		if (evictor(victim.position, victim.dirty)) {
+			for (int c = 0; c < MEMORY_CATEGORY_COUNT; c++) {
+				if (victim.bytes[c] != 0) totals[c].evictions++;
+			}
+			evicted++;
+			continue;
+		}
+		// couldn't be saved, back in at the front so it isn't retried straight away
+		EntryRef entry = entryFor(victim.position);
+		for (int c = 0; c < MEMORY_CATEGORY_COUNT; c++) {
+			totals[c].bytes -= entry->bytes[c];
+			entry->bytes[c] = victim.bytes[c];
+			addBytes((MemoryCategory)c, victim.bytes[c]);
+		}
+		entry->dirty = victim.dirty;
+		entry->pinned = victim.pinned;
+	}
+	return evicted;
+}
@@ -0,0 +1,88 @@
+#ifndef MEMORY_GOVERNOR_H
+#define MEMORY_GOVERNOR_H
+
+#include "world.h"
+
+#include <functional>
+#include <list>
+#include <unordered_map>
+#include <vector>
+
+// What chunk memory gets spent on. Every category has its own budget.
+enum MemoryCategory {
+	MEMORY_VOXELS,     // block and biome storage of loaded chunks
+	MEMORY_GPU_MESHES, // vertex data uploaded for drawing
+	MEMORY_CATEGORY_COUNT
+};
+
+const char* memoryCategoryName(MemoryCategory category);
+
+struct MemoryCategoryStats {
+	size_t bytes;
+	size_t peak;
+	size_t budget; // 0 = no limit
+	uint64_t evictions; // chunks dropped while holding bytes in this category
+};
+
+// Keeps what loaded chunks hold within fixed budgets. Owners report how many
+// bytes each chunk holds per category and which chunks are in use. Once any
+// category is over its budget, the chunks seen least recently that hold bytes
+// in it are handed to the evictor, oldest first, until it fits again.
+class MemoryGovernor {
+public:
+	// Saves the chunk first if it's dirty, then frees everything it holds. Returns
+	// false if saving failed, the chunk then stays loaded and is tried again later.
+	typedef std::function<bool(const glm::ivec3& position, bool dirty)> Evictor;
+
+	MemoryGovernor();
+
+	void setBudget(MemoryCategory category, size_t bytes);
+	// without one nothing is ever evicted, the governor only keeps count
+	void setEvictor(Evictor evictor) { this->evictor = evictor; }
+
+	// what the chunk holds in the category now, replacing the last figure.
+	// A chunk seen for the first time counts as visible this frame
+	void track(const glm::ivec3& position, MemoryCategory category, size_t bytes);
+	// the chunk was dropped some other way, stop counting it
+	void forget(const glm::ivec3& position);
+	void markVisible(const glm::ivec3& position);
+	// changed since it was loaded, it has to be saved before it can go
+	void markDirty(const glm::ivec3& position);
+	// pinned chunks are never evicted
+	void setPinned(const glm::ivec3& position, bool pinned);
+
+	// chunks marked visible since the last call are safe until the next one
+	void nextFrame() { frame++; }
+	// evicts until every category fits or maxEvictions chunks went, returns how many went
+	size_t enforce(size_t maxEvictions);
+
+	const MemoryCategoryStats& stats(MemoryCategory category) const { return totals[category]; }
+	size_t chunkCount() const { return index.size(); }
+
+private:
+	struct Entry {
+		glm::ivec3 position;
+		size_t bytes[MEMORY_CATEGORY_COUNT];
+		uint64_t lastVisible;
+		bool dirty;
+		bool pinned;
+	};
+	typedef std::list<Entry>::iterator EntryRef;
+
+	// finds the chunk's entry, making one if it has none
+	EntryRef entryFor(const glm::ivec3& position);
+	void addBytes(MemoryCategory category, size_t bytes);
+	bool overBudget(MemoryCategory category) const;
+	// whether dropping the entry would help a category that's over budget
+	bool worthEvicting(const Entry& entry) const;
+
+	// most recently visible at the front
+	std::list<Entry> recency;
+	std::unordered_map<uint64_t, EntryRef> index;
+	MemoryCategoryStats totals[MEMORY_CATEGORY_COUNT];
+	uint64_t frame;
+	Evictor evictor;
+	std::vector<Entry> victims;
+};
+
+#endif
@@ -0,0 +1,249 @@
+#include <glad/glad.h>
+
+#include "mesh_arena.h"
+
+#include <iostream>
+#include <iterator>
+
+RangeAllocator::RangeAllocator(uint32_t capacity) : totalSize(capacity), usedSize(0) {
+	if (capacity > 0) freeBlocks[0] = capacity;
+}
+
+bool RangeAllocator::allocate(uint32_t size, uint32_t& offset) {
+	if (size == 0) return false;
+	auto best = freeBlocks.end();
+	for (auto it = freeBlocks.begin(); it != freeBlocks.end(); ++it) {
+		if (it->second < size) continue;
+		if (best == freeBlocks.end() || it->second < best->second) {
+			best = it;
+			if (it->second == size) break;
+		}
+	}
+	if (best == freeBlocks.end()) return false;
+	offset = best->first;
+	uint32_t remaining = best->second - size;
+	freeBlocks.erase(best);
+	if (remaining > 0) freeBlocks[offset + size] = remaining;
+	usedSize += size;
+	return true;
+}
+
+bool RangeAllocator::allocateAt(uint32_t offset, uint32_t size) {
+	auto it = freeBlocks.upper_bound(offset);
+	if (it == freeBlocks.begin()) return false;
+	--it;
+	uint32_t blockStart = it->first;
+	uint32_t blockEnd = it->first + it->second;
+	if (offset + size > blockEnd) return false;
+	freeBlocks.erase(it);
+	if (offset > blockStart) freeBlocks[blockStart] = offset - blockStart;
+	if (offset + size < blockEnd) freeBlocks[offset + size] = blockEnd - (offset + size);
+	usedSize += size;
+	return true;
+}
+
+void RangeAllocator::release(uint32_t offset, uint32_t size) {
+	if (size == 0) return;
+	usedSize -= size;
+	auto next = freeBlocks.lower_bound(offset);
+	// merge with the block after us
+	if (next != freeBlocks.end() && next->first == offset + size) {
+		size += next->second;
+		next = freeBlocks.erase(next);
+	}
+	// and with the block before us
+	if (next != freeBlocks.begin()) {
+		auto prev = std::prev(next);
+		if (prev->first + prev->second == offset) {
+			prev->second += size;
+			return;
+		}
+	}
+	freeBlocks[offset] = size;
+}
+
+uint32_t RangeAllocator::largestFree() const {
+	uint32_t largest = 0;
+	for (const auto& block : freeBlocks) {
+		if (block.second > largest) largest = block.second;
+	}
+	return largest;
+}
+
+bool RangeAllocator::firstFree(uint32_t& offset, uint32_t& size) const {
+	if (freeBlocks.empty()) return false;
+	offset = freeBlocks.begin()->first;
+	size = freeBlocks.begin()->second;
+	return true;
+}
+
+MeshArena::MeshArena(uint32_t vertexSize, uint32_t verticesPerPage, void (*setupAttributes)())
+	: vertexSize(vertexSize), verticesPerPage(verticesPerPage), setupAttributes(setupAttributes),
+	  liveMeshes(0), lastBytesMoved(0), defragCursor(0), scratchBuffer(0), scratchCapacity(0) {
+	slots.push_back({0, 0, 0});
+}
+
+MeshArena::~MeshArena() {
+	for (Page& page : pages) {
+		glDeleteVertexArrays(1, &page.VAO);
+		glDeleteBuffers(1, &page.VBO);
+	}
+	if (scratchBuffer != 0) glDeleteBuffers(1, &scratchBuffer);
+}
+
+uint32_t MeshArena::addPage(uint32_t capacity) {
+	pages.emplace_back(capacity);
+	Page& page = pages.back();
+	glGenVertexArrays(1, &page.VAO);
+	glGenBuffers(1, &page.VBO);
+	glBindVertexArray(page.VAO);
+	glBindBuffer(GL_ARRAY_BUFFER, page.VBO);
+	glBufferData(GL_ARRAY_BUFFER, (GLsizeiptr)capacity * vertexSize, NULL, GL_DYNAMIC_DRAW);
+	setupAttributes();
+	glBindVertexArray(0);
+	return (uint32_t)pages.size() - 1;
+}
+
+MeshHandle MeshArena::allocate(const void* vertices, uint32_t count) {
+	if (count == 0) return INVALID_MESH;
+
+	uint32_t pageIndex = 0;
+	uint32_t first = 0;
+	bool found = false;
+	for (; pageIndex < pages.size(); pageIndex++) {
+		if (pages[pageIndex].ranges.allocate(count, first)) {
+			found = true;
+			break;
+		}
+	}
+	if (!found) {
+		// a mesh bigger than a whole page gets a page of its own
+		pageIndex = addPage(count > verticesPerPage ? count : verticesPerPage);
+		pages[pageIndex].ranges.allocate(count, first);
+	}
+
+	MeshHandle handle;
+	if (!freeSlots.empty()) {
+		handle = freeSlots.back();
+		freeSlots.pop_back();
+	} else {
+		handle = (MeshHandle)slots.size();
+		slots.push_back({0, 0, 0});
+	}
+	slots[handle] = {pageIndex, first, count};
+	pages[pageIndex].owners[first] = handle;
+	liveMeshes++;
+
+	glBindBuffer(GL_ARRAY_BUFFER, pages[pageIndex].VBO);
+	glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)first * vertexSize, (GLsizeiptr)count * vertexSize, vertices);
+	return handle;
+}
+
+void MeshArena::update(MeshHandle handle, uint32_t offset, const void* vertices, uint32_t count) {
+	if (handle == INVALID_MESH || handle >= slots.size()) return;
+	const MeshAllocation& mesh = slots[handle];
+	if (count == 0 || offset + count > mesh.count) return;
+	glBindBuffer(GL_ARRAY_BUFFER, pages[mesh.page].VBO);
+	glBufferSubData(GL_ARRAY_BUFFER, (GLintptr)(mesh.first + offset) * vertexSize, (GLsizeiptr)count * vertexSize, vertices);
+}
+
+void MeshArena::release(MeshHandle handle) {
+	if (handle == INVALID_MESH || handle >= slots.size()) return;
+	MeshAllocation& mesh = slots[handle];
+	if (mesh.count == 0) return;
+	Page& page = pages[mesh.page];
+	page.ranges.release(mesh.first, mesh.count);
+	page.owners.erase(mesh.first);
+	mesh = {0, 0, 0};
+	freeSlots.push_back(handle);
+	liveMeshes--;
+}
+
+void MeshArena::bindPage(uint32_t page) const {
+	glBindVertexArray(pages[page].VAO);
+}
+
+bool MeshArena::moveMesh(Page& page, MeshHandle handle, uint32_t newFirst) {
+	MeshAllocation& mesh = slots[handle];
+	GLintptr from = (GLintptr)mesh.first * vertexSize;
+	GLintptr to = (GLintptr)newFirst * vertexSize;
+	GLsizeiptr bytes = (GLsizeiptr)mesh.count * vertexSize;
+
+	if (newFirst + mesh.count <= mesh.first) {
+		glBindBuffer(GL_COPY_READ_BUFFER, page.VBO);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, page.VBO);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, from, to, bytes);
+	} else {
+		// GL does not allow overlapping copies inside one buffer, bounce through scratch
+		if (scratchBuffer == 0) glGenBuffers(1, &scratchBuffer);
+		if (scratchCapacity < mesh.count) {
+			glBindBuffer(GL_COPY_WRITE_BUFFER, scratchBuffer);
+			glBufferData(GL_COPY_WRITE_BUFFER, bytes, NULL, GL_DYNAMIC_COPY);
+			scratchCapacity = mesh.count;
+		}
+		glBindBuffer(GL_COPY_READ_BUFFER, page.VBO);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, scratchBuffer);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, from, 0, bytes);
+		glBindBuffer(GL_COPY_READ_BUFFER, scratchBuffer);
+		glBindBuffer(GL_COPY_WRITE_BUFFER, page.VBO);
+		glCopyBufferSubData(GL_COPY_READ_BUFFER, GL_COPY_WRITE_BUFFER, 0, to, bytes);
+	}
+
+	page.ranges.release(mesh.first, mesh.count);
+	if (!page.ranges.allocateAt(newFirst, mesh.count)) {
+		std::cout << "MeshArena: lost track of a free block while compacting" << std::endl;
+		return false;
+	}
+	page.owners.erase(mesh.first);
+	page.owners[newFirst] = handle;
+	mesh.first = newFirst;
+	return true;
+}
+
+void MeshArena::defragment(uint32_t maxVertices) {
+	lastBytesMoved = 0;
+	if (pages.empty()) return;
+
+	uint32_t budget = maxVertices;
+	for (size_t visited = 0; visited < pages.size() && budget > 0; visited++) {
+		Page& page = pages[defragCursor];
+		uint32_t holeStart, holeSize;
+		while (budget > 0 && page.ranges.firstFree(holeStart, holeSize)) {
+			// the mesh sitting right after the first hole slides down into it
+			auto next = page.owners.find(holeStart + holeSize);
+			if (next == page.owners.end()) break;
+			MeshHandle handle = next->second;
+			uint32_t count = slots[handle].count;
+			// a mesh bigger than what's left waits for the next call, which moves it
+			// first. One bigger than the whole budget goes on its own then, or the
+			// cursor would sit on it for good
+			if (count > budget && budget < maxVertices) {
+				budget = 0;
+				break;
+			}
+			if (!moveMesh(page, handle, holeStart)) break;
+			budget = count < budget ? budget - count : 0;
+			lastBytesMoved += (size_t)count * vertexSize;
+		}
+		if (budget > 0) defragCursor = (defragCursor + 1) % pages.size();
+	}
+}
+
+MeshArenaStats MeshArena::stats() const {
+	MeshArenaStats s = {};
+	s.pages = pages.size();
+	s.liveMeshes = liveMeshes;
+	size_t totalFree = 0;
+	for (const Page& page : pages) {
+		s.capacityBytes += (size_t)page.ranges.capacity() * vertexSize;
+		s.usedBytes += (size_t)page.ranges.used() * vertexSize;
+		size_t largest = (size_t)page.ranges.largestFree() * vertexSize;
+		if (largest > s.largestFreeBytes) s.largestFreeBytes = largest;
+		s.freeBlocks += page.ranges.freeBlockCount();
+	}
+	totalFree = s.capacityBytes - s.usedBytes;
+	s.occupancy = s.capacityBytes > 0 ? (float)s.usedBytes / (float)s.capacityBytes : 0.0f;
+	s.fragmentation = totalFree > 0 ? 1.0f - (float)s.largestFreeBytes / (float)totalFree : 0.0f;
+	s.bytesMoved = lastBytesMoved;
+	return s;
+}
@@ -0,0 +1,108 @@
+#ifndef MESH_ARENA_H
+#define MESH_ARENA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <vector>
+
+// Free-list over [0, capacity). Only does the bookkeeping, it never touches GL,
+// so MeshArena can lean on it for every page it owns.
+class RangeAllocator {
+public:
+	explicit RangeAllocator(uint32_t capacity);
+
+	// best fit, returns false when no free block is large enough
+	bool allocate(uint32_t size, uint32_t& offset);
+	// claims exactly [offset, offset + size), which must currently be free
+	bool allocateAt(uint32_t offset, uint32_t size);
+	void release(uint32_t offset, uint32_t size);
+
+	uint32_t capacity() const { return totalSize; }
+	uint32_t used() const { return usedSize; }
+	uint32_t largestFree() const;
+	// lowest free block, used by the compactor to find the next hole to fill
+	bool firstFree(uint32_t& offset, uint32_t& size) const;
+	size_t freeBlockCount() const { return freeBlocks.size(); }
+
+private:
+	uint32_t totalSize;
+	uint32_t usedSize;
+	std::map<uint32_t, uint32_t> freeBlocks; // offset -> size, kept sorted so neighbours coalesce
+};
+
+typedef uint32_t MeshHandle;
+const MeshHandle INVALID_MESH = 0;
+
+struct MeshAllocation {
+	uint32_t page;
+	uint32_t first; // in vertices, ready for glDrawArrays
+	uint32_t count;
+};
+
+struct MeshArenaStats {
+	size_t pages;
+	size_t liveMeshes;
+	size_t capacityBytes;
+	size_t usedBytes;
+	size_t largestFreeBytes;
+	size_t freeBlocks;
+	float occupancy;     // used / capacity
+	float fragmentation; // 1 - largest free block / total free, 0 means all free space is one block
+	size_t bytesMoved;   // by the last defragment() call
+};
+
+// Sub-allocates chunk meshes out of a handful of large vertex buffers.
+// Every page owns one VBO and one VAO, so drawing is one VAO bind per page
+// instead of one per chunk. Meshes are referred to by handle because the
+// compactor is free to move them around inside their page.
+class MeshArena {
+public:
+	// setupAttributes is called once per page with its VAO and VBO bound
+	MeshArena(uint32_t vertexSize, uint32_t verticesPerPage, void (*setupAttributes)());
+	~MeshArena();
+	MeshArena(const MeshArena&) = delete;
+	MeshArena& operator=(const MeshArena&) = delete;
+
+	MeshHandle allocate(const void* vertices, uint32_t count);
+	// overwrites count vertices of a mesh starting offset vertices in, in place
+	void update(MeshHandle handle, uint32_t offset, const void* vertices, uint32_t count);
+	void release(MeshHandle handle);
+	const MeshAllocation& get(MeshHandle handle) const { return slots[handle]; }
+
+	size_t pageCount() const { return pages.size(); }
+	void bindPage(uint32_t page) const;
+
+	// Slides meshes down into the holes in front of them, moving at most
+	// maxVertices per call, or a single mesh when it's bigger than that. Meant
+	// to be called once a frame.
+	void defragment(uint32_t maxVertices);
+
+	MeshArenaStats stats() const;
+
+private:
+	struct Page {
+		unsigned int VAO;
+		unsigned int VBO;
+		RangeAllocator ranges;
+		std::map<uint32_t, MeshHandle> owners; // first vertex -> mesh living there
+		Page(uint32_t capacity) : VAO(0), VBO(0), ranges(capacity) {}
+	};
+
+	uint32_t addPage(uint32_t capacity);
+	bool moveMesh(Page& page, MeshHandle handle, uint32_t newFirst);
+
+	uint32_t vertexSize;
+	uint32_t verticesPerPage;
+	void (*setupAttributes)();
+	std::vector<Page> pages;
+	std::vector<MeshAllocation> slots; // slot 0 is INVALID_MESH
+	std::vector<MeshHandle> freeSlots;
+	size_t liveMeshes;
+	size_t lastBytesMoved;
+	uint32_t defragCursor;
+	unsigned int scratchBuffer; // for moves where source and destination overlap
+	uint32_t scratchCapacity;
+};
+
+#endif
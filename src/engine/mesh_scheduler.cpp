@@ -0,0 +1,119 @@
+#include "mesh_scheduler.h"
+
+#include <cmath>
+
+// a chunk at a coarser level always waits for every chunk at a finer one
+static const float LOD_PRIORITY_STEP = 1000.0f;
+
+MeshScheduler::MeshScheduler(const World& world, ChunkRenderer& renderer, const LodSettings& settings)
+	: world(world), renderer(renderer), settings(settings), camera(0.0f), hasCamera(false) {
+}
+
+float MeshScheduler::distanceTo(const glm::ivec3& position) const {
+	// horizontal distance in chunks from the camera to the chunk's centre
+	float dx = (position.x + 0.5f) - camera.x / CHUNK_SIZE;
+	float dz = (position.z + 0.5f) - camera.z / CHUNK_SIZE;
+	return std::sqrt(dx * dx + dz * dz);
+}
+
+float MeshScheduler::priorityFor(const glm::ivec3& position, int lod) const {
+	return lod * LOD_PRIORITY_STEP + distanceTo(position);
+}
+
+void MeshScheduler::enqueue(const glm::ivec3& position, ChunkState& state, int lod) {
+	state.queuedLod = lod;
+	state.generation++;
+	queue.push({priorityFor(position, lod), position, state.generation});
+}
+
+void MeshScheduler::updateCamera(const glm::vec3& cameraPos) {
+	// chunks are 16 blocks wide, moving a few blocks can't change anything
+	if (hasCamera && glm::length(cameraPos - camera) < CHUNK_SIZE / 4.0f) return;
+	camera = cameraPos;
+	hasCamera = true;
+
+	for (const auto& entry : world.allChunks()) {
+		const glm::ivec3& position = entry.chunk->position;
+		auto it = states.find(entry.key);
+		if (it == states.end()) {
+			it = states.insert({entry.key, {-1, -1, 0, 0}}).first;
+		}
+		ChunkState& state = it->second;
+		int lod = chooseLod(distanceTo(position), state.lod, settings);
+		if (lod != state.lod && lod != state.queuedLod) {
+			enqueue(position, state, lod);
+		} else if (lod == state.lod && state.queuedLod >= 0 && state.dirtySlabs == 0) {
+			// moved back before the queued mesh got built, drop the request
+			state.queuedLod = -1;
+			state.generation++;
+		}
+	}
+}
+
+void MeshScheduler::markDirty(const glm::ivec3& position, SlabMask slabs) {
+	uint64_t key = chunkKey(position.x, position.y, position.z);
+	auto it = states.find(key);
+	if (it == states.end()) {
+		it = states.insert({key, {-1, -1, 0, 0}}).first;
+	}
+	ChunkState& state = it->second;
+	state.dirtySlabs |= slabs;
+	int lod = state.queuedLod >= 0 ? state.queuedLod : chooseLod(distanceTo(position), state.lod, settings);
+	enqueue(position, state, lod);
+}
+
+void MeshScheduler::process(int maxChunks) {
+	while (maxChunks > 0 && !queue.empty()) {
+		Request request = queue.top();
+		queue.pop();
+		const glm::ivec3& p = request.position;
+		auto it = states.find(chunkKey(p.x, p.y, p.z));
+		// a newer request for this chunk is somewhere else in the queue
+		if (it == states.end() || it->second.generation != request.generation) continue;
+		ChunkState& state = it->second;
+
+		const Chunk* chunk = world.getChunk(p.x, p.y, p.z);
+		if (chunk == nullptr) {
+			renderer.remove(p);
+			states.erase(it);
+			continue;
+		}
+		if (!hasVisibleFaces(world, *chunk)) {
+			// sky and buried rock, nothing to mesh and not worth a slot of this frame's budget
+			emptyMesh(*chunk, scratch);
+			renderer.upload(*chunk, scratch);
+			state.lod = state.queuedLod;
+			state.queuedLod = -1;
+			state.dirtySlabs = 0;
+			continue;
+		}
+		if (state.lod == 0 && state.queuedLod == 0 && state.dirtySlabs != ALL_SLABS) {
+			// an edit touched a few slabs, rewrite those in place if they still fit
+			const SlabLayout* layout = renderer.slabLayout(p);
+			if (layout != nullptr && remeshSlabs(world, *chunk, state.dirtySlabs, *layout, patch, arena) && renderer.patch(p, patch)) {
+				state.queuedLod = -1;
+				state.dirtySlabs = 0;
+				maxChunks--;
+				continue;
+			}
+		}
+		scratch.vertices = vertexPool.acquire();
+		if (state.queuedLod == 0) {
+			meshChunk(world, *chunk, scratch, arena);
+		} else {
+			meshChunkLod(*chunk, state.queuedLod, scratch, arena);
+		}
+		renderer.upload(*chunk, scratch);
+		vertexPool.release(std::move(scratch.vertices));
+		state.lod = state.queuedLod;
+		state.queuedLod = -1;
+		state.dirtySlabs = 0;
+		maxChunks--;
+	}
+}
+
+int MeshScheduler::lodOf(const glm::ivec3& position) const {
+	auto it = states.find(chunkKey(position.x, position.y, position.z));
+	if (it == states.end()) return -1;
+	return it->second.lod;
+}
@@ -0,0 +1,63 @@
+#ifndef MESH_SCHEDULER_H
+#define MESH_SCHEDULER_H
+
+#include "chunk_renderer.h"
+#include "lod.h"
+#include "vertex_pool.h"
+
+#include <queue>
+#include <unordered_map>
+#include <vector>
+
+// Decides which level of detail every chunk should be drawn at and (re)meshes
+// chunks in priority order: near, detailed chunks first, far coarse ones last.
+class MeshScheduler {
+public:
+	MeshScheduler(const World& world, ChunkRenderer& renderer, const LodSettings& settings);
+
+	// re-evaluates chunk levels once the camera has moved far enough to matter
+	void updateCamera(const glm::vec3& cameraPos);
+	// queue a chunk to be meshed again at its current level. When only some slabs
+	// changed, a full resolution mesh gets just those rebuilt and patched in place
+	void markDirty(const glm::ivec3& position, SlabMask slabs = ALL_SLABS);
+	// meshes and uploads at most maxChunks queued chunks
+	void process(int maxChunks);
+
+	size_t pending() const { return queue.size(); }
+	// level a chunk is currently drawn at, -1 if it has no mesh yet
+	int lodOf(const glm::ivec3& position) const;
+
+private:
+	struct Request {
+		float priority; // lower goes first
+		glm::ivec3 position;
+		uint32_t generation;
+	};
+	struct RequestOrder {
+		bool operator()(const Request& a, const Request& b) const { return a.priority > b.priority; }
+	};
+	struct ChunkState {
+		int lod;       // level of the uploaded mesh
+		int queuedLod; // level we are waiting to mesh at
+		uint32_t generation;
+		SlabMask dirtySlabs; // changed since the uploaded mesh was made
+	};
+
+	float priorityFor(const glm::ivec3& position, int lod) const;
+	float distanceTo(const glm::ivec3& position) const;
+	void enqueue(const glm::ivec3& position, ChunkState& state, int lod);
+
+	const World& world;
+	ChunkRenderer& renderer;
+	LodSettings settings;
+	glm::vec3 camera;
+	bool hasCamera;
+	std::unordered_map<uint64_t, ChunkState> states;
+	std::priority_queue<Request, std::vector<Request>, RequestOrder> queue;
+	ScratchArena arena;
+	VertexPool vertexPool;
+	ChunkMeshData scratch;
+	MeshPatch patch;
+};
+
+#endif
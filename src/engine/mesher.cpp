@@ -0,0 +1,305 @@
+#include "mesher.h"
+#include "visibility.h"
+
+#include <algorithm>
+
+const char* const TEXTURE_FILES[TEXTURE_COUNT] = {
+	"grass_block.png",
+	"grass_block_side.png",
+	"dirt_block.png",
+	"stone_block.png",
+	"oak_log.png",
+	"oak_log_top.png",
+	"oak_leaves.png",
+};
+
+const int FACE_NORMALS[FACE_COUNT][3] = {
+	{ 0,  0,  1},
+	{ 0,  0, -1},
+	{-1,  0,  0},
+	{ 1,  0,  0},
+	{ 0, -1,  0},
+	{ 0,  1,  0}
+};
+
+// The unit cube from main.cpp moved so a block at (x, y, z) spans [x, x+1].
+static const float FACE_VERTICES[FACE_COUNT][6][5] = {
+	// Front face (z = 1)
+	{{0,0,1, 0,0}, {1,0,1, 1,0}, {1,1,1, 1,1}, {1,1,1, 1,1}, {0,1,1, 0,1}, {0,0,1, 0,0}},
+	// Back face (z = 0)
+	{{1,0,0, 0,0}, {0,0,0, 1,0}, {0,1,0, 1,1}, {0,1,0, 1,1}, {1,1,0, 0,1}, {1,0,0, 0,0}},
+	// Left face (x = 0)
+	{{0,0,0, 0,0}, {0,0,1, 1,0}, {0,1,1, 1,1}, {0,1,1, 1,1}, {0,1,0, 0,1}, {0,0,0, 0,0}},
+	// Right face (x = 1)
+	{{1,0,1, 0,0}, {1,0,0, 1,0}, {1,1,0, 1,1}, {1,1,0, 1,1}, {1,1,1, 0,1}, {1,0,1, 0,0}},
+	// Bottom face (y = 0)
+	{{0,0,0, 0,0}, {1,0,0, 1,0}, {1,0,1, 1,1}, {1,0,1, 1,1}, {0,0,1, 0,1}, {0,0,0, 0,0}},
+	// Top face (y = 1)
+	{{0,1,1, 0,0}, {1,1,1, 1,0}, {1,1,0, 1,1}, {1,1,0, 1,1}, {0,1,0, 0,1}, {0,1,1, 0,0}}
+};
+
+int textureForFace(BlockID id, int face) {
+	switch (id) {
+	case BLOCK_GRASS:
+		if (face == FACE_TOP) return TEX_GRASS_TOP;
+		if (face == FACE_BOTTOM) return TEX_DIRT;
+		return TEX_GRASS_SIDE;
+	case BLOCK_DIRT:
+		return TEX_DIRT;
+	case BLOCK_STONE:
+		return TEX_STONE;
+	case BLOCK_LOG:
+		if (face == FACE_TOP || face == FACE_BOTTOM) return TEX_LOG_TOP;
+		return TEX_LOG;
+	case BLOCK_LEAVES:
+		return TEX_LEAVES;
+	default:
+		return TEX_STONE;
+	}
+}
+
+void emitFace(std::vector<BlockVertex>& out, int x, int y, int z, int face, int texture, int scale) {
+	size_t size = out.size();
+	out.resize(size + 6);
+	emitFace(out.data() + size, x, y, z, face, texture, scale);
+}
+
+BlockVertex* emitFace(BlockVertex* out, int x, int y, int z, int face, int texture, int scale) {
+	for (int i = 0; i < 6; i++) {
+		const float* v = FACE_VERTICES[face][i];
+		*out++ = {v[0] * scale + x, v[1] * scale + y, v[2] * scale + z, v[3] * scale, v[4] * scale, (float)texture};
+	}
+	return out;
+}
+
+void buildBatches(const BlockID* cells, const uint8_t* faces, int size, int scale, ChunkMeshData& out) {
+	int count = size * size * size;
+	std::array<uint32_t, TEXTURE_COUNT> vertices = {};
+	for (int i = 0; i < count; i++) {
+		if (faces[i] == 0) continue;
+		for (int face = 0; face < FACE_COUNT; face++) {
+			if (faces[i] & (1 << face)) vertices[textureForFace(cells[i], face)] += 6;
+		}
+	}
+	std::array<BlockVertex*, TEXTURE_COUNT> cursor;
+	uint32_t total = 0;
+	for (int t = 0; t < TEXTURE_COUNT; t++) {
+		out.batchStart[t] = total;
+		out.batchCount[t] = vertices[t];
+		total += vertices[t];
+	}
+	out.vertices.resize(total);
+	out.slabbed = false;
+	for (int t = 0; t < TEXTURE_COUNT; t++) cursor[t] = out.vertices.data() + out.batchStart[t];
+
+	for (int y = 0; y < size; y++) {
+		for (int z = 0; z < size; z++) {
+			for (int x = 0; x < size; x++) {
+				int i = (y * size + z) * size + x;
+				if (faces[i] == 0) continue;
+				for (int face = 0; face < FACE_COUNT; face++) {
+					if (!(faces[i] & (1 << face))) continue;
+					int texture = textureForFace(cells[i], face);
+					cursor[texture] = emitFace(cursor[texture], x * scale, y * scale, z * scale, face, texture, scale);
+				}
+			}
+		}
+	}
+}
+
+// A block just across the border, in the chunk next to this one if it's loaded.
+// Kept out of line, inlined into the face loop it slows every block down
+__attribute__((noinline)) static BlockID borderBlock(const Chunk* adjacent, int x, int y, int z) {
+	if (adjacent == nullptr) return BLOCK_AIR;
+	return adjacent->get(floorMod(x, CHUNK_SIZE), floorMod(y, CHUNK_SIZE), floorMod(z, CHUNK_SIZE));
+}
+
+bool hasVisibleFaces(const Chunk& chunk, const Chunk* const adjacent[FACE_COUNT]) {
+	if (chunk.isEmpty()) return false;
+	if (!chunk.isFull()) return true;
+	for (int face = 0; face < FACE_COUNT; face++) {
+		if (adjacent[face] == nullptr || !adjacent[face]->isFull()) return true;
+	}
+	return false;
+}
+
+bool hasVisibleFaces(const World& world, const Chunk& chunk) {
+	if (chunk.isEmpty()) return false;
+	if (!chunk.isFull()) return true;
+	for (int face = 0; face < FACE_COUNT; face++) {
+		const Chunk* neighbour = world.getChunk(chunk.position.x + FACE_NORMALS[face][0], chunk.position.y + FACE_NORMALS[face][1],
+			chunk.position.z + FACE_NORMALS[face][2]);
+		if (neighbour == nullptr || !neighbour->isFull()) return true;
+	}
+	return false;
+}
+
+void emptyMesh(const Chunk& chunk, ChunkMeshData& out) {
+	out.vertices.clear();
+	out.batchStart.fill(0);
+	out.batchCount.fill(0);
+	out.connectivity = isOpaque(chunk.uniformBlock()) ? 0 : ALL_FACES_CONNECTED;
+	out.slabbed = false;
+}
+
+// the chunks across each face, for culling faces on the border
+static void findAdjacent(const World& world, const Chunk& chunk, const Chunk* adjacent[FACE_COUNT]) {
+	for (int face = 0; face < FACE_COUNT; face++) {
+		adjacent[face] = world.getChunk(chunk.position.x + FACE_NORMALS[face][0], chunk.position.y + FACE_NORMALS[face][1],
+			chunk.position.z + FACE_NORMALS[face][2]);
+	}
+}
+
+// a 1 << Face bit in faces for every visible face of the blocks in rows yBegin..yEnd - 1
+static void findFaces(const Chunk& chunk, const Chunk* const adjacent[FACE_COUNT], int yBegin, int yEnd, uint8_t* faces) {
+	for (int y = yBegin; y < yEnd; y++) {
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			for (int x = 0; x < CHUNK_SIZE; x++) {
+				BlockID id = chunk.get(x, y, z);
+				uint8_t mask = 0;
+				if (id != BLOCK_AIR) {
+					for (int face = 0; face < FACE_COUNT; face++) {
+						int nx = x + FACE_NORMALS[face][0];
+						int ny = y + FACE_NORMALS[face][1];
+						int nz = z + FACE_NORMALS[face][2];
+						BlockID neighbour;
+						if (nx >= 0 && nx < CHUNK_SIZE && ny >= 0 && ny < CHUNK_SIZE && nz >= 0 && nz < CHUNK_SIZE) {
+							neighbour = chunk.get(nx, ny, nz);
+						} else {
+							neighbour = borderBlock(adjacent[face], nx, ny, nz);
+						}
+						// leaves draw every face, we don't cull transparent blocks
+						if (id != BLOCK_LEAVES && isOpaque(neighbour)) continue;
+						mask |= 1 << face;
+					}
+				}
+				faces[blockIndex(x, y, z)] = mask;
+			}
+		}
+	}
+}
+
+// room in every slab of a batch for the faces of two more fully exposed blocks,
+// so digging and building a block at a time rarely needs a mesh from scratch
+static const uint32_t SLAB_SPARE_VERTICES = 12 * 6;
+
+static uint32_t slabCapacity(uint32_t vertices) {
+	return vertices == 0 ? 0 : vertices + SLAB_SPARE_VERTICES;
+}
+
+// adds up the vertices of every texture in one slab
+static void countSlab(const BlockID* blocks, const uint8_t* faces, int slab, uint32_t* vertices) {
+	int end = (slab + 1) * SLAB_HEIGHT * CHUNK_AREA;
+	for (int i = slab * SLAB_HEIGHT * CHUNK_AREA; i < end; i++) {
+		if (faces[i] == 0) continue;
+		for (int face = 0; face < FACE_COUNT; face++) {
+			if (faces[i] & (1 << face)) vertices[textureForFace(blocks[i], face)] += 6;
+		}
+	}
+}
+
+// writes one slab's faces, each texture's at its cursor, leaving the cursors after them
+static void emitSlab(const BlockID* blocks, const uint8_t* faces, int slab, BlockVertex** cursor) {
+	for (int y = slab * SLAB_HEIGHT; y < (slab + 1) * SLAB_HEIGHT; y++) {
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			for (int x = 0; x < CHUNK_SIZE; x++) {
+				int i = blockIndex(x, y, z);
+				if (faces[i] == 0) continue;
+				for (int face = 0; face < FACE_COUNT; face++) {
+					if (!(faces[i] & (1 << face))) continue;
+					int texture = textureForFace(blocks[i], face);
+					cursor[texture] = emitFace(cursor[texture], x, y, z, face, texture, 1);
+				}
+			}
+		}
+	}
+}
+
+void meshChunk(const World& world, const Chunk& chunk, ChunkMeshData& out, ScratchArena& arena) {
+	const Chunk* adjacent[FACE_COUNT];
+	findAdjacent(world, chunk, adjacent);
+	meshChunk(chunk, adjacent, out, arena);
+}
+
+void meshChunk(const Chunk& chunk, const Chunk* const adjacent[FACE_COUNT], ChunkMeshData& out, ScratchArena& arena) {
+	if (!hasVisibleFaces(chunk, adjacent)) {
+		emptyMesh(chunk, out);
+		return;
+	}
+	arena.reset();
+	uint8_t* faces = arena.allocate<uint8_t>(CHUNK_VOLUME);
+	findFaces(chunk, adjacent, 0, CHUNK_SIZE, faces);
+
+	const BlockID* blocks = chunk.blockData();
+	uint32_t counts[SLAB_COUNT][TEXTURE_COUNT] = {};
+	for (int slab = 0; slab < SLAB_COUNT; slab++) countSlab(blocks, faces, slab, counts[slab]);
+	uint32_t total = 0;
+	for (int t = 0; t < TEXTURE_COUNT; t++) {
+		out.batchStart[t] = total;
+		for (int slab = 0; slab < SLAB_COUNT; slab++) {
+			out.slabs.start[t][slab] = total;
+			out.slabs.capacity[t][slab] = slabCapacity(counts[slab][t]);
+			total += out.slabs.capacity[t][slab];
+		}
+		out.batchCount[t] = total - out.batchStart[t];
+	}
+	out.vertices.resize(total);
+
+	BlockVertex* base = out.vertices.data();
+	for (int slab = 0; slab < SLAB_COUNT; slab++) {
+		BlockVertex* cursor[TEXTURE_COUNT];
+		for (int t = 0; t < TEXTURE_COUNT; t++) cursor[t] = base + out.slabs.start[t][slab];
+		emitSlab(blocks, faces, slab, cursor);
+		for (int t = 0; t < TEXTURE_COUNT; t++) {
+			std::fill(cursor[t], base + out.slabs.start[t][slab] + out.slabs.capacity[t][slab], BlockVertex());
+		}
+	}
+	out.slabbed = true;
+	out.connectivity = computeFaceConnectivity(chunk, arena);
+}
+
+bool remeshSlabs(const World& world, const Chunk& chunk, SlabMask slabs, const SlabLayout& layout, MeshPatch& out, ScratchArena& arena) {
+	out.vertices.clear();
+	out.ranges.clear();
+	if (!hasVisibleFaces(world, chunk)) return false;
+	arena.reset();
+	uint8_t* faces = arena.allocate<uint8_t>(CHUNK_VOLUME);
+	const Chunk* adjacent[FACE_COUNT];
+	findAdjacent(world, chunk, adjacent);
+
+	const BlockID* blocks = chunk.blockData();
+	uint32_t total = 0;
+	for (int slab = 0; slab < SLAB_COUNT; slab++) {
+		if (!(slabs & (1 << slab))) continue;
+		findFaces(chunk, adjacent, slab * SLAB_HEIGHT, (slab + 1) * SLAB_HEIGHT, faces);
+		uint32_t counts[TEXTURE_COUNT] = {};
+		countSlab(blocks, faces, slab, counts);
+		for (int t = 0; t < TEXTURE_COUNT; t++) {
+			if (counts[t] > layout.capacity[t][slab]) return false;
+			total += layout.capacity[t][slab];
+		}
+	}
+	out.vertices.resize(total);
+
+	BlockVertex* base = out.vertices.data();
+	uint32_t written = 0;
+	for (int slab = 0; slab < SLAB_COUNT; slab++) {
+		if (!(slabs & (1 << slab))) continue;
+		BlockVertex* cursor[TEXTURE_COUNT];
+		uint32_t offset = written;
+		for (int t = 0; t < TEXTURE_COUNT; t++) {
+			cursor[t] = base + offset;
+			offset += layout.capacity[t][slab];
+		}
+		emitSlab(blocks, faces, slab, cursor);
+		for (int t = 0; t < TEXTURE_COUNT; t++) {
+			uint32_t capacity = layout.capacity[t][slab];
+			if (capacity == 0) continue;
+			std::fill(cursor[t], base + written + capacity, BlockVertex());
+			out.ranges.push_back({layout.start[t][slab], capacity});
+			written += capacity;
+		}
+	}
+	out.connectivity = computeFaceConnectivity(chunk, arena);
+	return true;
+}
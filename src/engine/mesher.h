@@ -0,0 +1,108 @@
+#ifndef MESHER_H
+#define MESHER_H
+
+#include "scratch_arena.h"
+#include "world.h"
+
+#include <array>
+#include <vector>
+
+// One entry per block texture, also the layer it sits on in the texture array.
+enum TextureSlot {
+	TEX_GRASS_TOP = 0,
+	TEX_GRASS_SIDE,
+	TEX_DIRT,
+	TEX_STONE,
+	TEX_LOG,
+	TEX_LOG_TOP,
+	TEX_LEAVES,
+	TEXTURE_COUNT
+};
+
+// file of each slot under assets/textures/blocks
+extern const char* const TEXTURE_FILES[TEXTURE_COUNT];
+// every block texture gets scaled to this for the texture array
+const int BLOCK_TEXTURE_SIZE = 16;
+
+enum Face {
+	FACE_FRONT = 0, // +z
+	FACE_BACK,      // -z
+	FACE_LEFT,      // -x
+	FACE_RIGHT,     // +x
+	FACE_BOTTOM,    // -y
+	FACE_TOP,       // +y
+	FACE_COUNT
+};
+
+extern const int FACE_NORMALS[FACE_COUNT][3];
+
+// Chunk local position plus (u, v, texture slot), matches the layout shader.vs expects.
+struct BlockVertex {
+	float x, y, z;
+	float u, v, layer;
+};
+
+// Where each slab's faces sit inside a full resolution mesh: every texture's
+// batch is its slabs one after the other, each with room for a few more faces
+// than it has. The spare room is degenerate triangles, which draw nothing.
+struct SlabLayout {
+	std::array<std::array<uint32_t, SLAB_COUNT>, TEXTURE_COUNT> start; // vertex index in the mesh
+	std::array<std::array<uint32_t, SLAB_COUNT>, TEXTURE_COUNT> capacity;
+};
+
+// Vertices of one chunk sorted by texture, so each texture is one contiguous draw.
+struct ChunkMeshData {
+	std::vector<BlockVertex> vertices;
+	std::array<uint32_t, TEXTURE_COUNT> batchStart;
+	std::array<uint32_t, TEXTURE_COUNT> batchCount;
+	uint16_t connectivity; // FaceConnectivity of the full resolution chunk, see visibility.h
+	bool slabbed; // laid out by slabs, only meshChunk's meshes are
+	SlabLayout slabs;
+};
+
+// Vertices to write over part of a mesh that's already uploaded.
+struct MeshPatch {
+	struct Range {
+		uint32_t start; // vertex index in the mesh
+		uint32_t count;
+	};
+	std::vector<BlockVertex> vertices; // the ranges' vertices one after the other
+	std::vector<Range> ranges;
+	uint16_t connectivity;
+};
+
+int textureForFace(BlockID id, int face);
+
+// Appends the 6 vertices of one face of the block (or LOD cell of size scale) at x, y, z.
+void emitFace(std::vector<BlockVertex>& out, int x, int y, int z, int face, int texture, int scale);
+// Same, written to out, returns where the next face goes.
+BlockVertex* emitFace(BlockVertex* out, int x, int y, int z, int face, int texture, int scale);
+
+// Fills in out's vertices and batches from size^3 cells of scale blocks each,
+// indexed (y * size + z) * size + x, where faces holds a 1 << Face bit for every
+// face of the cell to draw. Counts first, so every face goes straight to its
+// place in its batch and out's vertices only grow for a mesh bigger than any before.
+void buildBatches(const BlockID* cells, const uint8_t* faces, int size, int scale, ChunkMeshData& out);
+
+// Builds the visible faces of a chunk. Neighbouring chunks are looked up through
+// the world so faces on chunk borders get culled too. The arena is reset first
+// and holds the working memory, out's vertices are reused if they're big enough,
+// so with a warm arena and out meshing allocates nothing.
+void meshChunk(const World& world, const Chunk& chunk, ChunkMeshData& out, ScratchArena& arena);
+// the same with the neighbour across each Face given, nullptr for none, so a
+// ChunkSnapshot can be meshed without touching the world
+void meshChunk(const Chunk& chunk, const Chunk* const adjacent[FACE_COUNT], ChunkMeshData& out, ScratchArena& arena);
+
+// Rebuilds just the given slabs of a mesh meshChunk made with the given layout.
+// False if one of them now has more faces of some texture than it has room for,
+// the chunk needs meshing from scratch then. Same memory rules as meshChunk.
+bool remeshSlabs(const World& world, const Chunk& chunk, SlabMask slabs, const SlabLayout& layout, MeshPatch& out, ScratchArena& arena);
+
+// False for sections with nothing to draw at any level: all air, or all opaque
+// with an all opaque section on every side. Those take emptyMesh instead.
+bool hasVisibleFaces(const World& world, const Chunk& chunk);
+bool hasVisibleFaces(const Chunk& chunk, const Chunk* const adjacent[FACE_COUNT]);
+// no vertices, only the connectivity of a uniform section
+void emptyMesh(const Chunk& chunk, ChunkMeshData& out);
+
+#endif
@@ -0,0 +1,262 @@
+#include "net.h"
+
+#include <arpa/inet.h>
+#include <cerrno>
+#include <fcntl.h>
+#include <iostream>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+// most bytes pulled off a socket per read call
+static const size_t READ_CHUNK = 64 * 1024;
+
+void Connection::consumeInput(size_t count) {
+	in.erase(in.begin(), in.begin() + count);
+}
+
+static void setupSocket(int fd) {
+	fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+	// frames are already batched per tick, don't let Nagle hold them back
+	int on = 1;
+	setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &on, sizeof(on));
+}
+
+static void resetConnection(Connection& connection, int fd, uint32_t id) {
+	connection.fd = fd;
+	connection.id = id;
+	connection.in.clear();
+	connection.out.clear();
+	connection.outOffset = 0;
+	connection.bytesSent = 0;
+	connection.bytesReceived = 0;
+	connection.writeWatched = false;
+}
+
+// reads until the socket runs dry, false when the other end is gone
+static bool receiveAll(Connection& connection) {
+	while (true) {
+		size_t start = connection.in.size();
+		connection.in.resize(start + READ_CHUNK);
+		ssize_t got = recv(connection.fd, connection.in.data() + start, READ_CHUNK, 0);
+		connection.in.resize(start + (got > 0 ? got : 0));
+		if (got > 0) {
+			connection.bytesReceived += got;
+			continue;
+		}
+		if (got == 0) return false;
+		if (errno == EINTR) continue;
+		return errno == EAGAIN || errno == EWOULDBLOCK;
+	}
+}
+
+// writes until everything is out or the socket is full, false on error
+static bool sendAll(Connection& connection) {
+	while (connection.pending() > 0) {
+		ssize_t sent = ::send(connection.fd, connection.out.data() + connection.outOffset, connection.pending(), MSG_NOSIGNAL);
+		if (sent > 0) {
+			connection.outOffset += sent;
+			connection.bytesSent += sent;
+			continue;
+		}
+		if (sent < 0 && errno == EINTR) continue;
+		if (sent < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+		return false;
+	}
+	if (connection.outOffset == connection.out.size()) {
+		connection.out.clear();
+		connection.outOffset = 0;
+	} else if (connection.outOffset > connection.out.size() / 2) {
+		// don't let the sent part pile up in front of a slow reader
+		connection.out.erase(connection.out.begin(), connection.out.begin() + connection.outOffset);
+		connection.outOffset = 0;
+	}
+	return true;
+}
+
+NetServer::NetServer() : listenFd(-1), epollFd(-1), boundPort(0), nextId(1), closedSent(0), closedReceived(0) {
+}
+
+NetServer::~NetServer() {
+	for (auto& entry : connections) ::close(entry.second->fd);
+	if (listenFd >= 0) ::close(listenFd);
+	if (epollFd >= 0) ::close(epollFd);
+}
+
+bool NetServer::listen(const char* address, uint16_t port) {
+	listenFd = socket(AF_INET, SOCK_STREAM, 0);
+	if (listenFd < 0) {
+		std::cout << "Failed to create socket" << std::endl;
+		return false;
+	}
+	int on = 1;
+	setsockopt(listenFd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	if (inet_pton(AF_INET, address, &addr.sin_addr) != 1
+		|| bind(listenFd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0
+		|| ::listen(listenFd, 128) != 0) {
+		std::cout << "Failed to listen on " << address << ":" << port << std::endl;
+		return false;
+	}
+	socklen_t length = sizeof(addr);
+	getsockname(listenFd, reinterpret_cast<sockaddr*>(&addr), &length);
+	boundPort = ntohs(addr.sin_port);
+	fcntl(listenFd, F_SETFL, fcntl(listenFd, F_GETFL, 0) | O_NONBLOCK);
+
+	epollFd = epoll_create1(0);
+	epoll_event event = {};
+	event.events = EPOLLIN;
+	event.data.u32 = 0; // connection ids start at 1
+	epoll_ctl(epollFd, EPOLL_CTL_ADD, listenFd, &event);
+	return true;
+}
+
+void NetServer::acceptAll() {
+	while (true) {
+		int fd = accept(listenFd, nullptr, nullptr);
+		if (fd < 0) return;
+		setupSocket(fd);
+		std::unique_ptr<Connection> connection(new Connection());
+		resetConnection(*connection, fd, nextId++);
+		epoll_event event = {};
+		event.events = EPOLLIN;
+		event.data.u32 = connection->id;
+		epoll_ctl(epollFd, EPOLL_CTL_ADD, fd, &event);
+		accepted.push_back(connection->id);
+		connections[connection->id] = std::move(connection);
+	}
+}
+
+void NetServer::poll(int timeoutMs) {
+	if (epollFd < 0) return;
+	epoll_event events[256];
+	int count = epoll_wait(epollFd, events, 256, timeoutMs);
+	for (int i = 0; i < count; i++) {
+		uint32_t id = events[i].data.u32;
+		if (id == 0) {
+			acceptAll();
+			continue;
+		}
+		Connection* connection = this->connection(id);
+		if (connection == nullptr) continue;
+		bool alive = !(events[i].events & (EPOLLERR | EPOLLHUP));
+		if (alive && (events[i].events & EPOLLIN)) alive = receiveAll(*connection);
+		if (alive && (events[i].events & EPOLLOUT)) {
+			alive = sendAll(*connection);
+			if (alive && connection->pending() == 0) watchWrites(*connection, false);
+		}
+		if (!alive) close(id);
+	}
+}
+
+void NetServer::takeAccepted(std::vector<uint32_t>& out) {
+	out.swap(accepted);
+	accepted.clear();
+}
+
+void NetServer::takeClosed(std::vector<uint32_t>& out) {
+	out.swap(closed);
+	closed.clear();
+}
+
+Connection* NetServer::connection(uint32_t id) {
+	auto found = connections.find(id);
+	return found == connections.end() ? nullptr : found->second.get();
+}
+
+void NetServer::watchWrites(Connection& connection, bool watch) {
+	if (connection.writeWatched == watch) return;
+	epoll_event event = {};
+	event.events = watch ? (EPOLLIN | EPOLLOUT) : EPOLLIN;
+	event.data.u32 = connection.id;
+	epoll_ctl(epollFd, EPOLL_CTL_MOD, connection.fd, &event);
+	connection.writeWatched = watch;
+}
+
+void NetServer::flush(Connection& connection) {
+	// once we're waiting on EPOLLOUT the loop takes care of it
+	if (connection.writeWatched) return;
+	if (!sendAll(connection)) {
+		close(connection.id);
+		return;
+	}
+	if (connection.pending() > 0) watchWrites(connection, true);
+}
+
+void NetServer::send(uint32_t id, const uint8_t* data, size_t size) {
+	Connection* connection = this->connection(id);
+	if (connection == nullptr || size == 0) return;
+	connection->out.insert(connection->out.end(), data, data + size);
+	flush(*connection);
+}
+
+void NetServer::close(uint32_t id) {
+	auto found = connections.find(id);
+	if (found == connections.end()) return;
+	epoll_ctl(epollFd, EPOLL_CTL_DEL, found->second->fd, nullptr);
+	::close(found->second->fd);
+	closedSent += found->second->bytesSent;
+	closedReceived += found->second->bytesReceived;
+	connections.erase(found);
+	closed.push_back(id);
+}
+
+uint64_t NetServer::bytesSent() const {
+	uint64_t total = closedSent;
+	for (const auto& entry : connections) total += entry.second->bytesSent;
+	return total;
+}
+
+uint64_t NetServer::bytesReceived() const {
+	uint64_t total = closedReceived;
+	for (const auto& entry : connections) total += entry.second->bytesReceived;
+	return total;
+}
+
+NetClient::NetClient() {
+	resetConnection(link, -1, 0);
+}
+
+NetClient::~NetClient() {
+	disconnect();
+}
+
+bool NetClient::connect(const char* address, uint16_t port) {
+	disconnect();
+	int fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (fd < 0) return false;
+	sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_port = htons(port);
+	// blocking connect, it's quick on a local network and keeps this simple
+	if (inet_pton(AF_INET, address, &addr.sin_addr) != 1 || ::connect(fd, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) != 0) {
+		::close(fd);
+		return false;
+	}
+	setupSocket(fd);
+	resetConnection(link, fd, 0);
+	return true;
+}
+
+bool NetClient::update() {
+	if (link.fd < 0) return false;
+	if (!receiveAll(link) || !sendAll(link)) {
+		disconnect();
+		return false;
+	}
+	return true;
+}
+
+void NetClient::send(const uint8_t* data, size_t size) {
+	if (link.fd < 0) return;
+	link.out.insert(link.out.end(), data, data + size);
+}
+
+void NetClient::disconnect() {
+	if (link.fd >= 0) ::close(link.fd);
+	link.fd = -1;
+}
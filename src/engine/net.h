@@ -0,0 +1,92 @@
+#ifndef NET_H
+#define NET_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+// One TCP connection and its buffers. Sockets are non-blocking, so reads and
+// writes only ever move what the kernel has room for right now.
+struct Connection {
+	int fd;
+	uint32_t id;
+	std::vector<uint8_t> in;
+	std::vector<uint8_t> out;
+	size_t outOffset; // how much of out has been sent already
+	uint64_t bytesSent;
+	uint64_t bytesReceived;
+	bool writeWatched; // waiting on EPOLLOUT because the socket was full
+
+	size_t pending() const { return out.size() - outOffset; }
+	// drops the first count bytes of in, once they've been parsed
+	void consumeInput(size_t count);
+};
+
+// Listens for clients and runs the epoll loop for all of them.
+class NetServer {
+public:
+	NetServer();
+	~NetServer();
+	NetServer(const NetServer&) = delete;
+	NetServer& operator=(const NetServer&) = delete;
+
+	// port 0 picks any free one, see port()
+	bool listen(const char* address, uint16_t port);
+	uint16_t port() const { return boundPort; }
+
+	// accepts, reads and writes whatever is ready, waiting at most timeoutMs for
+	// anything to happen. Closed connections are gone once this returns.
+	void poll(int timeoutMs);
+	void takeAccepted(std::vector<uint32_t>& out);
+	void takeClosed(std::vector<uint32_t>& out);
+
+	// nullptr once the connection has closed
+	Connection* connection(uint32_t id);
+	// queues data and sends as much as fits right away
+	void send(uint32_t id, const uint8_t* data, size_t size);
+	void close(uint32_t id);
+	size_t connectionCount() const { return connections.size(); }
+	// over every connection so far, closed ones included
+	uint64_t bytesSent() const;
+	uint64_t bytesReceived() const;
+
+private:
+	void acceptAll();
+	void flush(Connection& connection);
+	void watchWrites(Connection& connection, bool watch);
+
+	int listenFd;
+	int epollFd;
+	uint16_t boundPort;
+	uint32_t nextId;
+	std::unordered_map<uint32_t, std::unique_ptr<Connection>> connections;
+	std::vector<uint32_t> accepted;
+	std::vector<uint32_t> closed;
+	uint64_t closedSent;
+	uint64_t closedReceived;
+};
+
+// The client end. With just the one socket there's no need for epoll, update()
+// reads and writes until the socket would block.
+class NetClient {
+public:
+	NetClient();
+	~NetClient();
+	NetClient(const NetClient&) = delete;
+	NetClient& operator=(const NetClient&) = delete;
+
+	bool connect(const char* address, uint16_t port);
+	bool connected() const { return link.fd >= 0; }
+	// false once the server has gone away
+	bool update();
+	void send(const uint8_t* data, size_t size);
+	void disconnect();
+	Connection& connection() { return link; }
+
+private:
+	Connection link;
+};
+
+#endif
@@ -0,0 +1,133 @@
+#include <glad/glad.h>
+
+#include "occlusion.h"
+#include "mesher.h"
+
+#include "../../include/glm/gtc/matrix_transform.hpp"
+
+// queries for chunks we have not tested in this many frames get recycled
+static const uint32_t QUERY_EXPIRY_FRAMES = 120;
+
+OcclusionCuller::OcclusionCuller() : boxVAO(0), boxVBO(0), frame(0) {
+	// unit cube, same vertex layout as the chunk meshes so the block shader can draw it
+	std::vector<BlockVertex> box;
+	for (int face = 0; face < FACE_COUNT; face++) {
+		emitFace(box, 0, 0, 0, face, 0, 1);
+	}
+	glGenVertexArrays(1, &boxVAO);
+	glGenBuffers(1, &boxVBO);
+	glBindVertexArray(boxVAO);
+	glBindBuffer(GL_ARRAY_BUFFER, boxVBO);
+	glBufferData(GL_ARRAY_BUFFER, box.size() * sizeof(BlockVertex), box.data(), GL_STATIC_DRAW);
+	glVertexAttribPointer(0, 3, GL_FLOAT, GL_FALSE, sizeof(BlockVertex), (void*)0);
+	glEnableVertexAttribArray(0);
+	glVertexAttribPointer(1, 3, GL_FLOAT, GL_FALSE, sizeof(BlockVertex), (void*)(3 * sizeof(float)));
+	glEnableVertexAttribArray(1);
+	glBindVertexArray(0);
+}
+
+OcclusionCuller::~OcclusionCuller() {
+	for (auto& entry : queries) {
+		glDeleteQueries(1, &entry.second.id);
+	}
+	if (!freeIds.empty()) glDeleteQueries((GLsizei)freeIds.size(), freeIds.data());
+	glDeleteVertexArrays(1, &boxVAO);
+	glDeleteBuffers(1, &boxVBO);
+}
+
+void OcclusionCuller::collect() {
+	frame++;
+	for (auto it = queries.begin(); it != queries.end();) {
+		Query& query = it->second;
+		if (query.pending) {
+			GLuint available = 0;
+			glGetQueryObjectuiv(query.id, GL_QUERY_RESULT_AVAILABLE, &available);
+			if (available) {
+				GLuint samples = 0;
+				glGetQueryObjectuiv(query.id, GL_QUERY_RESULT, &samples);
+				query.visible = samples != 0;
+				query.pending = false;
+			}
+		}
+		if (!query.pending && frame - query.lastRequested > QUERY_EXPIRY_FRAMES) {
+			freeIds.push_back(query.id);
+			it = queries.erase(it);
+		} else {
+			++it;
+		}
+	}
+}
+
+bool OcclusionCuller::isVisible(uint64_t key) const {
+	auto it = queries.find(key);
+	if (it == queries.end()) return true;
+	return it->second.visible;
+}
+
+void OcclusionCuller::request(uint64_t key, const glm::vec3& min, const glm::vec3& max) {
+	requests.push_back({key, min, max});
+}
+
+void OcclusionCuller::issue(const Shader& shader) {
+	if (requests.empty()) return;
+
+	// test against the depth buffer without touching it or the colour buffer
+	glColorMask(GL_FALSE, GL_FALSE, GL_FALSE, GL_FALSE);
+	glDepthMask(GL_FALSE);
+	glDisable(GL_CULL_FACE);
+	glBindVertexArray(boxVAO);
+
+	for (const BoxRequest& request : requests) {
+		auto it = queries.find(request.key);
+		if (it == queries.end()) {
+			Query query;
+			if (!freeIds.empty()) {
+				query.id = freeIds.back();
+				freeIds.pop_back();
+			} else {
+				glGenQueries(1, &query.id);
+			}
+			query.pending = false;
+			query.visible = true;
+			it = queries.insert({request.key, query}).first;
+		}
+		Query& query = it->second;
+		query.lastRequested = frame;
+		// still waiting on last frame's answer, don't stack another one on top
+		if (query.pending) continue;
+
+		glm::mat4 model = glm::translate(glm::mat4(1.0f), request.min);
+		model = glm::scale(model, request.max - request.min);
+		shader.setMat4("model", model);
+		glBeginQuery(GL_ANY_SAMPLES_PASSED, query.id);
+		glDrawArrays(GL_TRIANGLES, 0, 6 * FACE_COUNT);
+		glEndQuery(GL_ANY_SAMPLES_PASSED);
+		query.pending = true;
+	}
+	requests.clear();
+
+	glBindVertexArray(0);
+	glEnable(GL_CULL_FACE);
+	glDepthMask(GL_TRUE);
+	glColorMask(GL_TRUE, GL_TRUE, GL_TRUE, GL_TRUE);
+}
+
+void OcclusionCuller::forget(uint64_t key) {
+	auto it = queries.find(key);
+	if (it == queries.end()) return;
+	// a query still in flight can't be reused until the GPU is done with it
+	if (it->second.pending) {
+		glDeleteQueries(1, &it->second.id);
+	} else {
+		freeIds.push_back(it->second.id);
+	}
+	queries.erase(it);
+}
+
+size_t OcclusionCuller::pendingQueries() const {
+	size_t count = 0;
+	for (const auto& entry : queries) {
+		if (entry.second.pending) count++;
+	}
+	return count;
+}
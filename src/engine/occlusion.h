@@ -0,0 +1,55 @@
+#ifndef OCCLUSION_H
+#define OCCLUSION_H
+
+#include "../../include/glm/glm.hpp"
+#include "../../assets/shaders/shader.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Conservative GPU occlusion culling for chunks.
+// After the scene is drawn, every chunk in the frustum gets an occlusion query that
+// draws its bounding box against the depth buffer. Results are picked up on a later
+// frame without ever stalling on the GPU, so a chunk that comes into view shows up
+// one frame late and a chunk with no answer yet is always treated as visible.
+class OcclusionCuller {
+public:
+	OcclusionCuller();
+	~OcclusionCuller();
+	OcclusionCuller(const OcclusionCuller&) = delete;
+	OcclusionCuller& operator=(const OcclusionCuller&) = delete;
+
+	// reads back whatever query results the GPU has finished
+	void collect();
+	bool isVisible(uint64_t key) const;
+	// queue up a bounding box test for this frame
+	void request(uint64_t key, const glm::vec3& min, const glm::vec3& max);
+	// issues every requested test, call after the scene has been drawn
+	void issue(const Shader& shader);
+	void forget(uint64_t key);
+
+	size_t pendingQueries() const;
+
+private:
+	struct Query {
+		unsigned int id;
+		bool pending;
+		bool visible;
+		uint32_t lastRequested;
+	};
+	struct BoxRequest {
+		uint64_t key;
+		glm::vec3 min;
+		glm::vec3 max;
+	};
+
+	std::unordered_map<uint64_t, Query> queries;
+	std::vector<BoxRequest> requests;
+	std::vector<unsigned int> freeIds;
+	unsigned int boxVAO;
+	unsigned int boxVBO;
+	uint32_t frame;
+};
+
+#endif
@@ -0,0 +1,84 @@
+#include "physics.h"
+
+#include <cmath>
+
+// boxes stop this far short of a block so they never end up touching it exactly
+static const float SKIN = 1e-4f;
+
+AABB bodyBounds(const PhysicsBody& body) {
+	glm::vec3 half(body.halfExtents.x, 0.0f, body.halfExtents.z);
+	return {body.position - half, body.position + half + glm::vec3(0.0f, body.halfExtents.y, 0.0f)};
+}
+
+// Collects the solid blocks in the region both boxes cover (the broadphase).
+static void gatherSolids(const World& world, const AABB& box, const glm::vec3& motion, std::vector<glm::ivec3>& solids) {
+	glm::vec3 lo = glm::min(box.min, box.min + motion);
+	glm::vec3 hi = glm::max(box.max, box.max + motion);
+	glm::ivec3 first((int)std::floor(lo.x), (int)std::floor(lo.y), (int)std::floor(lo.z));
+	glm::ivec3 last((int)std::floor(hi.x), (int)std::floor(hi.y), (int)std::floor(hi.z));
+	solids.clear();
+	ConstBlockAccess blocks(world);
+	for (int y = first.y; y <= last.y; y++) {
+		for (int z = first.z; z <= last.z; z++) {
+			for (int x = first.x; x <= last.x; x++) {
+				if (isSolid(blocks.getBlock(x, y, z))) solids.push_back(glm::ivec3(x, y, z));
+			}
+		}
+	}
+}
+
+// How far box can move along axis before running into any of the blocks.
+static float clipAxis(const AABB& box, int axis, float motion, const std::vector<glm::ivec3>& solids) {
+	int a = (axis + 1) % 3;
+	int b = (axis + 2) % 3;
+	for (const glm::ivec3& block : solids) {
+		// only blocks that overlap us on the other two axes can be hit
+		if (box.max[a] <= block[a] || box.min[a] >= block[a] + 1) continue;
+		if (box.max[b] <= block[b] || box.min[b] >= block[b] + 1) continue;
+		if (motion > 0.0f && box.max[axis] <= block[axis] + SKIN) {
+			float gap = block[axis] - box.max[axis] - SKIN;
+			if (gap < motion) motion = gap > 0.0f ? gap : 0.0f;
+		} else if (motion < 0.0f && box.min[axis] >= block[axis] + 1 - SKIN) {
+			float gap = block[axis] + 1 - box.min[axis] + SKIN;
+			if (gap > motion) motion = gap < 0.0f ? gap : 0.0f;
+		}
+	}
+	return motion;
+}
+
+glm::vec3 moveAndCollide(const World& world, AABB& box, const glm::vec3& motion, glm::bvec3& blocked) {
+	// kept around between calls, the broadphase rarely finds more than a few dozen blocks
+	static thread_local std::vector<glm::ivec3> solids;
+	gatherSolids(world, box, motion, solids);
+
+	glm::vec3 applied(0.0f);
+	blocked = glm::bvec3(false);
+	static const int ORDER[3] = {1, 0, 2};
+	for (int i = 0; i < 3; i++) {
+		int axis = ORDER[i];
+		if (motion[axis] == 0.0f) continue;
+		float allowed = clipAxis(box, axis, motion[axis], solids);
+		if (allowed != motion[axis]) blocked[axis] = true;
+		box.min[axis] += allowed;
+		box.max[axis] += allowed;
+		applied[axis] = allowed;
+	}
+	return applied;
+}
+
+void stepBody(const World& world, PhysicsBody& body, float seconds) {
+	if (body.gravity) {
+		body.velocity.y -= GRAVITY * seconds;
+		if (body.velocity.y < -TERMINAL_VELOCITY) body.velocity.y = -TERMINAL_VELOCITY;
+	}
+
+	AABB box = bodyBounds(body);
+	glm::bvec3 blocked;
+	glm::vec3 applied = moveAndCollide(world, box, body.velocity * seconds, blocked);
+	body.position += applied;
+
+	body.onGround = blocked.y && body.velocity.y < 0.0f;
+	for (int axis = 0; axis < 3; axis++) {
+		if (blocked[axis]) body.velocity[axis] = 0.0f;
+	}
+}
@@ -0,0 +1,37 @@
+#ifndef PHYSICS_H
+#define PHYSICS_H
+
+#include "world.h"
+
+#include <vector>
+
+struct AABB {
+	glm::vec3 min;
+	glm::vec3 max;
+};
+
+// Anything that falls and bumps into blocks: the player, mobs, dropped items.
+// position is the centre of the bottom face of the box.
+struct PhysicsBody {
+	glm::vec3 position;
+	glm::vec3 velocity;
+	glm::vec3 halfExtents; // x and z half width, y is the full height
+	bool onGround;
+	bool gravity;
+};
+
+const float GRAVITY = 28.0f;           // blocks per second squared
+const float TERMINAL_VELOCITY = 60.0f; // blocks per second
+
+AABB bodyBounds(const PhysicsBody& body);
+
+// Moves box by motion, stopping at solid blocks. Axes are resolved one at a
+// time (y first, then x, then z) so the box slides along walls and floors.
+// Only blocks inside the swept volume are looked at. Returns the motion that was
+// actually applied, blocked[axis] is set when an axis got cut short.
+glm::vec3 moveAndCollide(const World& world, AABB& box, const glm::vec3& motion, glm::bvec3& blocked);
+
+// One fixed step of gravity plus movement for a body.
+void stepBody(const World& world, PhysicsBody& body, float seconds);
+
+#endif
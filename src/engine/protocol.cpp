@@ -0,0 +1,153 @@
+#include "protocol.h"
+
+#include <cstring>
+
+void ByteWriter::u16(uint16_t value) {
+	out.push_back((uint8_t)value);
+	out.push_back((uint8_t)(value >> 8));
+}
+
+void ByteWriter::u32(uint32_t value) {
+	for (int i = 0; i < 4; i++) out.push_back((uint8_t)(value >> (8 * i)));
+}
+
+void ByteWriter::f32(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, 4);
+	u32(bits);
+}
+
+void ByteWriter::beginFrame(MessageType type) {
+	frameStart = out.size();
+	u32(0); // patched in endFrame
+	u8(type);
+}
+
+void ByteWriter::endFrame() {
+	uint32_t length = (uint32_t)(out.size() - frameStart - 4);
+	for (int i = 0; i < 4; i++) out[frameStart + i] = (uint8_t)(length >> (8 * i));
+}
+
+bool ByteReader::take(size_t count) {
+	if (broken || size - offset < count) {
+		broken = true;
+		return false;
+	}
+	return true;
+}
+
+uint8_t ByteReader::u8() {
+	if (!take(1)) return 0;
+	return data[offset++];
+}
+
+uint16_t ByteReader::u16() {
+	if (!take(2)) return 0;
+	uint16_t value = data[offset] | (data[offset + 1] << 8);
+	offset += 2;
+	return value;
+}
+
+uint32_t ByteReader::u32() {
+	if (!take(4)) return 0;
+	uint32_t value = 0;
+	for (int i = 0; i < 4; i++) value |= (uint32_t)data[offset + i] << (8 * i);
+	offset += 4;
+	return value;
+}
+
+float ByteReader::f32() {
+	uint32_t bits = u32();
+	float value;
+	std::memcpy(&value, &bits, 4);
+	return value;
+}
+
+const uint8_t* ByteReader::bytes(size_t count) {
+	if (!take(count)) return nullptr;
+	const uint8_t* start = data + offset;
+	offset += count;
+	return start;
+}
+
+static int bitsForPalette(int size) {
+	if (size <= 2) return 1;
+	if (size <= 4) return 2;
+	if (size <= 16) return 4;
+	return 8;
+}
+
+void writeSection(ByteWriter& writer, const Chunk& chunk) {
+	// ids straight to palette slots, BlockID fits in a byte so a table does it
+	int slotOf[256];
+	std::memset(slotOf, -1, sizeof(slotOf));
+	uint8_t palette[256];
+	int paletteSize = 0;
+	const BlockID* blocks = chunk.blockData();
+	if (chunk.isUniform()) {
+		palette[paletteSize++] = chunk.uniformBlock();
+	} else {
+		for (int i = 0; i < CHUNK_VOLUME; i++) {
+			if (slotOf[blocks[i]] < 0) {
+				slotOf[blocks[i]] = paletteSize;
+				palette[paletteSize++] = blocks[i];
+			}
+		}
+	}
+	writer.u8((uint8_t)(paletteSize - 1));
+	writer.bytes(palette, paletteSize);
+	if (paletteSize == 1) return;
+
+	int bits = bitsForPalette(paletteSize);
+	int perByte = 8 / bits;
+	uint8_t packed[CHUNK_VOLUME];
+	int byteCount = CHUNK_VOLUME / perByte;
+	std::memset(packed, 0, byteCount);
+	for (int i = 0; i < CHUNK_VOLUME; i++) {
+		packed[i / perByte] |= (uint8_t)(slotOf[blocks[i]] << ((i % perByte) * bits));
+	}
+	writer.bytes(packed, byteCount);
+}
+
+bool readSection(ByteReader& reader, Chunk& chunk) {
+	int paletteSize = reader.u8() + 1;
+	const uint8_t* palette = reader.bytes(paletteSize);
+	if (palette == nullptr) return false;
+	for (int i = 0; i < paletteSize; i++) {
+		if (palette[i] >= BLOCK_COUNT) return false;
+	}
+	if (paletteSize == 1) {
+		chunk.fill(palette[0]);
+		return true;
+	}
+
+	int bits = bitsForPalette(paletteSize);
+	int perByte = 8 / bits;
+	const uint8_t* packed = reader.bytes(CHUNK_VOLUME / perByte);
+	if (packed == nullptr) return false;
+	uint8_t mask = (uint8_t)((1 << bits) - 1);
+	BlockID* blocks = chunk.mutableBlocks();
+	for (int i = 0; i < CHUNK_VOLUME; i++) {
+		int slot = (packed[i / perByte] >> ((i % perByte) * bits)) & mask;
+		if (slot >= paletteSize) return false;
+		blocks[i] = palette[slot];
+	}
+	return true;
+}
+
+bool nextFrame(const std::vector<uint8_t>& buffer, size_t& offset, Frame& frame, bool& error) {
+	error = false;
+	if (buffer.size() - offset < 5) return false;
+	const uint8_t* start = buffer.data() + offset;
+	uint32_t length = start[0] | (start[1] << 8) | (start[2] << 16) | ((uint32_t)start[3] << 24);
+	if (length == 0 || length > MAX_FRAME_SIZE) {
+		error = true;
+		return false;
+	}
+	if (buffer.size() - offset - 4 < length) return false;
+	frame.type = (MessageType)start[4];
+	frame.payload = start + 5;
+	frame.size = length - 1;
+	offset += 4 + length;
+	return true;
+}
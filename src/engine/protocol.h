@@ -0,0 +1,86 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include "world.h"
+
+#include <cstdint>
+#include <vector>
+
+// Wire format shared by the server and clients. Every message is a frame:
+//   u32 length (of everything after it), u8 type, payload
+// All integers are little endian.
+enum MessageType : uint8_t {
+	// client -> server
+	MSG_HELLO = 1,     // u8 view radius in chunks
+	MSG_MOVE = 2,      // f32 x, y, z
+	MSG_SET_BLOCK = 3, // i32 x, y, z, u8 id
+	// server -> client
+	MSG_WELCOME = 16,  // u32 client id, u32 tick
+	MSG_CHUNK = 17,    // i32 cx, cy, cz, section
+	MSG_UNLOAD = 18,   // i32 cx, cy, cz
+	MSG_DELTAS = 19,   // u32 tick, u16 chunks, per chunk: i32 cx, cy, cz, u16 count, count x (u16 index, u8 id)
+};
+
+// frames bigger than this are treated as garbage and drop the connection
+const uint32_t MAX_FRAME_SIZE = 1 << 20;
+
+class ByteWriter {
+public:
+	explicit ByteWriter(std::vector<uint8_t>& out) : out(out), frameStart(0) {}
+
+	void u8(uint8_t value) { out.push_back(value); }
+	void u16(uint16_t value);
+	void u32(uint32_t value);
+	void i32(int32_t value) { u32((uint32_t)value); }
+	void f32(float value);
+	void bytes(const uint8_t* data, size_t size) { out.insert(out.end(), data, data + size); }
+
+	// frames nest nowhere, begin and end always come in pairs
+	void beginFrame(MessageType type);
+	void endFrame();
+
+private:
+	std::vector<uint8_t>& out;
+	size_t frameStart;
+};
+
+// Reads a payload. Running off the end sets failed() and returns zeros
+// instead of throwing, so callers check once at the end.
+class ByteReader {
+public:
+	ByteReader(const uint8_t* data, size_t size) : data(data), size(size), offset(0), broken(false) {}
+
+	uint8_t u8();
+	uint16_t u16();
+	uint32_t u32();
+	int32_t i32() { return (int32_t)u32(); }
+	float f32();
+	const uint8_t* bytes(size_t count);
+
+	bool failed() const { return broken; }
+	size_t remaining() const { return size - offset; }
+
+private:
+	bool take(size_t count);
+
+	const uint8_t* data;
+	size_t size;
+	size_t offset;
+	bool broken;
+};
+
+// Sections go out palette compressed: the distinct ids in the chunk, then one
+// 1, 2, 4 or 8 bit palette index per block. A chunk of a single block type is just its id.
+void writeSection(ByteWriter& writer, const Chunk& chunk);
+bool readSection(ByteReader& reader, Chunk& chunk);
+
+// Splits complete frames off the front of a receive buffer. Returns false once the
+// buffer holds no complete frame, or a broken one (then error is set).
+struct Frame {
+	MessageType type;
+	const uint8_t* payload;
+	size_t size;
+};
+bool nextFrame(const std::vector<uint8_t>& buffer, size_t& offset, Frame& frame, bool& error);
+
+#endif
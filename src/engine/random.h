@@ -0,0 +1,55 @@
+#ifndef RANDOM_H
+#define RANDOM_H
+
+#include "../../include/glm/glm.hpp"
+
+#include <cstdint>
+
+// Counter based random numbers. Every value is a pure function of (seed, position,
+// feature, counter), so there's no generator state to share between threads and
+// no call order that changes the result: a chunk comes out the same whichever
+// thread builds it, and whenever.
+
+// What the numbers are for, so different features at the same spot don't line up.
+enum RandomFeature : uint32_t {
+	FEATURE_TREES = 1,
+	FEATURE_RANDOM_TICK = 2,
+};
+
+// splitmix64's finaliser, every input bit affects every output bit
+inline uint64_t mixBits(uint64_t x) {
+	x ^= x >> 30;
+	x *= 0xBF58476D1CE4E5B9ull;
+	x ^= x >> 27;
+	x *= 0x94D049BB133111EBull;
+	x ^= x >> 31;
+	return x;
+}
+
+inline uint64_t hashPosition(uint64_t seed, const glm::ivec3& position, uint32_t feature) {
+	uint64_t h = mixBits(seed + 0x9E3779B97F4A7C15ull);
+	h = mixBits(h ^ (uint32_t)position.x);
+	h = mixBits(h ^ ((uint64_t)(uint32_t)position.y << 21));
+	h = mixBits(h ^ ((uint64_t)(uint32_t)position.z << 42));
+	return mixBits(h ^ feature);
+}
+
+// A stream of numbers for one (seed, position, feature). Cheap to make, so make
+// one wherever it's needed rather than passing it around.
+class HashRandom {
+public:
+	HashRandom(uint64_t seed, const glm::ivec3& position, uint32_t feature)
+		: key(hashPosition(seed, position, feature)), counter(0) {}
+
+	uint64_t next() { return mixBits(key + 0x9E3779B97F4A7C15ull * ++counter); }
+	// in [0, 1)
+	float unit() { return (next() >> 40) * (1.0f / 16777216.0f); }
+	// in [0, count)
+	int below(int count) { return (int)(((next() >> 32) * (uint64_t)count) >> 32); }
+
+private:
+	uint64_t key;
+	uint64_t counter;
+};
+
+#endif
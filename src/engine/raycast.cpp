@@ -0,0 +1,115 @@
+#include "raycast.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <thread>
+
+RayHit raycast(const World& world, const glm::vec3& origin, const glm::vec3& direction, float maxDistance) {
+	RayHit result = {false, glm::ivec3(0), glm::ivec3(0), BLOCK_AIR, 0.0f, false};
+	float length = glm::length(direction);
+	if (length == 0.0f) return result;
+	glm::vec3 dir = direction / length;
+	const float infinity = std::numeric_limits<float>::infinity();
+
+	glm::ivec3 block((int)std::floor(origin.x), (int)std::floor(origin.y), (int)std::floor(origin.z));
+	glm::ivec3 step;
+	glm::vec3 tMax;   // distance along the ray to the next block boundary on each axis
+	glm::vec3 tDelta; // distance along the ray between two boundaries on each axis
+	for (int axis = 0; axis < 3; axis++) {
+		if (dir[axis] > 0.0f) {
+			step[axis] = 1;
+			tDelta[axis] = 1.0f / dir[axis];
+			tMax[axis] = (block[axis] + 1 - origin[axis]) * tDelta[axis];
+		} else if (dir[axis] < 0.0f) {
+			step[axis] = -1;
+			tDelta[axis] = -1.0f / dir[axis];
+			tMax[axis] = (origin[axis] - block[axis]) * tDelta[axis];
+		} else {
+			step[axis] = 0;
+			tDelta[axis] = infinity;
+			tMax[axis] = infinity;
+		}
+	}
+
+	// cache the chunk we're in, most steps don't leave it. Empty ones are
+	// stepped through like missing ones, without reading their blocks
+	glm::ivec3 chunkPos(floorDiv(block.x, CHUNK_SIZE), floorDiv(block.y, CHUNK_SIZE), floorDiv(block.z, CHUNK_SIZE));
+	const Chunk* chunk = world.getChunk(chunkPos.x, chunkPos.y, chunkPos.z);
+	if (chunk != nullptr && chunk->isEmpty()) chunk = nullptr;
+	glm::ivec3 normal(0);
+	float distance = 0.0f;
+
+	while (true) {
+		if (chunk != nullptr) {
+			BlockID id = chunk->get(block.x - chunkPos.x * CHUNK_SIZE, block.y - chunkPos.y * CHUNK_SIZE, block.z - chunkPos.z * CHUNK_SIZE);
+			if (id != BLOCK_AIR) {
+				result.hit = true;
+				result.block = block;
+				result.normal = normal;
+				result.id = id;
+				result.distance = distance;
+				result.inside = normal == glm::ivec3(0); // only before the first step
+				return result;
+			}
+		}
+
+		int axis = 0;
+		if (tMax[1] < tMax[axis]) axis = 1;
+		if (tMax[2] < tMax[axis]) axis = 2;
+		if (tMax[axis] > maxDistance) break;
+
+		distance = tMax[axis];
+		tMax[axis] += tDelta[axis];
+		block[axis] += step[axis];
+		normal = glm::ivec3(0);
+		normal[axis] = -step[axis];
+
+		int chunkCoord = floorDiv(block[axis], CHUNK_SIZE);
+		if (chunkCoord != chunkPos[axis]) {
+			chunkPos[axis] = chunkCoord;
+			chunk = world.getChunk(chunkPos.x, chunkPos.y, chunkPos.z);
+			if (chunk != nullptr && chunk->isEmpty()) chunk = nullptr;
+		}
+	}
+	result.distance = maxDistance;
+	return result;
+}
+
+void raycastBatch(const World& world, const std::vector<Ray>& rays, std::vector<RayHit>& hits, unsigned int threads) {
+	hits.resize(rays.size());
+	if (threads == 0) threads = std::thread::hardware_concurrency();
+	if (threads == 0) threads = 1;
+	// not worth waking threads for a handful of rays
+	if (threads > rays.size() / 64 + 1) threads = (unsigned int)(rays.size() / 64 + 1);
+
+	auto work = [&](size_t begin, size_t end) {
+		for (size_t i = begin; i < end; i++) {
+			hits[i] = raycast(world, rays[i].origin, rays[i].direction, rays[i].maxDistance);
+		}
+	};
+	if (threads <= 1) {
+		work(0, rays.size());
+		return;
+	}
+
+	std::vector<std::thread> workers;
+	size_t perThread = (rays.size() + threads - 1) / threads;
+	for (unsigned int t = 1; t < threads; t++) {
+		size_t begin = t * perThread;
+		size_t end = std::min(rays.size(), begin + perThread);
+		if (begin >= end) break;
+		workers.emplace_back(work, begin, end);
+	}
+	// this thread takes the first slice itself
+	work(0, std::min(rays.size(), perThread));
+	for (std::thread& worker : workers) worker.join();
+}
+
+bool lineOfSight(const World& world, const glm::vec3& from, const glm::vec3& to) {
+	glm::vec3 delta = to - from;
+	float distance = glm::length(delta);
+	if (distance == 0.0f) return true;
+	RayHit hit = raycast(world, from, delta, distance);
+	return !hit.hit;
+}
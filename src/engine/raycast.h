@@ -0,0 +1,36 @@
+#ifndef RAYCAST_H
+#define RAYCAST_H
+
+#include "world.h"
+
+#include <vector>
+
+struct RayHit {
+	bool hit;
+	glm::ivec3 block;  // world position of the block we hit
+	glm::ivec3 normal; // face we came in through, block + normal is the air in front of it
+	BlockID id;
+	float distance;    // along the (normalised) ray
+	bool inside;       // the ray started in this block, there's no face and normal is zero
+};
+
+struct Ray {
+	glm::vec3 origin;
+	glm::vec3 direction;
+	float maxDistance;
+};
+
+// Amanatides & Woo voxel traversal: visits every block the ray passes through,
+// in order, and stops at the first one that isn't air, which can be the one it
+// starts in (see RayHit::inside). Chunk lookups are cached while the ray stays
+// inside the same chunk.
+RayHit raycast(const World& world, const glm::vec3& origin, const glm::vec3& direction, float maxDistance);
+
+// Casts every ray in rays, split across threads (0 = one per hardware thread).
+// hits is resized to match.
+void raycastBatch(const World& world, const std::vector<Ray>& rays, std::vector<RayHit>& hits, unsigned int threads);
+
+// true when nothing but air lies between the two points
+bool lineOfSight(const World& world, const glm::vec3& from, const glm::vec3& to);
+
+#endif
@@ -0,0 +1,54 @@
+#include "scratch_arena.h"
+
+#include <algorithm>
+#include <cstdint>
+
+static size_t roundUpPowerOfTwo(size_t value) {
+	size_t result = 1;
+	while (result < value) result <<= 1;
+	return result;
+}
+
+ScratchArena::ScratchArena(size_t initialBytes) : offset(0), spilled(0), peak(0) {
+	blocks.reserve(8);
+	blocks.push_back({new unsigned char[initialBytes], initialBytes});
+}
+
+ScratchArena::~ScratchArena() {
+	for (Block& block : blocks) delete[] block.data;
+}
+
+void* ScratchArena::allocateBytes(size_t bytes, size_t alignment) {
+	Block* block = &blocks.back();
+	uintptr_t base = (uintptr_t)block->data;
+	size_t start = ((base + offset + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+	if (start + bytes > block->size) {
+		// out of room, carry on in a new block at least twice as big
+		spilled += offset;
+		size_t size = std::max(block->size * 2, bytes + alignment);
+		blocks.push_back({new unsigned char[size], size});
+		block = &blocks.back();
+		base = (uintptr_t)block->data;
+		start = ((base + alignment - 1) & ~(uintptr_t)(alignment - 1)) - base;
+	}
+	offset = start + bytes;
+	peak = std::max(peak, spilled + offset);
+	return block->data + start;
+}
+
+void ScratchArena::reset() {
+	if (blocks.size() > 1) {
+		size_t size = roundUpPowerOfTwo(peak);
+		for (Block& block : blocks) delete[] block.data;
+		blocks.clear();
+		blocks.push_back({new unsigned char[size], size});
+	}
+	offset = 0;
+	spilled = 0;
+}
+
+size_t ScratchArena::capacity() const {
+	size_t total = 0;
+	for (const Block& block : blocks) total += block.size;
+	return total;
+}
@@ -0,0 +1,43 @@
+#ifndef SCRATCH_ARENA_H
+#define SCRATCH_ARENA_H
+
+#include <cstddef>
+#include <vector>
+
+// Bump allocator for short lived working memory, one per thread. Everything it
+// hands out stays valid until reset(), which frees it all at once. Memory is
+// kept across resets, so once the arena has grown to what a job needs it never
+// goes to the heap again.
+class ScratchArena {
+public:
+	explicit ScratchArena(size_t initialBytes = 64 * 1024);
+	~ScratchArena();
+	ScratchArena(const ScratchArena&) = delete;
+	ScratchArena& operator=(const ScratchArena&) = delete;
+
+	// uninitialised room for count Ts, nothing gets destructed so keep T trivial
+	template <typename T>
+	T* allocate(size_t count) { return static_cast<T*>(allocateBytes(count * sizeof(T), alignof(T))); }
+	void* allocateBytes(size_t bytes, size_t alignment);
+
+	// If the last round spilled over into extra blocks, they're swapped for a
+	// single block big enough for all of it, so the next round fits in one.
+	void reset();
+
+	size_t capacity() const;
+	// most bytes in use at once since the arena was made
+	size_t highWater() const { return peak; }
+
+private:
+	struct Block {
+		unsigned char* data;
+		size_t size;
+	};
+
+	std::vector<Block> blocks; // the last one is being bumped through
+	size_t offset;             // into the last block
+	size_t spilled;            // bytes used in the blocks before the last
+	size_t peak;
+};
+
+#endif
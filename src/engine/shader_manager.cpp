@@ -0,0 +1,261 @@
+#include "shader_manager.h"
+
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <sys/inotify.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// from GL 4.1 / ARB_get_program_binary, glad's 3.3 core header doesn't have them
+static const GLenum PROGRAM_BINARY_RETRIEVABLE_HINT = 0x8257;
+static const GLenum PROGRAM_BINARY_LENGTH = 0x8741;
+static const GLenum NUM_PROGRAM_BINARY_FORMATS = 0x87FE;
+
+// what inotify tells us about, editors that save through a rename included
+static const uint32_t WATCH_EVENTS = IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE;
+
+static bool readFile(const std::string& path, std::string& out) {
+	std::ifstream file(path, std::ios::binary);
+	if (!file) return false;
+	std::stringstream stream;
+	stream << file.rdbuf();
+	out = stream.str();
+	return true;
+}
+
+// FNV-1a, continuing from hash
+static uint64_t hashBytes(uint64_t hash, const char* data, size_t size) {
+	for (size_t i = 0; i < size; i++) hash = (hash ^ (unsigned char)data[i]) * 1099511628211ull;
+	return hash;
+}
+
+static uint64_t hashString(uint64_t hash, const char* text) {
+	// the terminator goes in too, so "ab" + "c" and "a" + "bc" differ
+	return hashBytes(hash, text, text == nullptr ? 0 : std::strlen(text) + 1);
+}
+
+static unsigned int compileStage(GLenum type, const std::string& source, const std::string& path) {
+	unsigned int stage = glCreateShader(type);
+	const char* code = source.c_str();
+	glShaderSource(stage, 1, &code, NULL);
+	glCompileShader(stage);
+	GLint success;
+	glGetShaderiv(stage, GL_COMPILE_STATUS, &success);
+	if (!success) {
+		GLchar infoLog[1024];
+		glGetShaderInfoLog(stage, 1024, NULL, infoLog);
+		std::cout << "Failed to compile " << path << "\n" << infoLog << std::endl;
+		glDeleteShader(stage);
+		return 0;
+	}
+	return stage;
+}
+
+static bool linked(unsigned int program) {
+	GLint success;
+	glGetProgramiv(program, GL_LINK_STATUS, &success);
+	return success != 0;
+}
+
+// the directory inotify should watch for a file, "" for the working directory
+static std::string directoryOf(const std::string& path) {
+	size_t slash = path.find_last_of('/');
+	return slash == std::string::npos ? std::string() : path.substr(0, slash);
+}
+
+ShaderManager::ShaderManager(const std::string& cacheDirectory)
+	: cacheDirectory(cacheDirectory), inotifyFd(-1), getProgramBinary(nullptr), programBinary(nullptr), programParameteri(nullptr), compiled(0), fromCache(0) {
+	if (mkdir(cacheDirectory.c_str(), 0755) != 0 && errno != EEXIST) {
+		std::cout << "Failed to create shader cache " << cacheDirectory << std::endl;
+	}
+	inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+	if (inotifyFd < 0) std::cout << "Shader hot reload is off, inotify isn't available" << std::endl;
+}
+
+ShaderManager::~ShaderManager() {
+	for (auto& program : programs) glDeleteProgram(program->shader.ID);
+	if (inotifyFd >= 0) close(inotifyFd);
+}
+
+void ShaderManager::loadBinaryFunctions(GLADloadproc load) {
+	getProgramBinary = (GetProgramBinaryFn)load("glGetProgramBinary");
+	programBinary = (ProgramBinaryFn)load("glProgramBinary");
+	programParameteri = (ProgramParameteriFn)load("glProgramParameteri");
+	GLint formats = 0;
+	if (getProgramBinary != nullptr) glGetIntegerv(NUM_PROGRAM_BINARY_FORMATS, &formats);
+	// some drivers have the functions but no formats to go with them
+	if (getProgramBinary == nullptr || programBinary == nullptr || programParameteri == nullptr || formats <= 0) {
+		std::cout << "No program binaries, shaders get compiled on every start" << std::endl;
+		getProgramBinary = nullptr;
+		programBinary = nullptr;
+		programParameteri = nullptr;
+	}
+}
+
+Shader& ShaderManager::load(const char* vertexPath, const char* fragmentPath) {
+	std::unique_ptr<Program> program(new Program{vertexPath, fragmentPath, Shader(0), false});
+	program->shader.ID = build(*program);
+	watch(program->vertexPath);
+	watch(program->fragmentPath);
+	programs.push_back(std::move(program));
+	return programs.back()->shader;
+}
+
+Shader& ShaderManager::loadSource(const std::string& name, const std::string& vertexCode, const std::string& fragmentCode) {
+	std::unique_ptr<Program> program(new Program{"", "", Shader(0), false});
+	program->shader.ID = buildSource(name + " (vertex)", vertexCode, name + " (fragment)", fragmentCode);
+	programs.push_back(std::move(program));
+	return programs.back()->shader;
+}
+
+void ShaderManager::watch(const std::string& path) {
+	if (inotifyFd < 0) return;
+	std::string directory = directoryOf(path);
+	for (const auto& entry : watchedDirectories) {
+		if (entry.second == directory) return;
+	}
+	int wd = inotify_add_watch(inotifyFd, directory.empty() ? "." : directory.c_str(), WATCH_EVENTS);
+	if (wd < 0) {
+		std::cout << "Can't watch " << path << " for changes" << std::endl;
+		return;
+	}
+	watchedDirectories[wd] = directory;
+}
+
+unsigned int ShaderManager::build(const Program& program) {
+	std::string vertexCode;
+	std::string fragmentCode;
+	if (!readFile(program.vertexPath, vertexCode) || !readFile(program.fragmentPath, fragmentCode)) {
+		std::cout << "Failed to read " << program.vertexPath << " or " << program.fragmentPath << std::endl;
+		return 0;
+	}
+	return buildSource(program.vertexPath, vertexCode, program.fragmentPath, fragmentCode);
+}
+
+unsigned int ShaderManager::buildSource(const std::string& vertexName, const std::string& vertexCode, const std::string& fragmentName, const std::string& fragmentCode) {
+	std::string cachePath;
+	if (getProgramBinary != nullptr) {
+		// a driver update can change the binary format, so the driver is part of the key
+		uint64_t hash = 1469598103934665603ull;
+		hash = hashString(hash, (const char*)glGetString(GL_RENDERER));
+		hash = hashString(hash, (const char*)glGetString(GL_VERSION));
+		hash = hashString(hash, vertexCode.c_str());
+		hash = hashString(hash, fragmentCode.c_str());
+		char name[32];
+		std::snprintf(name, sizeof(name), "%016llx.bin", (unsigned long long)hash);
+		cachePath = cacheDirectory + "/" + name;
+		unsigned int cached = loadCached(cachePath);
+		if (cached != 0) {
+			fromCache++;
+			return cached;
+		}
+	}
+
+	unsigned int vertex = compileStage(GL_VERTEX_SHADER, vertexCode, vertexName);
+	unsigned int fragment = compileStage(GL_FRAGMENT_SHADER, fragmentCode, fragmentName);
+	unsigned int id = 0;
+	if (vertex != 0 && fragment != 0) {
+		id = glCreateProgram();
+		// has to be set before linking
+		if (programParameteri != nullptr) programParameteri(id, PROGRAM_BINARY_RETRIEVABLE_HINT, GL_TRUE);
+		glAttachShader(id, vertex);
+		glAttachShader(id, fragment);
+		glLinkProgram(id);
+	}
+	glDeleteShader(vertex);
+	glDeleteShader(fragment);
+	if (id == 0) return 0;
+	if (!linked(id)) {
+		GLchar infoLog[1024];
+		glGetProgramInfoLog(id, 1024, NULL, infoLog);
+		std::cout << "Failed to link " << vertexName << " and " << fragmentName << "\n" << infoLog << std::endl;
+		glDeleteProgram(id);
+		return 0;
+	}
+	compiled++;
+	if (!cachePath.empty()) storeCached(id, cachePath);
+	return id;
+}
+
+// A cache file is the binary format as a native u32 followed by the binary. It
+// only ever goes back to the driver that wrote it, so byte order doesn't matter.
+unsigned int ShaderManager::loadCached(const std::string& cachePath) {
+	std::string data;
+	if (!readFile(cachePath, data) || data.size() <= sizeof(uint32_t)) return 0;
+	uint32_t format;
+	std::memcpy(&format, data.data(), sizeof(format));
+	unsigned int id = glCreateProgram();
+	programBinary(id, format, data.data() + sizeof(format), (GLsizei)(data.size() - sizeof(format)));
+	// the driver is free to turn down a binary it wrote itself, then just compile again
+	if (!linked(id)) {
+		glDeleteProgram(id);
+		return 0;
+	}
+	return id;
+}
+
+void ShaderManager::storeCached(unsigned int id, const std::string& cachePath) {
+	GLint length = 0;
+	glGetProgramiv(id, PROGRAM_BINARY_LENGTH, &length);
+	if (length <= 0) return;
+	std::string data(sizeof(uint32_t) + length, '\0');
+	GLenum format = 0;
+	GLsizei written = 0;
+	getProgramBinary(id, length, &written, &format, &data[sizeof(uint32_t)]);
+	if (written <= 0) return;
+	uint32_t format32 = format;
+	std::memcpy(&data[0], &format32, sizeof(format32));
+	data.resize(sizeof(uint32_t) + written);
+
+	// write then rename, so a crash never leaves half a binary behind
+	std::string temporary = cachePath + ".tmp";
+	std::ofstream file(temporary, std::ios::binary);
+	if (!file.write(data.data(), data.size())) {
+		std::cout << "Failed to write " << temporary << std::endl;
+		return;
+	}
+	file.close();
+	if (std::rename(temporary.c_str(), cachePath.c_str()) != 0) {
+		std::cout << "Failed to write " << cachePath << std::endl;
+	}
+}
+
+bool ShaderManager::update() {
+	if (inotifyFd < 0) return false;
+	alignas(inotify_event) char buffer[4096];
+	while (true) {
+		ssize_t got = read(inotifyFd, buffer, sizeof(buffer));
+		if (got <= 0) break;
+		for (ssize_t offset = 0; offset < got;) {
+			const inotify_event* event = reinterpret_cast<const inotify_event*>(buffer + offset);
+			offset += sizeof(inotify_event) + event->len;
+			auto directory = watchedDirectories.find(event->wd);
+			if (directory == watchedDirectories.end() || event->len == 0) continue;
+			std::string path = directory->second.empty() ? std::string(event->name) : directory->second + "/" + event->name;
+			for (auto& program : programs) {
+				if (program->vertexPath.empty()) continue;
+				if (program->vertexPath == path || program->fragmentPath == path) program->dirty = true;
+			}
+		}
+	}
+
+	bool swapped = false;
+	for (auto& program : programs) {
+		if (!program->dirty) continue;
+		program->dirty = false;
+		unsigned int id = build(*program);
+		if (id == 0) {
+			std::cout << "Keeping the old " << program->vertexPath << " program" << std::endl;
+			continue;
+		}
+		glDeleteProgram(program->shader.ID);
+		program->shader.ID = id;
+		swapped = true;
+		std::cout << "Reloaded " << program->vertexPath << " and " << program->fragmentPath << std::endl;
+	}
+	return swapped;
+}
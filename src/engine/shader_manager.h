@@ -0,0 +1,75 @@
+#ifndef SHADER_MANAGER_H
+#define SHADER_MANAGER_H
+
+#include "../../assets/shaders/shader.h"
+
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// Owns the client's shader programs. Linked programs are cached on disk with
+// glGetProgramBinary, keyed by a hash of the sources and the driver, so a normal
+// start doesn't compile anything. The source files are watched with inotify and
+// update() rebuilds and swaps in whatever was edited.
+class ShaderManager {
+public:
+	// cacheDirectory is created if it isn't there yet
+	explicit ShaderManager(const std::string& cacheDirectory);
+	~ShaderManager();
+	ShaderManager(const ShaderManager&) = delete;
+	ShaderManager& operator=(const ShaderManager&) = delete;
+
+	// Program binaries are GL 4.1 (or ARB_get_program_binary), which our 3.3 glad
+	// doesn't load, so they're looked up the way glad does it. Without them every
+	// program is compiled from source and nothing is cached.
+	void loadBinaryFunctions(GLADloadproc load);
+
+	// The shader lives as long as the manager. Its ID changes when it's reloaded,
+	// so hold on to the reference rather than copying it.
+	Shader& load(const char* vertexPath, const char* fragmentPath);
+
+	// For sources that don't come from loose files, an asset archive say. Still
+	// cached, but there's nothing to watch so it never reloads.
+	Shader& loadSource(const std::string& name, const std::string& vertexCode, const std::string& fragmentCode);
+
+	// Rebuilds every program whose files changed since the last call. A program
+	// that fails to compile keeps running the old version. True when something
+	// was swapped, uniforms that were only set once need setting again.
+	bool update();
+
+	int compiledCount() const { return compiled; }
+	int cachedCount() const { return fromCache; }
+
+private:
+	typedef void (APIENTRYP GetProgramBinaryFn)(GLuint program, GLsizei bufSize, GLsizei* length, GLenum* binaryFormat, void* binary);
+	typedef void (APIENTRYP ProgramBinaryFn)(GLuint program, GLenum binaryFormat, const void* binary, GLsizei length);
+	typedef void (APIENTRYP ProgramParameteriFn)(GLuint program, GLenum pname, GLint value);
+
+	struct Program {
+		std::string vertexPath; // both empty for programs from loadSource
+		std::string fragmentPath;
+		Shader shader;
+		bool dirty;
+	};
+
+	// 0 when it didn't compile or link
+	unsigned int build(const Program& program);
+	unsigned int buildSource(const std::string& vertexName, const std::string& vertexCode, const std::string& fragmentName, const std::string& fragmentCode);
+	unsigned int loadCached(const std::string& cachePath);
+	void storeCached(unsigned int id, const std::string& cachePath);
+	void watch(const std::string& path);
+
+	std::string cacheDirectory;
+	std::vector<std::unique_ptr<Program>> programs;
+	int inotifyFd;
+	// inotify watch descriptor to the directory it watches
+	std::unordered_map<int, std::string> watchedDirectories;
+	GetProgramBinaryFn getProgramBinary;
+	ProgramBinaryFn programBinary;
+	ProgramParameteriFn programParameteri;
+	int compiled;
+	int fromCache;
+};
+
+#endif
@@ -0,0 +1,170 @@
+#include "simulation.h"
+#include "raycast.h"
+
+// speeds in blocks per second
+static const float WALK_SPEED = 4.3f;
+static const float FLY_SPEED = 10.0f;
+static const float JUMP_VELOCITY = 8.5f;
+static const float TICK_SECONDS = 1.0f / Simulation::TICKS_PER_SECOND;
+// player box is 0.6 x 1.8 x 0.6 with the eyes a bit below the top
+static const glm::vec3 PLAYER_EXTENTS = glm::vec3(0.3f, 1.8f, 0.3f);
+static const float EYE_HEIGHT = 1.62f;
+
+Simulation::Simulation(World& world, const glm::vec3& spawn, uint64_t seed)
+	: world(world), editor(world), input(), seed(seed), tickCount(0) {
+	input.front = glm::vec3(0.0f, 0.0f, -1.0f);
+	input.up = glm::vec3(0.0f, 1.0f, 0.0f);
+	player.position = spawn - glm::vec3(0.0f, EYE_HEIGHT, 0.0f);
+	player.velocity = glm::vec3(0.0f);
+	player.halfExtents = PLAYER_EXTENTS;
+	player.onGround = false;
+	player.gravity = true;
+	previousPosition = player.position;
+	flying = false;
+	entityThreads = 0;
+	inventory.fill(0);
+}
+
+void Simulation::setInput(const PlayerInput& next) {
+	bool breakBlock = input.breakBlock || next.breakBlock;
+	bool placeBlock = input.placeBlock || next.placeBlock;
+	bool toggleFlying = input.toggleFlying || next.toggleFlying;
+	input = next;
+	input.breakBlock = breakBlock;
+	input.placeBlock = placeBlock;
+	input.toggleFlying = toggleFlying;
+}
+
+void Simulation::tick() {
+	movePlayer();
+	useBlocks();
+	updateEntities();
+	randomTicks();
+	tickCount++;
+}
+
+void Simulation::movePlayer() {
+	previousPosition = player.position;
+	if (input.toggleFlying) {
+		flying = !flying;
+		player.gravity = !flying;
+		player.velocity = glm::vec3(0.0f);
+		input.toggleFlying = false;
+	}
+
+	// walking only steers along the ground, whichever way we're looking
+	glm::vec3 forward = glm::vec3(input.front.x, 0.0f, input.front.z);
+	if (glm::length(forward) > 0.0f) forward = glm::normalize(forward);
+	glm::vec3 side = glm::normalize(glm::cross(forward, input.up));
+	glm::vec3 wish(0.0f);
+	if (input.forward) wish += forward;
+	if (input.back) wish -= forward;
+	if (input.left) wish -= side;
+	if (input.right) wish += side;
+	if (glm::length(wish) > 0.0f) wish = glm::normalize(wish);
+
+	float speed = flying ? FLY_SPEED : WALK_SPEED;
+	player.velocity.x = wish.x * speed;
+	player.velocity.z = wish.z * speed;
+	if (flying) {
+		player.velocity.y = 0.0f;
+		if (input.jump) player.velocity.y += speed;
+		if (input.sneak) player.velocity.y -= speed;
+	} else if (input.jump && player.onGround) {
+		player.velocity.y = JUMP_VELOCITY;
+	}
+	stepBody(world, player, TICK_SECONDS);
+}
+
+void Simulation::useBlocks() {
+	if (!input.breakBlock && !input.placeBlock) return;
+	glm::vec3 eye = player.position + glm::vec3(0.0f, EYE_HEIGHT, 0.0f);
+	RayHit hit = raycast(world, eye, input.front, REACH);
+	if (hit.hit) {
+		if (input.breakBlock) {
+			BlockID broken = hit.id;
+			if (editor.setBlock(hit.block, BLOCK_AIR)) {
+				spawnItem(entities, glm::vec3(hit.block) + glm::vec3(0.5f, 0.25f, 0.5f), broken);
+			}
+		} else if (!hit.inside) {
+			// no face to place against from inside a block, and don't wall ourselves in
+			glm::ivec3 target = hit.block + hit.normal;
+			AABB box = bodyBounds(player);
+			bool insidePlayer = box.max.x > target.x && box.min.x < target.x + 1
+				&& box.max.y > target.y && box.min.y < target.y + 1
+				&& box.max.z > target.z && box.min.z < target.z + 1;
+			if (!insidePlayer) editor.setBlock(target, input.placeId);
+		}
+	}
+	input.breakBlock = false;
+	input.placeBlock = false;
+}
+
+void Simulation::updateEntities() {
+	steerWanderers(entities, entityThreads);
+	stepBodies(entities, world, TICK_SECONDS, entityThreads);
+
+	scratch.clear();
+	ageItems(entities, scratch);
+	for (Entity entity : scratch) entities.destroy(entity);
+
+	buildSpatialHash(entities, grid);
+	pickUpItems();
+}
+
+void Simulation::pickUpItems() {
+	// measured from the middle of the player, so items by our feet still count
+	glm::vec3 centre = player.position + glm::vec3(0.0f, player.halfExtents.y * 0.5f, 0.0f);
+	scratch.clear();
+	grid.query(centre, ITEM_PICKUP_RADIUS + player.halfExtents.y * 0.5f, scratch);
+	for (Entity entity : scratch) {
+		ItemDrop* item = entities.get<ItemDrop>(entity);
+		if (item == nullptr || item->age < 10) continue;
+		inventory[item->id]++;
+		entities.destroy(entity);
+	}
+}
+
+glm::vec3 Simulation::playerPosition(float alpha) const {
+	glm::vec3 feet = previousPosition + (player.position - previousPosition) * alpha;
+	return feet + glm::vec3(0.0f, EYE_HEIGHT, 0.0f);
+}
+
+void Simulation::randomTicks() {
+	// the tick number goes into the key, so each tick picks different blocks
+	uint64_t tickSeed = seed ^ mixBits(tickCount);
+	ConstBlockAccess blocks(world);
+	for (const auto& entry : world.allChunks()) {
+		Chunk& chunk = *entry.chunk;
+		// a uniform section of anything but grass or dirt has nothing that ticks
+		if (chunk.isUniform() && chunk.uniformBlock() != BLOCK_GRASS && chunk.uniformBlock() != BLOCK_DIRT) continue;
+		HashRandom random(tickSeed, chunk.position, FEATURE_RANDOM_TICK);
+		for (int i = 0; i < RANDOM_TICKS_PER_CHUNK; i++) {
+			int index = random.below(CHUNK_VOLUME);
+			randomTick(chunk, index % CHUNK_SIZE, index / CHUNK_AREA, (index / CHUNK_SIZE) % CHUNK_SIZE, random, blocks);
+		}
+	}
+}
+
+void Simulation::randomTick(Chunk& chunk, int x, int y, int z, HashRandom& random, ConstBlockAccess& blocks) {
+	BlockID id = chunk.get(x, y, z);
+	if (id != BLOCK_GRASS && id != BLOCK_DIRT) return;
+
+	glm::ivec3 worldPos = chunk.position * CHUNK_SIZE + glm::ivec3(x, y, z);
+	bool covered = isOpaque(blocks.getBlock(worldPos.x, worldPos.y + 1, worldPos.z));
+	if (id == BLOCK_GRASS) {
+		// grass dies off under anything solid
+		if (covered) editor.setBlock(worldPos, BLOCK_DIRT);
+		return;
+	}
+	if (covered) return;
+	// bare dirt next to grass slowly grows over
+	// drawn one at a time, argument evaluation order isn't fixed and the result has to be
+	int dx = random.below(3) - 1;
+	int dy = random.below(3) - 1;
+	int dz = random.below(3) - 1;
+	glm::ivec3 from = worldPos + glm::ivec3(dx, dy, dz);
+	if (blocks.getBlock(from.x, from.y, from.z) == BLOCK_GRASS) {
+		editor.setBlock(worldPos, BLOCK_GRASS);
+	}
+}
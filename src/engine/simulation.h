@@ -0,0 +1,85 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "entities.h"
+#include "random.h"
+#include "world_edit.h"
+
+#include <array>
+#include <cstdint>
+#include <vector>
+
+// What the player wants to do this tick, sampled from the keyboard every frame.
+struct PlayerInput {
+	bool forward;
+	bool back;
+	bool left;
+	bool right;
+	bool jump; // flies up instead while flying
+	bool sneak; // flies down while flying
+	glm::vec3 front;
+	glm::vec3 up;
+	// one shot actions, they stay set until a tick has handled them
+	bool breakBlock;
+	bool placeBlock;
+	bool toggleFlying;
+	BlockID placeId;
+};
+
+// Everything that moves the world forward in time. Only ever advanced in whole
+// fixed length ticks, so the result doesn't depend on the frame rate.
+class Simulation {
+public:
+	static const int TICKS_PER_SECOND = 20;
+	// blocks picked for a random tick per chunk per tick
+	static const int RANDOM_TICKS_PER_CHUNK = 3;
+	// how far away the player can break and place blocks
+	static constexpr float REACH = 6.0f;
+
+	// spawn is where the player's eyes start out. The seed drives random ticks,
+	// which come out the same for a given seed whatever order chunks are visited in.
+	Simulation(World& world, const glm::vec3& spawn, uint64_t seed);
+
+	void setInput(const PlayerInput& input);
+	void tick();
+
+	// player eye position blended between the last two ticks, alpha in [0, 1)
+	glm::vec3 playerPosition(float alpha) const;
+	const PhysicsBody& playerBody() const { return player; }
+	bool isFlying() const { return flying; }
+	// chunks whose blocks changed since the last call, including neighbours that share a changed face
+	void takeChangedChunks(std::vector<glm::ivec3>& out) { editor.takeDirtyChunks(out); }
+	void takeChangedRegions(std::vector<DirtyRegion>& out) { editor.takeDirtyRegions(out); }
+	WorldEditor& edits() { return editor; }
+	EntityRegistry& entityRegistry() { return entities; }
+	const SpatialHash& entityGrid() const { return grid; }
+	// how many of each block the player has picked up
+	uint32_t inventoryCount(BlockID id) const { return inventory[id]; }
+	// threads used by the entity systems, 0 = one per core
+	void setEntityThreads(unsigned threads) { entityThreads = threads; }
+	uint64_t ticks() const { return tickCount; }
+
+private:
+	void movePlayer();
+	void useBlocks();
+	void updateEntities();
+	void pickUpItems();
+	void randomTicks();
+	void randomTick(Chunk& chunk, int x, int y, int z, HashRandom& random, ConstBlockAccess& blocks);
+
+	World& world;
+	WorldEditor editor;
+	PlayerInput input;
+	PhysicsBody player;
+	glm::vec3 previousPosition; // feet position before the last tick
+	bool flying;
+	EntityRegistry entities;
+	SpatialHash grid;
+	std::vector<Entity> scratch;
+	unsigned entityThreads;
+	std::array<uint32_t, BLOCK_COUNT> inventory;
+	uint64_t seed;
+	uint64_t tickCount;
+};
+
+#endif
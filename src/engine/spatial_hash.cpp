@@ -0,0 +1,44 @@
+#include "spatial_hash.h"
+
+#include <cmath>
+
+static glm::ivec3 cellOf(const glm::vec3& position) {
+	return glm::ivec3(floorDiv((int)std::floor(position.x), CHUNK_SIZE),
+		floorDiv((int)std::floor(position.y), CHUNK_SIZE),
+		floorDiv((int)std::floor(position.z), CHUNK_SIZE));
+}
+
+void SpatialHash::clear() {
+	// cells nobody moved into since the last rebuild go away for good
+	for (auto it = cells.begin(); it != cells.end();) {
+		if (it->second.empty()) {
+			it = cells.erase(it);
+		} else {
+			it->second.clear();
+			++it;
+		}
+	}
+}
+
+void SpatialHash::insert(Entity entity, const glm::vec3& position) {
+	glm::ivec3 cell = cellOf(position);
+	cells[chunkKey(cell.x, cell.y, cell.z)].push_back({entity, position});
+}
+
+void SpatialHash::query(const glm::vec3& centre, float radius, std::vector<Entity>& out) const {
+	glm::ivec3 first = cellOf(centre - radius);
+	glm::ivec3 last = cellOf(centre + radius);
+	float radiusSquared = radius * radius;
+	for (int cy = first.y; cy <= last.y; cy++) {
+		for (int cz = first.z; cz <= last.z; cz++) {
+			for (int cx = first.x; cx <= last.x; cx++) {
+				auto found = cells.find(chunkKey(cx, cy, cz));
+				if (found == cells.end()) continue;
+				for (const Entry& entry : found->second) {
+					glm::vec3 offset = entry.position - centre;
+					if (glm::dot(offset, offset) <= radiusSquared) out.push_back(entry.entity);
+				}
+			}
+		}
+	}
+}
@@ -0,0 +1,29 @@
+#ifndef SPATIAL_HASH_H
+#define SPATIAL_HASH_H
+
+#include "ecs.h"
+#include "world.h"
+
+#include <unordered_map>
+#include <vector>
+
+// Buckets entity positions by the chunk they're in, so finding what's near
+// something only looks at the few chunks around it. Rebuilt every tick.
+class SpatialHash {
+public:
+	// empties every cell but keeps their memory for the next rebuild
+	void clear();
+	void insert(Entity entity, const glm::vec3& position);
+	// every entity within radius of centre, appended to out
+	void query(const glm::vec3& centre, float radius, std::vector<Entity>& out) const;
+	size_t cellCount() const { return cells.size(); }
+
+private:
+	struct Entry {
+		Entity entity;
+		glm::vec3 position;
+	};
+	std::unordered_map<uint64_t, std::vector<Entry>> cells;
+};
+
+#endif
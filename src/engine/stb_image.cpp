@@ -0,0 +1,3 @@
+// The one place stb_image gets compiled, shared by the client and the server.
+#define STB_IMAGE_IMPLEMENTATION
+#include "../../include/stb_image.h"
@@ -0,0 +1,66 @@
+#include "texture_array.h"
+
+#include "../../include/glad/glad.h"
+
+#include <cstring>
+
+// from EXT_texture_compression_s3tc and ARB_texture_compression_bptc, not in glad's 3.3 core
+static const GLenum COMPRESSED_RGB_S3TC_DXT1 = 0x83F0;
+static const GLenum COMPRESSED_RGBA_S3TC_DXT5 = 0x83F3;
+static const GLenum COMPRESSED_RGBA_BPTC_UNORM = 0x8E8C;
+
+static GLenum internalFormat(TextureFormat format) {
+	switch (format) {
+	case TEXTURE_BC1: return COMPRESSED_RGB_S3TC_DXT1;
+	case TEXTURE_BC3: return COMPRESSED_RGBA_S3TC_DXT5;
+	case TEXTURE_BC7: return COMPRESSED_RGBA_BPTC_UNORM;
+	default: return GL_RGBA8;
+	}
+}
+
+static bool hasExtension(const char* name) {
+	GLint count = 0;
+	glGetIntegerv(GL_NUM_EXTENSIONS, &count);
+	for (GLint i = 0; i < count; i++) {
+		const char* extension = (const char*)glGetStringi(GL_EXTENSIONS, i);
+		if (extension != nullptr && std::strcmp(extension, name) == 0) return true;
+	}
+	return false;
+}
+
+bool textureFormatSupported(TextureFormat format) {
+	switch (format) {
+	case TEXTURE_BC1:
+	case TEXTURE_BC3:
+		return hasExtension("GL_EXT_texture_compression_s3tc");
+	case TEXTURE_BC7:
+		// core since 4.2, glad only knows about 3.3 so ask for the extension
+		return hasExtension("GL_ARB_texture_compression_bptc");
+	default:
+		return true;
+	}
+}
+
+unsigned int uploadTextureArray(const TextureArrayView& data) {
+	unsigned int texture;
+	glGenTextures(1, &texture);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, texture);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MIN_FILTER, GL_NEAREST_MIPMAP_LINEAR);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D_ARRAY, GL_TEXTURE_MAX_LEVEL, data.levelCount - 1);
+	// rows of small mip levels aren't 4 byte aligned
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	for (int level = 0; level < data.levelCount; level++) {
+		int size = data.levelSize(level);
+		if (data.format == TEXTURE_RGBA8) {
+			glTexImage3D(GL_TEXTURE_2D_ARRAY, level, GL_RGBA8, size, size, data.layerCount, 0, GL_RGBA, GL_UNSIGNED_BYTE, data.levels[level]);
+		} else {
+			glCompressedTexImage3D(GL_TEXTURE_2D_ARRAY, level, internalFormat(data.format), size, size, data.layerCount, 0, (GLsizei)data.levelBytes[level], data.levels[level]);
+		}
+	}
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+	glBindTexture(GL_TEXTURE_2D_ARRAY, 0);
+	return texture;
+}
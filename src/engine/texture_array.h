@@ -0,0 +1,14 @@
+#ifndef TEXTURE_ARRAY_H
+#define TEXTURE_ARRAY_H
+
+#include "asset_loader.h"
+
+// Creates a GL_TEXTURE_2D_ARRAY from already mipmapped layers, one upload per
+// mip level for all the layers together, straight from wherever the view points.
+// Nearest filtering up close so the block textures stay crisp, mipmapped further
+// away.
+unsigned int uploadTextureArray(const TextureArrayView& data);
+// whether the driver can sample the format, RGBA8 always can
+bool textureFormatSupported(TextureFormat format);
+
+#endif
@@ -0,0 +1,651 @@
+#include "texture_compression.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <thread>
+
+// BC7's 4 bit interpolation weights, out of 64
+static const int BC7_WEIGHTS[16] = {0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64};
+// and its 2 bit ones
+static const int BC7_WEIGHTS2[4] = {0, 21, 43, 64};
+// where each BC1 index sits between the two endpoints
+static const float BC1_POSITIONS[4] = {0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f};
+
+size_t textureBlockBytes(TextureFormat format) {
+	switch (format) {
+	case TEXTURE_BC1: return 8;
+	case TEXTURE_BC3: return 16;
+	case TEXTURE_BC7: return 16;
+	default: return 4;
+	}
+}
+
+size_t textureLevelBytes(TextureFormat format, int size, int layerCount) {
+	if (format == TEXTURE_RGBA8) return (size_t)size * size * 4 * layerCount;
+	size_t blocks = (size_t)(size + 3) / 4;
+	return blocks * blocks * textureBlockBytes(format) * layerCount;
+}
+
+// Direction the texels spread out along the most: power iteration on their
+// covariance. Works on the first channels of each texel.
+static void principalAxis(const float texels[16][4], int channels, float* mean, float* axis) {
+	for (int c = 0; c < channels; c++) {
+		mean[c] = 0.0f;
+		for (int i = 0; i < 16; i++) mean[c] += texels[i][c];
+		mean[c] /= 16.0f;
+	}
+	float covariance[4][4] = {};
+	for (int i = 0; i < 16; i++) {
+		for (int a = 0; a < channels; a++) {
+			for (int b = 0; b < channels; b++) covariance[a][b] += (texels[i][a] - mean[a]) * (texels[i][b] - mean[b]);
+		}
+	}
+	for (int c = 0; c < channels; c++) axis[c] = 1.0f;
+	for (int iteration = 0; iteration < 8; iteration++) {
+		float next[4] = {};
+		float length = 0.0f;
+		for (int a = 0; a < channels; a++) {
+			for (int b = 0; b < channels; b++) next[a] += covariance[a][b] * axis[b];
+			length += next[a] * next[a];
+		}
+		// every texel the same, any axis will do
+		if (length < 1e-12f) return;
+		length = std::sqrt(length);
+		for (int c = 0; c < channels; c++) axis[c] = next[c] / length;
+	}
+}
+
+// Both ends of the texels' spread along the axis.
+static void axisEndpoints(const float texels[16][4], int channels, const float* mean, const float* axis, float* low, float* high) {
+	float lo = 0.0f;
+	float hi = 0.0f;
+	for (int i = 0; i < 16; i++) {
+		float t = 0.0f;
+		for (int c = 0; c < channels; c++) t += (texels[i][c] - mean[c]) * axis[c];
+		lo = std::min(lo, t);
+		hi = std::max(hi, t);
+	}
+	for (int c = 0; c < channels; c++) {
+		low[c] = mean[c] + axis[c] * lo;
+		high[c] = mean[c] + axis[c] * hi;
+	}
+}
+
+// Endpoints that best fit the texels for the given positions between them (0 at
+// the first, 1 at the second), by least squares. False if the positions don't
+// pin both ends down.
+static bool leastSquares(const float texels[16][4], int channels, const float* positions, float* first, float* second) {
+	float aa = 0.0f, ab = 0.0f, bb = 0.0f;
+	float ax[4] = {}, bx[4] = {};
+	for (int i = 0; i < 16; i++) {
+		float b = positions[i];
+		float a = 1.0f - b;
+		aa += a * a;
+		ab += a * b;
+		bb += b * b;
+		for (int c = 0; c < channels; c++) {
+			ax[c] += a * texels[i][c];
+			bx[c] += b * texels[i][c];
+		}
+	}
+	float determinant = aa * bb - ab * ab;
+	if (std::fabs(determinant) < 1e-6f) return false;
+	for (int c = 0; c < channels; c++) {
+		first[c] = std::min(255.0f, std::max(0.0f, (ax[c] * bb - bx[c] * ab) / determinant));
+		second[c] = std::min(255.0f, std::max(0.0f, (bx[c] * aa - ax[c] * ab) / determinant));
+	}
+	return true;
+}
+
+static void readTexels(const unsigned char* rgba, float texels[16][4]) {
+	for (int i = 0; i < 16; i++) {
+		for (int c = 0; c < 4; c++) texels[i][c] = rgba[i * 4 + c];
+	}
+}
+
+// the ends along the principal axis can fall outside 0..255, clamp before packing
+static int quantise(float value, int levels) {
+	return std::min(levels, std::max(0, (int)std::lround(value * levels / 255.0f)));
+}
+
+static uint16_t to565(const float* colour) {
+	return (uint16_t)((quantise(colour[0], 31) << 11) | (quantise(colour[1], 63) << 5) | quantise(colour[2], 31));
+}
+
+static void from565(uint16_t packed, int* colour) {
+	int r = (packed >> 11) & 31;
+	int g = (packed >> 5) & 63;
+	int b = packed & 31;
+	colour[0] = (r << 3) | (r >> 2);
+	colour[1] = (g << 2) | (g >> 4);
+	colour[2] = (b << 3) | (b >> 2);
+}
+
+// the four colours of a 4 colour mode block
+static void bc1Palette(uint16_t c0, uint16_t c1, int palette[4][3]) {
+	from565(c0, palette[0]);
+	from565(c1, palette[1]);
+	for (int c = 0; c < 3; c++) {
+		palette[2][c] = (2 * palette[0][c] + palette[1][c]) / 3;
+		palette[3][c] = (palette[0][c] + 2 * palette[1][c]) / 3;
+	}
+}
+
+struct ColourBlock {
+	uint16_t c0;
+	uint16_t c1;
+	uint8_t indices[16];
+};
+
+// Quantises the endpoints and picks the nearest palette entry for every texel,
+// returns the squared error.
+static float fitColour(const float texels[16][4], const float* first, const float* second, ColourBlock& block) {
+	block.c0 = to565(first);
+	block.c1 = to565(second);
+	// 4 colour mode needs c0 > c1, swapping the ends just swaps the indices around
+	if (block.c0 < block.c1) std::swap(block.c0, block.c1);
+	int palette[4][3];
+	bc1Palette(block.c0, block.c1, palette);
+	// with c0 == c1 only index 0 means that colour
+	int entries = block.c0 == block.c1 ? 1 : 4;
+	float total = 0.0f;
+	for (int i = 0; i < 16; i++) {
+		float best = 1e30f;
+		for (int k = 0; k < entries; k++) {
+			float error = 0.0f;
+			for (int c = 0; c < 3; c++) {
+				float d = texels[i][c] - palette[k][c];
+				error += d * d;
+			}
+			if (error < best) {
+				best = error;
+				block.indices[i] = (uint8_t)k;
+			}
+		}
+		total += best;
+	}
+	return total;
+}
+
+static void encodeColour(const unsigned char* rgba, unsigned char* out) {
+	float texels[16][4];
+	readTexels(rgba, texels);
+	float mean[4], axis[4], first[4], second[4];
+	principalAxis(texels, 3, mean, axis);
+	axisEndpoints(texels, 3, mean, axis, first, second);
+	ColourBlock block;
+	float best = fitColour(texels, first, second, block);
+	// refit the ends to the chosen indices, keep going while it helps
+	for (int iteration = 0; iteration < 2 && block.c0 != block.c1; iteration++) {
+		float positions[16];
+		for (int i = 0; i < 16; i++) positions[i] = BC1_POSITIONS[block.indices[i]];
+		if (!leastSquares(texels, 3, positions, first, second)) break;
+		ColourBlock refined;
+		float error = fitColour(texels, first, second, refined);
+		if (error >= best) break;
+		best = error;
+		block = refined;
+	}
+	uint32_t indices = 0;
+	for (int i = 0; i < 16; i++) indices |= (uint32_t)block.indices[i] << (2 * i);
+	out[0] = (unsigned char)block.c0;
+	out[1] = (unsigned char)(block.c0 >> 8);
+	out[2] = (unsigned char)block.c1;
+	out[3] = (unsigned char)(block.c1 >> 8);
+	for (int i = 0; i < 4; i++) out[4 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+void encodeBC1(const unsigned char* rgba, unsigned char* out) {
+	encodeColour(rgba, out);
+}
+
+// BC4 with the 8 value mode: the two ends plus six steps in between
+static void alphaPalette(int a0, int a1, int palette[8]) {
+	palette[0] = a0;
+	palette[1] = a1;
+	if (a0 > a1) {
+		for (int k = 1; k <= 6; k++) palette[k + 1] = ((7 - k) * a0 + k * a1) / 7;
+	} else {
+		for (int k = 1; k <= 4; k++) palette[k + 1] = ((5 - k) * a0 + k * a1) / 5;
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+}
+
+static void encodeAlpha(const unsigned char* rgba, unsigned char* out) {
+	int high = 0;
+	int low = 255;
+	for (int i = 0; i < 16; i++) {
+		high = std::max(high, (int)rgba[i * 4 + 3]);
+		low = std::min(low, (int)rgba[i * 4 + 3]);
+	}
+	int palette[8];
+	alphaPalette(high, low, palette);
+	uint64_t indices = 0;
+	for (int i = 0; i < 16; i++) {
+		int alpha = rgba[i * 4 + 3];
+		int best = 0;
+		// a flat block only ever needs index 0
+		for (int k = 1; k < 8 && high != low; k++) {
+			if (std::abs(palette[k] - alpha) < std::abs(palette[best] - alpha)) best = k;
+		}
+		indices |= (uint64_t)best << (3 * i);
+	}
+	out[0] = (unsigned char)high;
+	out[1] = (unsigned char)low;
+	for (int i = 0; i < 6; i++) out[2 + i] = (unsigned char)(indices >> (8 * i));
+}
+
+void encodeBC3(const unsigned char* rgba, unsigned char* out) {
+	encodeAlpha(rgba, out);
+	encodeColour(rgba, out + 8);
+}
+
+struct Mode6Block {
+	int endpoints[2][4]; // 7 bits each
+	int pbits[2];
+	uint8_t indices[16];
+};
+
+static void mode6Palette(const Mode6Block& block, int palette[16][4]) {
+	for (int c = 0; c < 4; c++) {
+		int e0 = (block.endpoints[0][c] << 1) | block.pbits[0];
+		int e1 = (block.endpoints[1][c] << 1) | block.pbits[1];
+		for (int k = 0; k < 16; k++) palette[k][c] = ((64 - BC7_WEIGHTS[k]) * e0 + BC7_WEIGHTS[k] * e1 + 32) >> 6;
+	}
+}
+
+// Tries all four p-bit pairs for the endpoints, keeps the one with the least error.
+static float fitMode6(const float texels[16][4], const float* first, const float* second, Mode6Block& best) {
+	float bestError = 1e30f;
+	for (int pbits = 0; pbits < 4; pbits++) {
+		Mode6Block block;
+		block.pbits[0] = pbits & 1;
+		block.pbits[1] = pbits >> 1;
+		for (int c = 0; c < 4; c++) {
+			block.endpoints[0][c] = std::min(127, std::max(0, (int)std::lround((first[c] - block.pbits[0]) / 2.0f)));
+			block.endpoints[1][c] = std::min(127, std::max(0, (int)std::lround((second[c] - block.pbits[1]) / 2.0f)));
+		}
+		int palette[16][4];
+		mode6Palette(block, palette);
+		float total = 0.0f;
+		for (int i = 0; i < 16 && total < bestError; i++) {
+			float nearest = 1e30f;
+			for (int k = 0; k < 16; k++) {
+				float error = 0.0f;
+				for (int c = 0; c < 4; c++) {
+					float d = texels[i][c] - palette[k][c];
+					error += d * d;
+				}
+				if (error < nearest) {
+					nearest = error;
+					block.indices[i] = (uint8_t)k;
+				}
+			}
+			total += nearest;
+		}
+		if (total < bestError) {
+			bestError = total;
+			best = block;
+		}
+	}
+	return bestError;
+}
+
+// Writes bits from the lowest up, the way BC7 blocks are laid out.
+struct BitWriter {
+	unsigned char* out;
+	int bit;
+
+	void put(uint32_t value, int count) {
+		for (int i = 0; i < count; i++, bit++) {
+			if (value & (1u << i)) out[bit / 8] |= (unsigned char)(1 << (bit % 8));
+		}
+	}
+};
+
+struct BitReader {
+	const unsigned char* in;
+	int bit;
+
+	uint32_t get(int count) {
+		uint32_t value = 0;
+		for (int i = 0; i < count; i++, bit++) value |= (uint32_t)((in[bit / 8] >> (bit % 8)) & 1) << i;
+		return value;
+	}
+};
+
+struct Mode5Block {
+	int colours[2][3]; // 7 bits each
+	int alphas[2];
+	uint8_t colourIndices[16];
+	uint8_t alphaIndices[16];
+};
+
+static void mode5Colours(const Mode5Block& block, int colours[4][3]) {
+	for (int c = 0; c < 3; c++) {
+		int e0 = (block.colours[0][c] << 1) | (block.colours[0][c] >> 6);
+		int e1 = (block.colours[1][c] << 1) | (block.colours[1][c] >> 6);
+		for (int k = 0; k < 4; k++) colours[k][c] = ((64 - BC7_WEIGHTS2[k]) * e0 + BC7_WEIGHTS2[k] * e1 + 32) >> 6;
+	}
+}
+
+static void mode5Alphas(const Mode5Block& block, int alphas[4]) {
+	for (int k = 0; k < 4; k++) alphas[k] = ((64 - BC7_WEIGHTS2[k]) * block.alphas[0] + BC7_WEIGHTS2[k] * block.alphas[1] + 32) >> 6;
+}
+
+// Quantises the colour ends and picks every texel's nearest colour, returns the
+// squared colour error.
+static float fitMode5Colour(const float texels[16][4], const float* first, const float* second, Mode5Block& block) {
+	for (int c = 0; c < 3; c++) {
+		block.colours[0][c] = quantise(first[c], 127);
+		block.colours[1][c] = quantise(second[c], 127);
+	}
+	int colours[4][3];
+	mode5Colours(block, colours);
+	float total = 0.0f;
+	for (int i = 0; i < 16; i++) {
+		float nearest = 1e30f;
+		for (int k = 0; k < 4; k++) {
+			float error = 0.0f;
+			for (int c = 0; c < 3; c++) {
+				float d = texels[i][c] - colours[k][c];
+				error += d * d;
+			}
+			if (error < nearest) {
+				nearest = error;
+				block.colourIndices[i] = (uint8_t)k;
+			}
+		}
+		total += nearest;
+	}
+	return total;
+}
+
+// Mode 5 gives alpha its own endpoints and indices, so cut-outs don't cost the
+// colour any precision. Returns the squared error over all four channels.
+static float encodeMode5(const float texels[16][4], Mode5Block& block) {
+	float low = 255.0f, high = 0.0f;
+	for (int i = 0; i < 16; i++) {
+		low = std::min(low, texels[i][3]);
+		high = std::max(high, texels[i][3]);
+	}
+	block.alphas[0] = (int)low;
+	block.alphas[1] = (int)high;
+	int alphas[4];
+	mode5Alphas(block, alphas);
+	float alphaError = 0.0f;
+	for (int i = 0; i < 16; i++) {
+		int best = 0;
+		for (int k = 1; k < 4; k++) {
+			if (std::fabs(alphas[k] - texels[i][3]) < std::fabs(alphas[best] - texels[i][3])) best = k;
+		}
+		block.alphaIndices[i] = (uint8_t)best;
+		alphaError += (alphas[best] - texels[i][3]) * (alphas[best] - texels[i][3]);
+	}
+
+	float mean[4], axis[4], first[4], second[4];
+	principalAxis(texels, 3, mean, axis);
+	axisEndpoints(texels, 3, mean, axis, first, second);
+	float best = fitMode5Colour(texels, first, second, block);
+	for (int iteration = 0; iteration < 2; iteration++) {
+		float positions[16];
+		for (int i = 0; i < 16; i++) positions[i] = BC7_WEIGHTS2[block.colourIndices[i]] / 64.0f;
+		if (!leastSquares(texels, 3, positions, first, second)) break;
+		Mode5Block refined = block;
+		float error = fitMode5Colour(texels, first, second, refined);
+		if (error >= best) break;
+		best = error;
+		block = refined;
+	}
+	return best + alphaError;
+}
+
+static float encodeMode6(const float texels[16][4], Mode6Block& block) {
+	float mean[4], axis[4], first[4], second[4];
+	principalAxis(texels, 4, mean, axis);
+	axisEndpoints(texels, 4, mean, axis, first, second);
+	float best = fitMode6(texels, first, second, block);
+	for (int iteration = 0; iteration < 2; iteration++) {
+		float positions[16];
+		for (int i = 0; i < 16; i++) positions[i] = BC7_WEIGHTS[block.indices[i]] / 64.0f;
+		if (!leastSquares(texels, 4, positions, first, second)) break;
+		Mode6Block refined;
+		float error = fitMode6(texels, first, second, refined);
+		if (error >= best) break;
+		best = error;
+		block = refined;
+	}
+	return best;
+}
+
+static void writeMode5(Mode5Block block, unsigned char* out) {
+	// the first texel's indices only get 1 bit each, so their top bits have to be 0
+	if (block.colourIndices[0] >= 2) {
+		for (int c = 0; c < 3; c++) std::swap(block.colours[0][c], block.colours[1][c]);
+		for (int i = 0; i < 16; i++) block.colourIndices[i] = (uint8_t)(3 - block.colourIndices[i]);
+	}
+	if (block.alphaIndices[0] >= 2) {
+		std::swap(block.alphas[0], block.alphas[1]);
+		for (int i = 0; i < 16; i++) block.alphaIndices[i] = (uint8_t)(3 - block.alphaIndices[i]);
+	}
+	std::memset(out, 0, 16);
+	BitWriter writer = {out, 0};
+	writer.put(1 << 5, 6); // mode 5
+	writer.put(0, 2);      // no channel rotation
+	for (int c = 0; c < 3; c++) {
+		writer.put(block.colours[0][c], 7);
+		writer.put(block.colours[1][c], 7);
+	}
+	writer.put(block.alphas[0], 8);
+	writer.put(block.alphas[1], 8);
+	writer.put(block.colourIndices[0], 1);
+	for (int i = 1; i < 16; i++) writer.put(block.colourIndices[i], 2);
+	writer.put(block.alphaIndices[0], 1);
+	for (int i = 1; i < 16; i++) writer.put(block.alphaIndices[i], 2);
+}
+
+static void writeMode6(Mode6Block block, unsigned char* out) {
+	// the first texel's index only gets 3 bits, so its top bit has to be 0
+	if (block.indices[0] >= 8) {
+		for (int c = 0; c < 4; c++) std::swap(block.endpoints[0][c], block.endpoints[1][c]);
+		std::swap(block.pbits[0], block.pbits[1]);
+		for (int i = 0; i < 16; i++) block.indices[i] = (uint8_t)(15 - block.indices[i]);
+	}
+	std::memset(out, 0, 16);
+	BitWriter writer = {out, 0};
+	writer.put(1 << 6, 7); // mode 6
+	for (int c = 0; c < 4; c++) {
+		writer.put(block.endpoints[0][c], 7);
+		writer.put(block.endpoints[1][c], 7);
+	}
+	writer.put(block.pbits[0], 1);
+	writer.put(block.pbits[1], 1);
+	writer.put(block.indices[0], 3);
+	for (int i = 1; i < 16; i++) writer.put(block.indices[i], 4);
+}
+
+void encodeBC7(const unsigned char* rgba, unsigned char* out) {
+	float texels[16][4];
+	readTexels(rgba, texels);
+	Mode6Block block6;
+	float error6 = encodeMode6(texels, block6);
+	bool flatAlpha = true;
+	for (int i = 1; i < 16; i++) flatAlpha = flatAlpha && rgba[i * 4 + 3] == rgba[3];
+	// mode 6 is hard to beat while alpha doesn't change, no need to try
+	if (!flatAlpha) {
+		Mode5Block block5;
+		if (encodeMode5(texels, block5) < error6) {
+			writeMode5(block5, out);
+			return;
+		}
+	}
+	writeMode6(block6, out);
+}
+
+static void decodeColour(const unsigned char* block, bool alwaysFourColours, unsigned char* rgba) {
+	uint16_t c0 = (uint16_t)(block[0] | (block[1] << 8));
+	uint16_t c1 = (uint16_t)(block[2] | (block[3] << 8));
+	uint32_t indices = block[4] | (block[5] << 8) | (block[6] << 16) | ((uint32_t)block[7] << 24);
+	int palette[4][3];
+	bc1Palette(c0, c1, palette);
+	bool threeColours = !alwaysFourColours && c0 <= c1;
+	if (threeColours) {
+		for (int c = 0; c < 3; c++) {
+			palette[2][c] = (palette[0][c] + palette[1][c]) / 2;
+			palette[3][c] = 0;
+		}
+	}
+	for (int i = 0; i < 16; i++) {
+		int index = (indices >> (2 * i)) & 3;
+		for (int c = 0; c < 3; c++) rgba[i * 4 + c] = (unsigned char)palette[index][c];
+		rgba[i * 4 + 3] = (threeColours && index == 3) ? 0 : 255;
+	}
+}
+
+void decodeBlock(TextureFormat format, const unsigned char* block, unsigned char* rgba) {
+	if (format == TEXTURE_BC1) {
+		decodeColour(block, false, rgba);
+	} else if (format == TEXTURE_BC3) {
+		decodeColour(block + 8, true, rgba);
+		int palette[8];
+		alphaPalette(block[0], block[1], palette);
+		uint64_t indices = 0;
+		for (int i = 0; i < 6; i++) indices |= (uint64_t)block[2 + i] << (8 * i);
+		for (int i = 0; i < 16; i++) rgba[i * 4 + 3] = (unsigned char)palette[(indices >> (3 * i)) & 7];
+	} else if (format == TEXTURE_BC7) {
+		BitReader reader = {block, 0};
+		// the mode is the number of 0 bits before the first 1
+		int mode = 0;
+		while (mode < 8 && reader.get(1) == 0) mode++;
+		if (mode == 5) {
+			int rotation = (int)reader.get(2);
+			Mode5Block decoded;
+			for (int c = 0; c < 3; c++) {
+				decoded.colours[0][c] = (int)reader.get(7);
+				decoded.colours[1][c] = (int)reader.get(7);
+			}
+			decoded.alphas[0] = (int)reader.get(8);
+			decoded.alphas[1] = (int)reader.get(8);
+			int colours[4][3], alphas[4];
+			mode5Colours(decoded, colours);
+			mode5Alphas(decoded, alphas);
+			for (int i = 0; i < 16; i++) {
+				int index = (int)reader.get(i == 0 ? 1 : 2);
+				for (int c = 0; c < 3; c++) rgba[i * 4 + c] = (unsigned char)colours[index][c];
+			}
+			for (int i = 0; i < 16; i++) rgba[i * 4 + 3] = (unsigned char)alphas[reader.get(i == 0 ? 1 : 2)];
+			// rotation swaps alpha with one of the colour channels
+			if (rotation != 0) {
+				for (int i = 0; i < 16; i++) std::swap(rgba[i * 4 + 3], rgba[i * 4 + rotation - 1]);
+			}
+			return;
+		}
+		if (mode != 6) {
+			// some other mode, show it loud rather than guess
+			for (int i = 0; i < 16; i++) {
+				rgba[i * 4 + 0] = 255;
+				rgba[i * 4 + 1] = 0;
+				rgba[i * 4 + 2] = 255;
+				rgba[i * 4 + 3] = 255;
+			}
+			return;
+		}
+		Mode6Block decoded;
+		for (int c = 0; c < 4; c++) {
+			decoded.endpoints[0][c] = (int)reader.get(7);
+			decoded.endpoints[1][c] = (int)reader.get(7);
+		}
+		decoded.pbits[0] = (int)reader.get(1);
+		decoded.pbits[1] = (int)reader.get(1);
+		int palette[16][4];
+		mode6Palette(decoded, palette);
+		for (int i = 0; i < 16; i++) {
+			int index = (int)reader.get(i == 0 ? 3 : 4);
+			for (int c = 0; c < 4; c++) rgba[i * 4 + c] = (unsigned char)palette[index][c];
+		}
+	} else {
+		std::memcpy(rgba, block, 64);
+	}
+}
+
+void compressTextureArray(const TextureArrayView& source, TextureFormat format, unsigned threads, TextureArrayData& out) {
+	out.format = format;
+	out.size = source.size;
+	out.layerCount = source.layerCount;
+	out.levels.assign(source.levelCount, std::vector<unsigned char>());
+	for (int level = 0; level < source.levelCount; level++) {
+		if (format == TEXTURE_RGBA8) out.levels[level].assign(source.levels[level], source.levels[level] + source.levelBytes[level]);
+		else out.levels[level].resize(textureLevelBytes(format, source.levelSize(level), source.layerCount));
+	}
+	if (format == TEXTURE_RGBA8) return;
+
+	// one job per layer of each level, they all write to their own part of out
+	size_t jobCount = (size_t)source.levelCount * source.layerCount;
+	std::atomic<size_t> next(0);
+	auto work = [&]() {
+		unsigned char texels[64];
+		for (size_t job = next++; job < jobCount; job = next++) {
+			int level = (int)(job / source.layerCount);
+			int layer = (int)(job % source.layerCount);
+			int size = source.levelSize(level);
+			int blocks = (size + 3) / 4;
+			const unsigned char* pixels = source.levels[level] + (size_t)layer * size * size * 4;
+			unsigned char* target = out.levels[level].data() + (size_t)layer * blocks * blocks * textureBlockBytes(format);
+			for (int by = 0; by < blocks; by++) {
+				for (int bx = 0; bx < blocks; bx++) {
+					// levels smaller than a block repeat their edge texels
+					for (int y = 0; y < 4; y++) {
+						int sy = std::min(by * 4 + y, size - 1);
+						for (int x = 0; x < 4; x++) {
+							int sx = std::min(bx * 4 + x, size - 1);
+							std::memcpy(texels + (y * 4 + x) * 4, pixels + (sy * size + sx) * 4, 4);
+						}
+					}
+					if (format == TEXTURE_BC1) encodeBC1(texels, target);
+					else if (format == TEXTURE_BC3) encodeBC3(texels, target);
+					else encodeBC7(texels, target);
+					target += textureBlockBytes(format);
+				}
+			}
+		}
+	};
+
+	if (threads == 0) threads = std::thread::hardware_concurrency();
+	if (threads == 0) threads = 1;
+	if (threads > jobCount) threads = (unsigned)jobCount;
+	std::vector<std::thread> workers;
+	for (unsigned i = 1; i < threads; i++) workers.emplace_back(work);
+	work();
+	for (std::thread& worker : workers) worker.join();
+}
+
+double compressionError(const TextureArrayView& source, const TextureArrayData& compressed) {
+	int size = source.size;
+	int blocks = (size + 3) / 4;
+	size_t blockBytes = textureBlockBytes(compressed.format);
+	double squared = 0.0;
+	unsigned char texels[64];
+	for (int layer = 0; layer < source.layerCount; layer++) {
+		const unsigned char* pixels = source.levels[0] + (size_t)layer * size * size * 4;
+		for (int by = 0; by < blocks; by++) {
+			for (int bx = 0; bx < blocks; bx++) {
+				size_t block = ((size_t)layer * blocks + by) * blocks + bx;
+				decodeBlock(compressed.format, compressed.levels[0].data() + block * blockBytes, texels);
+				for (int i = 0; i < 16; i++) {
+					int x = bx * 4 + i % 4;
+					int y = by * 4 + i / 4;
+					if (x >= size || y >= size) continue;
+					const unsigned char* original = pixels + ((size_t)y * size + x) * 4;
+					for (int c = 0; c < 4; c++) {
+						double d = (double)texels[i * 4 + c] - original[c];
+						squared += d * d;
+					}
+				}
+			}
+		}
+	}
+	return squared / ((double)size * size * source.layerCount * 4);
+}
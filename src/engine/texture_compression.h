@@ -0,0 +1,34 @@
+#ifndef TEXTURE_COMPRESSION_H
+#define TEXTURE_COMPRESSION_H
+
+#include "asset_loader.h"
+
+// CPU encoders for the block compressed formats GPUs sample directly. Each one
+// turns a 4 x 4 block of RGBA8 texels (row by row) into a fixed size block:
+//   BC1  8 bytes, two 565 endpoints and 2 bit indices, no alpha
+//   BC3  16 bytes, a BC4 alpha block followed by a BC1 colour block
+//   BC7  16 bytes, mode 6 or mode 5 picked per block. Mode 6 has one RGBA 7777
+//        endpoint pair with a p-bit each and 4 bit indices, mode 5 separate RGB 777
+//        and A8 endpoints with 2 bit indices each, so cut-outs don't cost colour.
+//        Mode 5 is only tried where alpha varies. Two modes are a fraction of a
+//        full BC7 search, the texture_compression bench has how they compare.
+// Nothing here touches GL, the decoders exist so the encoders can be checked
+// without a GPU.
+
+// bytes in one 4 x 4 block, or one texel for TEXTURE_RGBA8
+size_t textureBlockBytes(TextureFormat format);
+// a whole level of a texture array, small levels still take a full block
+size_t textureLevelBytes(TextureFormat format, int size, int layerCount);
+
+void encodeBC1(const unsigned char* rgba, unsigned char* out);
+void encodeBC3(const unsigned char* rgba, unsigned char* out);
+void encodeBC7(const unsigned char* rgba, unsigned char* out);
+// back to 4 x 4 RGBA8, BC7 only understands the mode 5 and 6 blocks encodeBC7 writes
+void decodeBlock(TextureFormat format, const unsigned char* block, unsigned char* rgba);
+
+// Encodes every level of an RGBA8 array, layers spread over threads (0 = one per core).
+void compressTextureArray(const TextureArrayView& source, TextureFormat format, unsigned threads, TextureArrayData& out);
+// mean squared error per RGBA channel of compressed's top level against source's
+double compressionError(const TextureArrayView& source, const TextureArrayData& compressed);
+
+#endif
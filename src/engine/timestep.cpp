@@ -0,0 +1,62 @@
+#include "timestep.h"
+
+#include <cmath>
+
+FixedTimestep::FixedTimestep(int ticksPerSecond, int maxTicksPerFrame)
+	: tickLength(1.0 / ticksPerSecond), maxTicks(maxTicksPerFrame), accumulator(0.0), dropped(0.0), tickCount(0) {
+}
+
+int FixedTimestep::advance(double frameSeconds) {
+	if (frameSeconds < 0.0) frameSeconds = 0.0;
+	accumulator += frameSeconds;
+	int ticks = 0;
+	while (accumulator >= tickLength && ticks < maxTicks) {
+		accumulator -= tickLength;
+		ticks++;
+	}
+	// still behind after a full catch up, let go of the rest
+	if (accumulator >= tickLength) {
+		double excess = accumulator - std::fmod(accumulator, tickLength);
+		dropped += excess;
+		accumulator -= excess;
+	}
+	tickCount += ticks;
+	return ticks;
+}
+
+float FixedTimestep::alpha() const {
+	return (float)(accumulator / tickLength);
+}
+
+RollingTimer::RollingTimer(size_t window) : values(window, 0.0), next(0), filled(0) {
+}
+
+void RollingTimer::add(double milliseconds) {
+	values[next] = milliseconds;
+	next = (next + 1) % values.size();
+	if (filled < values.size()) filled++;
+}
+
+double RollingTimer::average() const {
+	if (filled == 0) return 0.0;
+	double total = 0.0;
+	for (size_t i = 0; i < filled; i++) total += values[i];
+	return total / filled;
+}
+
+double RollingTimer::max() const {
+	double result = 0.0;
+	for (size_t i = 0; i < filled; i++) {
+		if (values[i] > result) result = values[i];
+	}
+	return result;
+}
+
+double RollingTimer::min() const {
+	if (filled == 0) return 0.0;
+	double result = values[0];
+	for (size_t i = 1; i < filled; i++) {
+		if (values[i] < result) result = values[i];
+	}
+	return result;
+}
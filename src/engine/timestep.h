@@ -0,0 +1,62 @@
+#ifndef TIMESTEP_H
+#define TIMESTEP_H
+
+#include <chrono>
+#include <cstdint>
+#include <vector>
+
+// Turns variable frame times into a whole number of fixed length simulation ticks.
+// Left over time carries into the next frame and alpha() says how far we are
+// between the last tick and the next one, for interpolating what we render.
+class FixedTimestep {
+public:
+	// maxTicksPerFrame stops a long stall from snowballing into an ever longer
+	// catch up, time past that is dropped instead of simulated
+	FixedTimestep(int ticksPerSecond, int maxTicksPerFrame);
+
+	// add a frame's worth of wall clock time, returns how many ticks to run
+	int advance(double frameSeconds);
+	float alpha() const;
+
+	double tickSeconds() const { return tickLength; }
+	uint64_t ticks() const { return tickCount; }
+	double droppedSeconds() const { return dropped; }
+
+private:
+	double tickLength;
+	int maxTicks;
+	double accumulator;
+	double dropped;
+	uint64_t tickCount;
+};
+
+// Min / average / max over the last few samples, in milliseconds.
+class RollingTimer {
+public:
+	explicit RollingTimer(size_t window);
+
+	void add(double milliseconds);
+	double average() const;
+	double max() const;
+	double min() const;
+	size_t samples() const { return filled; }
+
+private:
+	std::vector<double> values;
+	size_t next;
+	size_t filled;
+};
+
+// Measures the time since it was constructed.
+class ScopedTimer {
+public:
+	ScopedTimer() : start(std::chrono::steady_clock::now()) {}
+	double elapsedMs() const {
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+
+private:
+	std::chrono::steady_clock::time_point start;
+};
+
+#endif
@@ -0,0 +1,65 @@
+#include "vertex_pool.h"
+
+// until there's a histogram, about what a chunk of hilly terrain comes to
+static const size_t DEFAULT_CAPACITY = 4096;
+// vectors grown this many times past the usual size are freed rather than kept
+static const size_t OVERSIZED_FACTOR = 4;
+
+static int bucketFor(size_t size) {
+	int bucket = 0;
+	while (bucket < 31 && ((size_t)1 << bucket) < size) bucket++;
+	return bucket;
+}
+
+VertexPool::VertexPool() : histogram(), released(0), created(0) {
+	pool.reserve(MAX_POOLED);
+}
+
+std::vector<BlockVertex> VertexPool::acquire() {
+	std::lock_guard<std::mutex> lock(mutex);
+	if (!pool.empty()) {
+		std::vector<BlockVertex> vertices = std::move(pool.back());
+		pool.pop_back();
+		return vertices;
+	}
+	created++;
+	std::vector<BlockVertex> vertices;
+	vertices.reserve(suggestedLocked());
+	return vertices;
+}
+
+void VertexPool::release(std::vector<BlockVertex>&& vertices) {
+	std::lock_guard<std::mutex> lock(mutex);
+	histogram[bucketFor(vertices.size())]++;
+	released++;
+	// one huge mesh shouldn't pin its memory forever
+	if (pool.size() >= MAX_POOLED || vertices.capacity() > suggestedLocked() * OVERSIZED_FACTOR) return;
+	vertices.clear();
+	pool.push_back(std::move(vertices));
+}
+
+size_t VertexPool::suggestedLocked() const {
+	if (released == 0) return DEFAULT_CAPACITY;
+	uint64_t wanted = (released * 95 + 99) / 100;
+	uint64_t seen = 0;
+	for (int bucket = 0; bucket < 32; bucket++) {
+		seen += histogram[bucket];
+		if (seen >= wanted) return (size_t)1 << bucket;
+	}
+	return (size_t)1 << 31;
+}
+
+size_t VertexPool::suggestedCapacity() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return suggestedLocked();
+}
+
+size_t VertexPool::pooledCount() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return pool.size();
+}
+
+size_t VertexPool::createdCount() const {
+	std::lock_guard<std::mutex> lock(mutex);
+	return created;
+}
@@ -0,0 +1,42 @@
+#ifndef VERTEX_POOL_H
+#define VERTEX_POOL_H
+
+#include "mesher.h"
+
+#include <array>
+#include <mutex>
+#include <vector>
+
+// Recycles the vertex vectors meshes are built into, so meshing stops touching
+// the heap once it has warmed up. A vector made fresh is reserved at a size most
+// meshes fit in, read off a histogram of the meshes released so far, instead of
+// growing a doubling at a time. Safe to share between threads.
+class VertexPool {
+public:
+	// kept for reuse at most, anything released past this is freed
+	static const size_t MAX_POOLED = 64;
+
+	VertexPool();
+
+	// an empty vector, recycled when there is one
+	std::vector<BlockVertex> acquire();
+	// counts the mesh in the histogram and keeps the vector for the next acquire
+	void release(std::vector<BlockVertex>&& vertices);
+
+	// capacity new vectors get: the bucket that 95% of meshes so far fit in
+	size_t suggestedCapacity() const;
+	size_t pooledCount() const;
+	size_t createdCount() const;
+
+private:
+	size_t suggestedLocked() const;
+
+	mutable std::mutex mutex;
+	std::vector<std::vector<BlockVertex>> pool;
+	// meshes by size, bucket i holds those of up to 2^i vertices
+	std::array<uint64_t, 32> histogram;
+	uint64_t released;
+	size_t created;
+};
+
+#endif
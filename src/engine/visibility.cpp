@@ -0,0 +1,165 @@
+#include "visibility.h"
+
+#include <algorithm>
+#include <cmath>
+
+// bit index for every unordered pair of faces, -1 on the diagonal
+static const int8_t FACE_PAIR_BITS[FACE_COUNT][FACE_COUNT] = {
+	{-1,  0,  1,  2,  3,  4},
+	{ 0, -1,  5,  6,  7,  8},
+	{ 1,  5, -1,  9, 10, 11},
+	{ 2,  6,  9, -1, 12, 13},
+	{ 3,  7, 10, 12, -1, 14},
+	{ 4,  8, 11, 13, 14, -1}
+};
+
+// half the diagonal of a chunk, anything further behind the camera than this can't be seen
+static const float CHUNK_HALF_DIAGONAL = CHUNK_SIZE * 0.8660254f;
+
+int facePairBit(int a, int b) {
+	return FACE_PAIR_BITS[a][b];
+}
+
+static inline int oppositeFace(int face) {
+	// faces come in +/- pairs: front/back, left/right, bottom/top
+	return face ^ 1;
+}
+
+FaceConnectivity computeFaceConnectivity(const Chunk& chunk) {
+	ScratchArena arena(CHUNK_VOLUME * (sizeof(int) + 1) + 64);
+	return computeFaceConnectivity(chunk, arena);
+}
+
+FaceConnectivity computeFaceConnectivity(const Chunk& chunk, ScratchArena& arena) {
+	if (chunk.isUniform()) return isOpaque(chunk.uniformBlock()) ? 0 : ALL_FACES_CONNECTED;
+	const BlockID* blocks = chunk.blockData();
+	int open = 0;
+	for (int i = 0; i < CHUNK_VOLUME; i++) {
+		if (!isOpaque(blocks[i])) open++;
+	}
+	if (open == 0) return 0;
+	if (open == CHUNK_VOLUME) return ALL_FACES_CONNECTED;
+
+	FaceConnectivity mask = 0;
+	uint8_t* visited = arena.allocate<uint8_t>(CHUNK_VOLUME);
+	std::fill(visited, visited + CHUNK_VOLUME, 0);
+	// every block goes on the stack at most once, it can't outgrow the chunk
+	int* stack = arena.allocate<int>(CHUNK_VOLUME);
+	int depth = 0;
+
+	for (int start = 0; start < CHUNK_VOLUME; start++) {
+		if (visited[start] || isOpaque(blocks[start])) continue;
+		uint8_t touched = 0;
+		visited[start] = 1;
+		stack[depth++] = start;
+		while (depth > 0) {
+			int index = stack[--depth];
+			int x = index % CHUNK_SIZE;
+			int z = (index / CHUNK_SIZE) % CHUNK_SIZE;
+			int y = index / CHUNK_AREA;
+			if (z == CHUNK_SIZE - 1) touched |= 1 << FACE_FRONT;
+			if (z == 0) touched |= 1 << FACE_BACK;
+			if (x == 0) touched |= 1 << FACE_LEFT;
+			if (x == CHUNK_SIZE - 1) touched |= 1 << FACE_RIGHT;
+			if (y == 0) touched |= 1 << FACE_BOTTOM;
+			if (y == CHUNK_SIZE - 1) touched |= 1 << FACE_TOP;
+
+			for (int face = 0; face < FACE_COUNT; face++) {
+				int nx = x + FACE_NORMALS[face][0];
+				int ny = y + FACE_NORMALS[face][1];
+				int nz = z + FACE_NORMALS[face][2];
+				if (nx < 0 || nx >= CHUNK_SIZE || ny < 0 || ny >= CHUNK_SIZE || nz < 0 || nz >= CHUNK_SIZE) continue;
+				int next = blockIndex(nx, ny, nz);
+				if (visited[next] || isOpaque(blocks[next])) continue;
+				visited[next] = 1;
+				stack[depth++] = next;
+			}
+		}
+		for (int a = 0; a < FACE_COUNT; a++) {
+			if (!(touched & (1 << a))) continue;
+			for (int b = a + 1; b < FACE_COUNT; b++) {
+				if (touched & (1 << b)) mask |= 1 << facePairBit(a, b);
+			}
+		}
+		if (mask == ALL_FACES_CONNECTED) break;
+	}
+	return mask;
+}
+
+CaveCuller::CaveCuller() : radius(16), minY(0), maxY(0), hasChunks(false), origin(0), sizeXZ(0), sizeY(0) {
+}
+
+void CaveCuller::setConnectivity(const glm::ivec3& position, FaceConnectivity mask) {
+	connectivity[chunkKey(position.x, position.y, position.z)] = mask;
+	if (!hasChunks) {
+		minY = maxY = position.y;
+		hasChunks = true;
+	}
+	if (position.y < minY) minY = position.y;
+	if (position.y > maxY) maxY = position.y;
+}
+
+void CaveCuller::remove(const glm::ivec3& position) {
+	connectivity.erase(chunkKey(position.x, position.y, position.z));
+}
+
+FaceConnectivity CaveCuller::connectivityAt(const glm::ivec3& position) const {
+	auto it = connectivity.find(chunkKey(position.x, position.y, position.z));
+	if (it == connectivity.end()) return ALL_FACES_CONNECTED;
+	return it->second;
+}
+
+int CaveCuller::visitedIndex(const glm::ivec3& position) const {
+	glm::ivec3 local = position - origin;
+	if (local.x < 0 || local.x >= sizeXZ || local.z < 0 || local.z >= sizeXZ || local.y < 0 || local.y >= sizeY) return -1;
+	return (local.y * sizeXZ + local.z) * sizeXZ + local.x;
+}
+
+void CaveCuller::update(const glm::vec3& cameraPos, const glm::vec3& viewDir) {
+	visible.clear();
+	glm::ivec3 start((int)std::floor(cameraPos.x / CHUNK_SIZE), (int)std::floor(cameraPos.y / CHUNK_SIZE), (int)std::floor(cameraPos.z / CHUNK_SIZE));
+
+	// the walk stays within radius chunks sideways and one chunk of sky above and
+	// below whatever is loaded, so looking out over open terrain stays bounded
+	int low = hasChunks ? minY - 1 : start.y;
+	int high = hasChunks ? maxY + 1 : start.y;
+	if (start.y < low) low = start.y;
+	if (start.y > high) high = start.y;
+	origin = glm::ivec3(start.x - radius, low, start.z - radius);
+	sizeXZ = 2 * radius + 1;
+	sizeY = high - low + 1;
+	visited.assign((size_t)sizeXZ * sizeXZ * sizeY, 0);
+
+	frontier.clear();
+	frontier.push_back({start, -1, 0});
+	visited[visitedIndex(start)] = 1;
+
+	for (size_t head = 0; head < frontier.size(); head++) {
+		Step step = frontier[head];
+		visible.push_back(step.position);
+		FaceConnectivity mask = connectivityAt(step.position);
+
+		for (int face = 0; face < FACE_COUNT; face++) {
+			// never double back on a direction we've already travelled in
+			if (step.directions & (1 << oppositeFace(face))) continue;
+			if (step.entryFace >= 0 && !facesConnected(mask, step.entryFace, face)) continue;
+
+			glm::ivec3 next = step.position + glm::ivec3(FACE_NORMALS[face][0], FACE_NORMALS[face][1], FACE_NORMALS[face][2]);
+			int index = visitedIndex(next);
+			if (index < 0 || visited[index]) continue;
+
+			glm::vec3 centre = (glm::vec3(next) + 0.5f) * (float)CHUNK_SIZE;
+			if (glm::dot(centre - cameraPos, viewDir) < -CHUNK_HALF_DIAGONAL) continue;
+
+			visited[index] = 1;
+			frontier.push_back({next, (int8_t)oppositeFace(face), (uint8_t)(step.directions | (1 << face))});
+		}
+	}
+}
+
+bool CaveCuller::isVisible(const glm::ivec3& position) const {
+	int index = visitedIndex(position);
+	// past the search radius we don't know, so we have to draw it
+	if (index < 0) return true;
+	return visited[index] != 0;
+}
@@ -0,0 +1,72 @@
+#ifndef VISIBILITY_H
+#define VISIBILITY_H
+
+#include "mesher.h"
+
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+// Which of the 6 faces of a chunk can see each other through open space,
+// one bit per pair of faces (15 pairs).
+typedef uint16_t FaceConnectivity;
+
+const FaceConnectivity ALL_FACES_CONNECTED = 0x7FFF;
+
+int facePairBit(int a, int b);
+
+inline bool facesConnected(FaceConnectivity mask, int a, int b) {
+	return (mask >> facePairBit(a, b)) & 1;
+}
+
+// Flood fills the see-through blocks (air, leaves) of a chunk and records which
+// faces each pocket of open space touches.
+FaceConnectivity computeFaceConnectivity(const Chunk& chunk);
+// Same, with the flood fill's working memory taken from arena.
+FaceConnectivity computeFaceConnectivity(const Chunk& chunk, ScratchArena& arena);
+
+// CPU cave culling (Tommaso Checchi's connectivity search).
+// Starting at the camera's chunk we walk outwards, only leaving a chunk through
+// a face that is connected to the face we came in by, never turning back against
+// a direction we already travelled in and never stepping behind the camera.
+// Anything the walk can't reach is hidden behind solid terrain.
+// Chunks we have no connectivity for count as open air, chunks further out than
+// the search radius always count as visible.
+class CaveCuller {
+public:
+	CaveCuller();
+
+	void setConnectivity(const glm::ivec3& position, FaceConnectivity mask);
+	void remove(const glm::ivec3& position);
+	// how many chunks out from the camera the walk may go
+	void setRadius(int chunks) { radius = chunks; }
+
+	void update(const glm::vec3& cameraPos, const glm::vec3& viewDir);
+	bool isVisible(const glm::ivec3& position) const;
+	const std::vector<glm::ivec3>& visibleChunks() const { return visible; }
+
+private:
+	struct Step {
+		glm::ivec3 position;
+		int8_t entryFace; // -1 for the camera's own chunk
+		uint8_t directions; // faces we have stepped out of so far
+	};
+
+	FaceConnectivity connectivityAt(const glm::ivec3& position) const;
+	int visitedIndex(const glm::ivec3& position) const; // -1 outside the search box
+
+	std::unordered_map<uint64_t, FaceConnectivity> connectivity;
+	int radius;
+	int minY; // vertical range of loaded chunks
+	int maxY;
+	bool hasChunks;
+
+	glm::ivec3 origin; // corner of the visited box for the last update
+	int sizeXZ;
+	int sizeY;
+	std::vector<uint8_t> visited;
+	std::vector<Step> frontier;
+	std::vector<glm::ivec3> visible;
+};
+
+#endif
@@ -0,0 +1,46 @@
+#include "worker_pool.h"
+
+WorkerPool::WorkerPool() : job(nullptr), waiting(0), running(0), stopping(false) {
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		stopping = true;
+	}
+	wake.notify_all();
+	for (std::thread& thread : threads) thread.join();
+}
+
+void WorkerPool::run(const std::function<void()>& job, unsigned helpers) {
+	while (threads.size() < helpers) threads.emplace_back(&WorkerPool::loop, this);
+	{
+		std::lock_guard<std::mutex> lock(mutex);
+		this->job = &job;
+		waiting = helpers;
+	}
+	wake.notify_all();
+	job();
+
+	std::unique_lock<std::mutex> lock(mutex);
+	// the work ran out while we were at it, whoever hasn't started has nothing to do
+	waiting = 0;
+	finished.wait(lock, [this]() { return running == 0; });
+	this->job = nullptr;
+}
+
+void WorkerPool::loop() {
+	std::unique_lock<std::mutex> lock(mutex);
+	while (true) {
+		wake.wait(lock, [this]() { return stopping || waiting > 0; });
+		if (stopping) return;
+		waiting--;
+		running++;
+		const std::function<void()>* current = job;
+		lock.unlock();
+		(*current)();
+		lock.lock();
+		running--;
+		if (running == 0) finished.notify_all();
+	}
+}
@@ -0,0 +1,41 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// Threads that stay around between parallel runs, so spreading a system over
+// cores costs a wake-up instead of starting and joining threads every tick.
+// Meant for jobs that pull their work from a shared counter until there's none
+// left, like parallelEach's batches: the caller takes part too, and helpers
+// that haven't got going by the time it runs out of work are told not to bother.
+class WorkerPool {
+public:
+	WorkerPool();
+	// waits for the threads to finish, no run may be going on
+	~WorkerPool();
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool& operator=(const WorkerPool&) = delete;
+
+	// calls job on up to helpers pool threads and on this one, returns once every
+	// call has returned. The pool grows to helpers threads if it has fewer
+	void run(const std::function<void()>& job, unsigned helpers);
+	size_t threadCount() const { return threads.size(); }
+
+private:
+	void loop();
+
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable finished;
+	std::vector<std::thread> threads;
+	const std::function<void()>* job;
+	unsigned waiting; // helpers asked for that haven't picked the job up yet
+	unsigned running; // helpers inside job
+	bool stopping;
+};
+
+#endif
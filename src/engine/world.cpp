@@ -0,0 +1,133 @@
+#include "world.h"
+
+#include "chunk_snapshot.h"
+
+#include <cstring>
+
+// a section's worth of every block, what uniform sections read from
+static const BlockID* uniformBlocks(BlockID id) {
+	struct Table {
+		BlockID blocks[BLOCK_COUNT][CHUNK_VOLUME];
+		Table() {
+			for (int block = 0; block < BLOCK_COUNT; block++) std::memset(blocks[block], block, CHUNK_VOLUME);
+		}
+	};
+	static const Table table;
+	return table.blocks[id];
+}
+
+Chunk::Chunk(int cx, int cy, int cz)
+	: position(cx, cy, cz), blocks(uniformBlocks(BLOCK_AIR)), sharedWith(nullptr), uniform(true) {
+	biomes.fill(0);
+}
+
+Chunk::Chunk(const Chunk& other)
+	: position(other.position), biomes(other.biomes), blocks(other.blocks), sharedWith(nullptr), uniform(other.uniform) {
+	if (!other.uniform) assign(other.blocks);
+}
+
+Chunk& Chunk::operator=(const Chunk& other) {
+	if (this == &other) return *this;
+	position = other.position;
+	biomes = other.biomes;
+	if (!other.uniform) {
+		assign(other.blocks);
+	} else {
+		makeUniform(other.blocks[0]);
+	}
+	return *this;
+}
+
+Chunk::~Chunk() {
+	dropShared();
+}
+
+void Chunk::dropShared() {
+	if (sharedWith == nullptr) return;
+	sharedWith->retire(const_cast<BlockID*>(blocks));
+	sharedWith = nullptr;
+}
+
+void Chunk::makeOwned() {
+	BlockID* owned = new BlockID[CHUNK_VOLUME];
+	std::memcpy(owned, blocks, CHUNK_VOLUME);
+	dropShared();
+	storage.reset(owned);
+	blocks = owned;
+	uniform = false;
+}
+
+void Chunk::makeUniform(BlockID id) {
+	dropShared();
+	storage.reset();
+	blocks = uniformBlocks(id);
+	uniform = true;
+}
+
+void Chunk::assign(const BlockID* source) {
+	if (source[0] < BLOCK_COUNT && std::memcmp(source, uniformBlocks(source[0]), CHUNK_VOLUME) == 0) {
+		makeUniform(source[0]);
+		return;
+	}
+	if (storage == nullptr) {
+		dropShared();
+		storage.reset(new BlockID[CHUNK_VOLUME]);
+		blocks = storage.get();
+		uniform = false;
+	}
+	std::memcpy(storage.get(), source, CHUNK_VOLUME);
+}
+
+void Chunk::fill(BlockID id) {
+	if (id >= BLOCK_COUNT) {
+		std::memset(mutableBlocks(), id, CHUNK_VOLUME);
+		return;
+	}
+	makeUniform(id);
+}
+
+bool Chunk::compact() {
+	if (uniform) return true;
+	BlockID id = blocks[0];
+	if (id >= BLOCK_COUNT || std::memcmp(blocks, uniformBlocks(id), CHUNK_VOLUME) != 0) return false;
+	makeUniform(id);
+	return true;
+}
+
+void Chunk::shareWith(EpochReclaimer& readers, Chunk& view) {
+	if (storage != nullptr) {
+		// ours still, but read only from now on
+		storage.release();
+		sharedWith = &readers;
+	}
+	view.dropShared();
+	view.storage.reset();
+	view.position = position;
+	view.biomes = biomes;
+	view.blocks = blocks;
+	view.uniform = uniform;
+}
+
+World::~World() {
+	for (const ChunkMap::Slot& slot : chunks) delete slot.chunk;
+}
+
+Chunk& World::createChunk(int cx, int cy, int cz) {
+	uint64_t key = chunkKey(cx, cy, cz);
+	Chunk* chunk = chunks.find(key);
+	if (chunk == nullptr) {
+		chunk = new Chunk(cx, cy, cz);
+		chunks.insert(key, chunk);
+	}
+	return *chunk;
+}
+
+void World::removeChunk(int cx, int cy, int cz) {
+	delete chunks.erase(chunkKey(cx, cy, cz));
+}
+
+BlockID World::getBlock(int x, int y, int z) const {
+	const Chunk* chunk = getChunk(floorDiv(x, CHUNK_SIZE), floorDiv(y, CHUNK_SIZE), floorDiv(z, CHUNK_SIZE));
+	if (chunk == nullptr) return BLOCK_AIR;
+	return chunk->get(floorMod(x, CHUNK_SIZE), floorMod(y, CHUNK_SIZE), floorMod(z, CHUNK_SIZE));
+}
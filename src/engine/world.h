@@ -0,0 +1,162 @@
+#ifndef WORLD_H
+#define WORLD_H
+
+#include "chunk_map.h"
+#include "core.h"
+#include "../../include/glm/glm.hpp"
+
+#include <array>
+#include <memory>
+
+class EpochReclaimer;
+
+// One 16 x 16 x 16 section of a column. A section made of a single block, open
+// sky or solid rock, keeps no storage of its own: it reads from a shared array
+// of that block, and only the first write of anything else gives it 4 KiB of
+// its own. compact() goes back the other way once it's uniform again.
+//
+// Storage can also be shared with snapshots other threads read, see
+// chunk_snapshot.h. It's copy on write then: the next write copies the blocks
+// first and hands the old storage to the EpochReclaimer, which frees it once no
+// snapshot can be reading it, so writers never wait for readers.
+struct Chunk {
+	glm::ivec3 position; // in chunk coordinates, multiply by CHUNK_SIZE for world space
+	// biome of each column, indexed z*16 + x, filled in by the generator
+	std::array<uint8_t, CHUNK_AREA> biomes;
+
+	// starts out as all air
+	Chunk(int cx, int cy, int cz);
+	Chunk(const Chunk& other);
+	Chunk& operator=(const Chunk& other);
+	~Chunk();
+
+	uint8_t biomeAt(int x, int z) const {
+		return biomes[z * CHUNK_SIZE + x];
+	}
+	BlockID get(int x, int y, int z) const {
+		return blocks[blockIndex(x, y, z)];
+	}
+	void set(int x, int y, int z, BlockID id) {
+		int index = blockIndex(x, y, z);
+		if (storage == nullptr) {
+			if (blocks[index] == id) return;
+			makeOwned();
+		}
+		storage[index] = id;
+	}
+
+	// every block, indexed by blockIndex
+	const BlockID* blockData() const { return blocks; }
+	// the same for writing, a uniform or shared section gets its own storage first
+	BlockID* mutableBlocks() {
+		if (storage == nullptr) makeOwned();
+		return storage.get();
+	}
+	// copies CHUNK_VOLUME blocks in, staying uniform if they're all the same
+	void assign(const BlockID* source);
+	void fill(BlockID id);
+	// drops the storage if every block is the same, returns whether it's uniform now
+	bool compact();
+
+	bool isUniform() const { return uniform; }
+	// the block a uniform section is made of
+	BlockID uniformBlock() const { return blocks[0]; }
+	// all air, nothing to draw, save, send or tick
+	bool isEmpty() const { return uniform && blocks[0] == BLOCK_AIR; }
+	// all opaque, nothing inside it can be seen
+	bool isFull() const { return uniform && isOpaque(blocks[0]); }
+	size_t memoryBytes() const { return sizeof(Chunk) + (uniform ? 0 : CHUNK_VOLUME); }
+
+	// Makes view read our blocks as they are now, without copying them. Until the
+	// readers' reclaimer says otherwise our storage is read only, and view never
+	// writes to it either: writing to a view gives it storage of its own.
+	void shareWith(EpochReclaimer& readers, Chunk& view);
+	bool isShared() const { return sharedWith != nullptr; }
+
+private:
+	void makeOwned();
+	void makeUniform(BlockID id);
+	// shared storage goes to the reclaimer, we're done with it
+	void dropShared();
+
+	std::unique_ptr<BlockID[]> storage; // when we can write to blocks in place, else nullptr
+	const BlockID* blocks;              // storage, the shared array of one block, or storage shared with snapshots
+	EpochReclaimer* sharedWith;         // set while blocks are ours but snapshots may read them
+	bool uniform;
+};
+
+// Packs a chunk coordinate into 64 bits, 21 bits per axis.
+inline uint64_t chunkKey(int cx, int cy, int cz) {
+	const uint64_t mask = (1ull << 21) - 1;
+	return ((uint64_t)(cx & mask) << 42) | ((uint64_t)(cy & mask) << 21) | (uint64_t)(cz & mask);
+}
+
+class World {
+public:
+	World() = default;
+	~World();
+	World(const World&) = delete;
+	World& operator=(const World&) = delete;
+
+	Chunk* getChunk(int cx, int cy, int cz) { return chunks.find(chunkKey(cx, cy, cz)); }
+	const Chunk* getChunk(int cx, int cy, int cz) const { return chunks.find(chunkKey(cx, cy, cz)); }
+	// returns the existing chunk if there already is one at that position
+	Chunk& createChunk(int cx, int cy, int cz);
+	void removeChunk(int cx, int cy, int cz);
+
+	// world space block access, anything outside a loaded chunk reads as air
+	BlockID getBlock(int x, int y, int z) const;
+
+	// iterates as ChunkMap::Slot, key and chunk
+	const ChunkMap& allChunks() const { return chunks; }
+	size_t chunkCount() const { return chunks.size(); }
+
+private:
+	ChunkMap chunks;
+};
+
+// Block access for code that walks the world a block at a time, like physics,
+// lighting or random ticks. Remembers the last chunk it looked up, missing ones
+// included, so lookups that stay in one chunk cost no hashing and stepping into
+// another costs one probe. Meant to live for one pass: a chunk removed from the
+// world while the accessor remembers it would dangle, and one added where it
+// last found nothing stays unseen.
+template <typename WorldType, typename ChunkType>
+class BasicBlockAccess {
+public:
+	explicit BasicBlockAccess(WorldType& world) : world(world), lastKey(NO_CHUNK_KEY), lastChunk(nullptr) {}
+
+	ChunkType* chunkAt(int cx, int cy, int cz) {
+		uint64_t key = chunkKey(cx, cy, cz);
+		if (key != lastKey) {
+			lastKey = key;
+			lastChunk = world.getChunk(cx, cy, cz);
+		}
+		return lastChunk;
+	}
+	// anything outside a loaded chunk reads as air
+	BlockID getBlock(int x, int y, int z) {
+		ChunkType* chunk = chunkAt(floorDiv(x, CHUNK_SIZE), floorDiv(y, CHUNK_SIZE), floorDiv(z, CHUNK_SIZE));
+		if (chunk == nullptr) return BLOCK_AIR;
+		return chunk->get(floorMod(x, CHUNK_SIZE), floorMod(y, CHUNK_SIZE), floorMod(z, CHUNK_SIZE));
+	}
+	// Writes straight into chunk storage, for passes like generation that do their
+	// own bookkeeping. Edits players should see go through WorldEditor. False if
+	// the block's chunk isn't loaded.
+	bool setBlock(int x, int y, int z, BlockID id) {
+		ChunkType* chunk = chunkAt(floorDiv(x, CHUNK_SIZE), floorDiv(y, CHUNK_SIZE), floorDiv(z, CHUNK_SIZE));
+		if (chunk == nullptr) return false;
+		chunk->set(floorMod(x, CHUNK_SIZE), floorMod(y, CHUNK_SIZE), floorMod(z, CHUNK_SIZE), id);
+		return true;
+	}
+
+private:
+	WorldType& world;
+	uint64_t lastKey;
+	ChunkType* lastChunk;
+};
+
+typedef BasicBlockAccess<World, Chunk> BlockAccess;
+typedef BasicBlockAccess<const World, const Chunk> ConstBlockAccess;
+
+#endif
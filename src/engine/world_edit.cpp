@@ -0,0 +1,140 @@
+#include "world_edit.h"
+
+#include <algorithm>
+#include <cmath>
+
+WorldEditor::WorldEditor(World& world) : world(world), recording(false) {
+}
+
+void WorldEditor::markDirty(const glm::ivec3& chunkPos, SlabMask slabs) {
+	auto inserted = dirtyIndex.insert({chunkKey(chunkPos.x, chunkPos.y, chunkPos.z), dirty.size()});
+	if (inserted.second) {
+		dirty.push_back({chunkPos, slabs});
+	} else {
+		dirty[inserted.first->second].slabs |= slabs;
+	}
+}
+
+void WorldEditor::markBorders(const glm::ivec3& chunkPos, const glm::ivec3& lo, const glm::ivec3& hi) {
+	// the blocks above and below an edit cull their faces against it too
+	markDirty(chunkPos, slabsBetween(lo.y - 1, hi.y + 1));
+	for (int axis = 0; axis < 3; axis++) {
+		// across a side the same rows change, across the top or bottom the row facing us
+		SlabMask below = axis == 1 ? slabsBetween(CHUNK_SIZE - 1, CHUNK_SIZE - 1) : slabsBetween(lo.y, hi.y);
+		SlabMask above = axis == 1 ? slabsBetween(0, 0) : slabsBetween(lo.y, hi.y);
+		if (lo[axis] == 0) {
+			glm::ivec3 neighbour = chunkPos;
+			neighbour[axis]--;
+			markDirty(neighbour, below);
+		}
+		if (hi[axis] == CHUNK_SIZE - 1) {
+			glm::ivec3 neighbour = chunkPos;
+			neighbour[axis]++;
+			markDirty(neighbour, above);
+		}
+	}
+}
+
+template <typename Filter>
+size_t WorldEditor::fillChunk(const glm::ivec3& chunkPos, const glm::ivec3& lo, const glm::ivec3& hi, BlockID id, Filter filter) {
+	Chunk* chunk = world.getChunk(chunkPos.x, chunkPos.y, chunkPos.z);
+	if (chunk == nullptr) {
+		if (!source) return 0;
+		chunk = source(chunkPos);
+		if (chunk == nullptr) return 0;
+	}
+	// filling a section with what it's already made of
+	if (chunk->isUniform() && chunk->uniformBlock() == id) return 0;
+
+	BlockID* blocks = chunk->mutableBlocks();
+	glm::ivec3 origin = chunkPos * CHUNK_SIZE;
+	size_t changed = 0;
+	// only the part of the region that really changed counts towards the borders
+	glm::ivec3 changedLo(CHUNK_SIZE);
+	glm::ivec3 changedHi(-1);
+	for (int y = lo.y; y <= hi.y; y++) {
+		for (int z = lo.z; z <= hi.z; z++) {
+			for (int x = lo.x; x <= hi.x; x++) {
+				if (!filter(origin + glm::ivec3(x, y, z))) continue;
+				BlockID& block = blocks[blockIndex(x, y, z)];
+				if (block == id) continue;
+				block = id;
+				changed++;
+				if (recording) changes.push_back({chunkPos, (uint16_t)blockIndex(x, y, z), id});
+				changedLo = glm::min(changedLo, glm::ivec3(x, y, z));
+				changedHi = glm::max(changedHi, glm::ivec3(x, y, z));
+			}
+		}
+	}
+	// dug out to nothing or filled solid, it can give its storage back
+	chunk->compact();
+	if (changed > 0) markBorders(chunkPos, changedLo, changedHi);
+	return changed;
+}
+
+template <typename Filter>
+size_t WorldEditor::fillRegion(const glm::ivec3& min, const glm::ivec3& max, BlockID id, Filter filter) {
+	glm::ivec3 lo = glm::min(min, max);
+	glm::ivec3 hi = glm::max(min, max);
+	glm::ivec3 firstChunk(floorDiv(lo.x, CHUNK_SIZE), floorDiv(lo.y, CHUNK_SIZE), floorDiv(lo.z, CHUNK_SIZE));
+	glm::ivec3 lastChunk(floorDiv(hi.x, CHUNK_SIZE), floorDiv(hi.y, CHUNK_SIZE), floorDiv(hi.z, CHUNK_SIZE));
+
+	size_t changed = 0;
+	// chunk by chunk, so each chunk is looked up and marked once
+	for (int cy = firstChunk.y; cy <= lastChunk.y; cy++) {
+		for (int cz = firstChunk.z; cz <= lastChunk.z; cz++) {
+			for (int cx = firstChunk.x; cx <= lastChunk.x; cx++) {
+				glm::ivec3 chunkPos(cx, cy, cz);
+				glm::ivec3 origin = chunkPos * CHUNK_SIZE;
+				glm::ivec3 localLo = glm::max(lo - origin, glm::ivec3(0));
+				glm::ivec3 localHi = glm::min(hi - origin, glm::ivec3(CHUNK_SIZE - 1));
+				changed += fillChunk(chunkPos, localLo, localHi, id, filter);
+			}
+		}
+	}
+	return changed;
+}
+
+bool WorldEditor::setBlock(const glm::ivec3& position, BlockID id) {
+	return fillBox(position, position, id) > 0;
+}
+
+size_t WorldEditor::fillBox(const glm::ivec3& min, const glm::ivec3& max, BlockID id) {
+	return fillRegion(min, max, id, [](const glm::ivec3&) { return true; });
+}
+
+size_t WorldEditor::fillSphere(const glm::vec3& centre, float radius, BlockID id) {
+	if (radius <= 0.0f) return 0;
+	glm::ivec3 min((int)std::floor(centre.x - radius), (int)std::floor(centre.y - radius), (int)std::floor(centre.z - radius));
+	glm::ivec3 max((int)std::floor(centre.x + radius), (int)std::floor(centre.y + radius), (int)std::floor(centre.z + radius));
+	float radiusSquared = radius * radius;
+	return fillRegion(min, max, id, [&](const glm::ivec3& block) {
+		glm::vec3 offset = glm::vec3(block) + 0.5f - centre;
+		return glm::dot(offset, offset) <= radiusSquared;
+	});
+}
+
+void WorldEditor::takeDirtyChunks(std::vector<glm::ivec3>& out) {
+	out.clear();
+	for (const DirtyRegion& region : dirty) {
+		const glm::ivec3& position = region.chunk;
+		if (world.getChunk(position.x, position.y, position.z) != nullptr) out.push_back(position);
+	}
+	dirty.clear();
+	dirtyIndex.clear();
+}
+
+void WorldEditor::takeDirtyRegions(std::vector<DirtyRegion>& out) {
+	out.clear();
+	for (const DirtyRegion& region : dirty) {
+		const glm::ivec3& position = region.chunk;
+		if (world.getChunk(position.x, position.y, position.z) != nullptr) out.push_back(region);
+	}
+	dirty.clear();
+	dirtyIndex.clear();
+}
+
+void WorldEditor::takeChanges(std::vector<BlockChange>& out) {
+	out.swap(changes);
+	changes.clear();
+}
@@ -0,0 +1,78 @@
+#ifndef WORLD_EDIT_H
+#define WORLD_EDIT_H
+
+#include "world.h"
+
+#include <functional>
+#include <unordered_map>
+#include <vector>
+
+// A chunk that needs a new mesh and which of its slabs changed.
+struct DirtyRegion {
+	glm::ivec3 chunk;
+	SlabMask slabs;
+};
+
+// One block that changed, as recorded for sending to clients.
+struct BlockChange {
+	glm::ivec3 chunk;
+	uint16_t index; // blockIndex inside the chunk
+	BlockID id;
+};
+
+// The one way blocks get changed after generation.
+// Edits write straight into chunk storage and remember which chunks need a new
+// mesh: the chunk itself, plus the neighbour across any chunk face the edit
+// touched, since that neighbour culls its faces against our blocks. Each chunk
+// is only reported once however many blocks changed in it, so remeshing a
+// 100k block fill costs one mesh per chunk rather than one per block. Along
+// with the chunk goes the set of slabs whose faces may have changed, so a
+// single block edit only has one or two slabs to remesh.
+class WorldEditor {
+public:
+	// Loads or makes the section at a chunk position that isn't loaded, so an edit
+	// can go into it, and adds it to the world. nullptr drops the edit. Making a
+	// blank section where one is stored would throw the stored one away.
+	typedef std::function<Chunk*(const glm::ivec3& chunkPos)> ChunkSource;
+
+	explicit WorldEditor(World& world);
+
+	// without one, edits to sections that aren't loaded are dropped
+	void setChunkSource(ChunkSource source) { this->source = source; }
+
+	// returns false if the block already was id
+	bool setBlock(const glm::ivec3& position, BlockID id);
+	// fills the inclusive box min..max, returns how many blocks changed
+	size_t fillBox(const glm::ivec3& min, const glm::ivec3& max, BlockID id);
+	// fills every block whose centre is within radius of centre
+	size_t fillSphere(const glm::vec3& centre, float radius, BlockID id);
+
+	// chunks dirtied since the last call, each one once
+	void takeDirtyChunks(std::vector<glm::ivec3>& out);
+	// the same, with the slabs that changed in each
+	void takeDirtyRegions(std::vector<DirtyRegion>& out);
+	size_t dirtyCount() const { return dirty.size(); }
+
+	// keeps a list of every block changed, in order, until takeChanges. Off by default
+	// since only the server has anyone to tell.
+	void recordChanges(bool enabled) { recording = enabled; }
+	void takeChanges(std::vector<BlockChange>& out);
+
+private:
+	// writes id into a chunk for the local box lo..hi, for blocks that pass the filter
+	template <typename Filter>
+	size_t fillChunk(const glm::ivec3& chunkPos, const glm::ivec3& lo, const glm::ivec3& hi, BlockID id, Filter filter);
+	template <typename Filter>
+	size_t fillRegion(const glm::ivec3& min, const glm::ivec3& max, BlockID id, Filter filter);
+	void markDirty(const glm::ivec3& chunkPos, SlabMask slabs);
+	void markBorders(const glm::ivec3& chunkPos, const glm::ivec3& lo, const glm::ivec3& hi);
+
+	World& world;
+	ChunkSource source;
+	std::unordered_map<uint64_t, size_t> dirtyIndex; // into dirty
+	std::vector<DirtyRegion> dirty;
+	bool recording;
+	std::vector<BlockChange> changes;
+};
+
+#endif
@@ -0,0 +1,181 @@
+#include "world_io.h"
+
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <sys/stat.h>
+#include <vector>
+
+static const char WORLD_MAGIC[4] = {'S', 'C', 'F', 'W'};
+// 2 added each chunk's biomes after its blocks
+static const uint32_t WORLD_VERSION = 2;
+static const char CHUNK_MAGIC[4] = {'S', 'C', 'F', 'C'};
+static const uint32_t CHUNK_VERSION = 1;
+
+// little endian no matter what we're running on
+static void writeU32(std::vector<unsigned char>& out, uint32_t value) {
+	for (int i = 0; i < 4; i++) out.push_back((unsigned char)(value >> (8 * i)));
+}
+
+static bool readU32(std::ifstream& in, uint32_t& value) {
+	unsigned char bytes[4];
+	if (!in.read(reinterpret_cast<char*>(bytes), 4)) return false;
+	value = bytes[0] | (bytes[1] << 8) | (bytes[2] << 16) | ((uint32_t)bytes[3] << 24);
+	return true;
+}
+
+// runs of (length - 1, id), so one run covers up to 256 blocks
+static void encodeBlocks(const Chunk& chunk, std::vector<unsigned char>& out) {
+	const BlockID* blocks = chunk.blockData();
+	int i = 0;
+	while (i < CHUNK_VOLUME) {
+		BlockID id = blocks[i];
+		int run = 1;
+		while (i + run < CHUNK_VOLUME && run < 256 && blocks[i + run] == id) run++;
+		out.push_back((unsigned char)(run - 1));
+		out.push_back(id);
+		i += run;
+	}
+}
+
+// fills blocks from runs, false unless they cover the chunk exactly
+static bool decodeBlocks(const unsigned char* runs, size_t size, BlockID* blocks) {
+	int filled = 0;
+	for (size_t i = 0; i + 1 < size && filled < CHUNK_VOLUME; i += 2) {
+		int run = runs[i] + 1;
+		if (filled + run > CHUNK_VOLUME) run = CHUNK_VOLUME - filled;
+		BlockID id = runs[i + 1] < BLOCK_COUNT ? (BlockID)runs[i + 1] : (BlockID)BLOCK_AIR;
+		std::memset(blocks + filled, id, run);
+		filled += run;
+	}
+	return filled == CHUNK_VOLUME;
+}
+
+static bool writeFile(const std::vector<unsigned char>& data, const char* path) {
+	std::string temporary = std::string(path) + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary | std::ios::trunc);
+		if (!out.write(reinterpret_cast<const char*>(data.data()), data.size())) {
+			std::cout << "Failed to write " << temporary << std::endl;
+			return false;
+		}
+	}
+	if (std::rename(temporary.c_str(), path) != 0) {
+		std::cout << "Failed to replace " << path << std::endl;
+		return false;
+	}
+	return true;
+}
+
+bool saveWorld(const World& world, const char* path) {
+	std::vector<unsigned char> data(WORLD_MAGIC, WORLD_MAGIC + 4);
+	writeU32(data, WORLD_VERSION);
+	writeU32(data, (uint32_t)world.chunkCount());
+	std::vector<unsigned char> runs;
+	for (const auto& entry : world.allChunks()) {
+		const Chunk& chunk = *entry.chunk;
+		runs.clear();
+		encodeBlocks(chunk, runs);
+		writeU32(data, (uint32_t)chunk.position.x);
+		writeU32(data, (uint32_t)chunk.position.y);
+		writeU32(data, (uint32_t)chunk.position.z);
+		writeU32(data, (uint32_t)runs.size());
+		data.insert(data.end(), runs.begin(), runs.end());
+		data.insert(data.end(), chunk.biomes.begin(), chunk.biomes.end());
+	}
+	return writeFile(data, path);
+}
+
+bool loadWorld(World& world, const char* path) {
+	std::ifstream in(path, std::ios::binary);
+	if (!in) return false;
+	char magic[4];
+	uint32_t version, count;
+	if (!in.read(magic, 4) || std::memcmp(magic, WORLD_MAGIC, 4) != 0 || !readU32(in, version) || version != WORLD_VERSION) {
+		std::cout << path << " isn't a world file this version can read" << std::endl;
+		return false;
+	}
+	if (!readU32(in, count)) return false;
+
+	std::vector<unsigned char> runs;
+	std::array<BlockID, CHUNK_VOLUME> blocks;
+	std::array<uint8_t, CHUNK_AREA> biomes;
+	for (uint32_t c = 0; c < count; c++) {
+		uint32_t x, y, z, size;
+		bool complete = readU32(in, x) && readU32(in, y) && readU32(in, z) && readU32(in, size);
+		// every block its own run is as long as a chunk gets, anything past that is garbage
+		if (complete && (size % 2 != 0 || size > 2 * CHUNK_VOLUME)) {
+			std::cout << path << " is corrupt, chunk " << (int32_t)x << " " << (int32_t)y << " " << (int32_t)z
+				<< " claims " << size << " bytes of blocks" << std::endl;
+			return false;
+		}
+		if (complete) {
+			runs.resize(size);
+			complete = in.read(reinterpret_cast<char*>(runs.data()), size)
+				&& in.read(reinterpret_cast<char*>(biomes.data()), CHUNK_AREA);
+		}
+		if (!complete) {
+			std::cout << path << " ends early" << std::endl;
+			return false;
+		}
+
+		if (!decodeBlocks(runs.data(), size, blocks.data())) {
+			std::cout << path << ": chunk " << (int32_t)x << " " << (int32_t)y << " " << (int32_t)z << " is cut short" << std::endl;
+			return false;
+		}
+		Chunk& chunk = world.createChunk((int32_t)x, (int32_t)y, (int32_t)z);
+		chunk.assign(blocks.data());
+		chunk.biomes = biomes;
+	}
+	return true;
+}
+
+static std::string chunkPath(const glm::ivec3& position, const char* directory) {
+	return std::string(directory) + "/" + std::to_string(position.x) + "." + std::to_string(position.y) + "." + std::to_string(position.z) + ".chunk";
+}
+
+bool saveChunk(const Chunk& chunk, const char* directory) {
+	mkdir(directory, 0755);
+	std::vector<unsigned char> runs;
+	encodeBlocks(chunk, runs);
+	std::vector<unsigned char> data(CHUNK_MAGIC, CHUNK_MAGIC + 4);
+	writeU32(data, CHUNK_VERSION);
+	writeU32(data, (uint32_t)runs.size());
+	data.insert(data.end(), runs.begin(), runs.end());
+	data.insert(data.end(), chunk.biomes.begin(), chunk.biomes.end());
+	return writeFile(data, chunkPath(chunk.position, directory).c_str());
+}
+
+bool loadChunk(Chunk& chunk, const char* directory) {
+	std::ifstream in(chunkPath(chunk.position, directory), std::ios::binary);
+	if (!in) return false;
+	char magic[4];
+	uint32_t version, size;
+	if (!in.read(magic, 4) || std::memcmp(magic, CHUNK_MAGIC, 4) != 0 || !readU32(in, version) || version != CHUNK_VERSION
+		|| !readU32(in, size) || size % 2 != 0 || size > 2 * CHUNK_VOLUME) {
+		return false;
+	}
+	std::vector<unsigned char> data(size + CHUNK_AREA);
+	if (!in.read(reinterpret_cast<char*>(data.data()), data.size())) return false;
+	std::array<BlockID, CHUNK_VOLUME> blocks;
+	if (!decodeBlocks(data.data(), size, blocks.data())) return false;
+	chunk.assign(blocks.data());
+	std::memcpy(chunk.biomes.data(), data.data() + size, CHUNK_AREA);
+	return true;
+}
+
+void listStoredChunks(const char* directory, std::vector<glm::ivec3>& out) {
+	out.clear();
+	DIR* dir = opendir(directory);
+	if (dir == nullptr) return;
+	while (dirent* entry = readdir(dir)) {
+		glm::ivec3 position;
+		int length = 0;
+		if (std::sscanf(entry->d_name, "%d.%d.%d.chunk%n", &position.x, &position.y, &position.z, &length) != 3) continue;
+		if (entry->d_name[length] == '\0' && length > 0) out.push_back(position);
+	}
+	closedir(dir);
+}
@@ -0,0 +1,27 @@
+#ifndef WORLD_IO_H
+#define WORLD_IO_H
+
+#include "world.h"
+
+#include <vector>
+
+// Saves every loaded chunk to a single file, its blocks and then its biomes.
+// Blocks are run length encoded, which shrinks the mostly air or mostly stone
+// chunklets to a few bytes each.
+// Writes to path + ".tmp" first, so a crash mid-save never eats the old file.
+bool saveWorld(const World& world, const char* path);
+
+// Adds the chunks from a file written by saveWorld, replacing any already loaded.
+// Returns false if the file is missing or broken, the world may be half loaded then.
+bool loadWorld(World& world, const char* path);
+
+// One file per chunk in a directory, for chunks dropped from memory while the
+// server runs. The world file wins over this: only chunks that aren't loaded get
+// looked up here. Same block encoding as the world file.
+bool saveChunk(const Chunk& chunk, const char* directory);
+// false if the chunk has no file there or it's broken, the chunk is left alone then
+bool loadChunk(Chunk& chunk, const char* directory);
+// positions of every chunk with a file in the directory, none if there's no directory
+void listStoredChunks(const char* directory, std::vector<glm::ivec3>& out);
+
+#endif
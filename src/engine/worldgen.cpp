@@ -0,0 +1,167 @@
+#include "worldgen.h"
+#include "random.h"
+
+#include <algorithm>
+#include <atomic>
+#include <thread>
+#include <vector>
+
+static const int TREE_HEIGHT = 4;
+
+TerrainGenerator::TerrainGenerator(const unsigned char* pixels, int width, int height, uint64_t seed)
+	: heightmap(pixels), mapWidth(width), mapHeight(height), seed(seed), climate(seed) {
+}
+
+int TerrainGenerator::columnHeight(int x, int z, const ColumnClimate& column) const {
+	int px = floorMod(x, mapWidth);
+	int pz = floorMod(z, mapHeight);
+	float height = column.heightOffset + heightmap[pz * mapWidth + px] / 16.0f * column.heightScale;
+	// terrain has to fit in the bottom chunklet
+	return glm::clamp((int)height, 1, CHUNK_SIZE - 1);
+}
+
+int TerrainGenerator::heightAt(int x, int z) const {
+	return columnHeight(x, z, climate.column(x, z));
+}
+
+void TerrainGenerator::fillColumns(const Chunk& chunk, ColumnCache& columns) const {
+	int minX = chunk.position.x * CHUNK_SIZE - TREE_REACH;
+	int minZ = chunk.position.z * CHUNK_SIZE - TREE_REACH;
+	std::array<ColumnClimate, SPAN * SPAN> climates;
+	climate.fillArea(minX, minZ, SPAN, SPAN, climates.data());
+	for (int z = 0; z < SPAN; z++) {
+		for (int x = 0; x < SPAN; x++) {
+			int i = z * SPAN + x;
+			columns.heights[i] = columnHeight(minX + x, minZ + z, climates[i]);
+			columns.biomes[i] = climates[i].biome;
+		}
+	}
+}
+
+void TerrainGenerator::generate(Chunk& chunk) const {
+	ColumnCache columns;
+	fillColumns(chunk, columns);
+	for (int z = 0; z < CHUNK_SIZE; z++) {
+		for (int x = 0; x < CHUNK_SIZE; x++) {
+			chunk.biomes[z * CHUNK_SIZE + x] = columns.biomes[(z + TREE_REACH) * SPAN + x + TREE_REACH];
+		}
+	}
+
+	chunk.fill(BLOCK_AIR);
+	// terrain only lives in the bottom layer of chunklets for now
+	if (chunk.position.y == 0) {
+		BlockID* chunklet = chunk.mutableBlocks();
+		for(int x = 0; x < 16; x++) {
+			for(int z = 0; z < 16; z++) {
+				int column = (z + TREE_REACH) * SPAN + x + TREE_REACH;
+				int terrainHeight = columns.heights[column];
+				const BiomeInfo& biome = biomeInfo(columns.biomes[column]);
+				int fillerStart = terrainHeight - 1 - biome.fillerDepth;
+				for(int y = 0; y < fillerStart; y++) {
+					chunklet[y*256 + z * 16 + x] = BLOCK_STONE;
+				}
+				for(int y = fillerStart; y < terrainHeight - 1; y++) {
+					if (y < 0) continue;
+					chunklet[y*256 + z * 16 + x] = biome.filler;
+				}
+				chunklet[(terrainHeight-1) * 256 + z * 16 + x] = biome.surface;
+			}
+		}
+	}
+	decorate(chunk, columns);
+	chunk.compact();
+}
+
+// Writes a block if it lands inside the chunk. Leaves only fill air, so where
+// trees overlap the result doesn't depend on which one was drawn first.
+static void placeBlock(Chunk& chunk, const glm::ivec3& world, BlockID id) {
+	glm::ivec3 local = world - chunk.position * CHUNK_SIZE;
+	if (local.x < 0 || local.y < 0 || local.z < 0) return;
+	if (local.x >= CHUNK_SIZE || local.y >= CHUNK_SIZE || local.z >= CHUNK_SIZE) return;
+	if (id == BLOCK_LEAVES && chunk.get(local.x, local.y, local.z) != BLOCK_AIR) return;
+	chunk.set(local.x, local.y, local.z, id);
+}
+
+void TerrainGenerator::decorate(Chunk& chunk, const ColumnCache& columns) const {
+	// Trees can hang over chunk borders. Rather than waiting for the neighbours or
+	// writing into them, every chunk looks at each tree close enough to reach it
+	// and draws just its own part. The neighbours do the same for theirs.
+	glm::ivec3 origin = chunk.position * CHUNK_SIZE;
+	for (int z = 0; z < SPAN; z++) {
+		for (int x = 0; x < SPAN; x++) {
+			int terrainHeight = columns.heights[z * SPAN + x];
+			if (terrainHeight > 12) continue;
+			// below the top of the chunk's space and tall enough to reach its bottom
+			if (terrainHeight > origin.y + CHUNK_SIZE - 1 || terrainHeight + TREE_HEIGHT - 1 < origin.y) continue;
+			const BiomeInfo& biome = biomeInfo(columns.biomes[z * SPAN + x]);
+			if (biome.surface != BLOCK_GRASS) continue;
+			int worldX = origin.x - TREE_REACH + x;
+			int worldZ = origin.z - TREE_REACH + z;
+			HashRandom random(seed, glm::ivec3(worldX, 0, worldZ), FEATURE_TREES);
+			if (random.unit() >= biome.treeChance) continue;
+			placeTree(chunk, glm::ivec3(worldX, terrainHeight, worldZ));
+		}
+	}
+}
+
+void TerrainGenerator::placeTree(Chunk& chunk, const glm::ivec3& base) const {
+	for (int y = 0; y < TREE_HEIGHT - 1; y++) {
+		placeBlock(chunk, base + glm::ivec3(0, y, 0), BLOCK_LOG);
+	}
+	// a flat 5 x 5 canopy on top of the trunk
+	int top = base.y + TREE_HEIGHT - 1;
+	for (int dz = -TREE_REACH; dz <= TREE_REACH; dz++) {
+		for (int dx = -TREE_REACH; dx <= TREE_REACH; dx++) {
+			placeBlock(chunk, glm::ivec3(base.x + dx, top, base.z + dz), BLOCK_LEAVES);
+		}
+	}
+}
+
+void generateArea(World& world, const TerrainGenerator& generator, const glm::ivec3& min, const glm::ivec3& max, unsigned threads) {
+	// the map isn't safe to grow from several threads, so make the chunks first.
+	// Sky and void are left out, they'd only ever be air
+	std::vector<Chunk*> todo;
+	for (int cy = std::max(min.y, TerrainGenerator::BOTTOM_SECTION); cy <= std::min(max.y, TerrainGenerator::TOP_SECTION); cy++) {
+		for (int cz = min.z; cz <= max.z; cz++) {
+			for (int cx = min.x; cx <= max.x; cx++) {
+				if (world.getChunk(cx, cy, cz) != nullptr) continue;
+				todo.push_back(&world.createChunk(cx, cy, cz));
+			}
+		}
+	}
+
+	if (threads == 0) threads = std::thread::hardware_concurrency();
+	if (threads == 0) threads = 1;
+	if (threads > todo.size()) threads = (unsigned)todo.size();
+	std::atomic<size_t> next(0);
+	auto work = [&]() {
+		for (size_t i = next++; i < todo.size(); i = next++) generator.generate(*todo[i]);
+	};
+	std::vector<std::thread> workers;
+	for (unsigned i = 1; i < threads; i++) workers.emplace_back(work);
+	work();
+	for (std::thread& worker : workers) worker.join();
+}
+
+CaveCarver::CaveCarver(uint32_t seed, float tunnelWidth)
+	: first(seed), second(seed ^ 0x9E3779B9u), width(tunnelWidth) {
+}
+
+void CaveCarver::carve(Chunk& chunk) const {
+	const double frequency = 1.0 / 32.0;
+	glm::ivec3 origin = chunk.position * CHUNK_SIZE;
+	for (int y = 0; y < CHUNK_SIZE; y++) {
+		for (int z = 0; z < CHUNK_SIZE; z++) {
+			for (int x = 0; x < CHUNK_SIZE; x++) {
+				double wx = (origin.x + x) * frequency;
+				double wy = (origin.y + y) * frequency;
+				double wz = (origin.z + z) * frequency;
+				double a = first.octave3D_01(wx, wy, wz, 2) - 0.5;
+				if (a > width || a < -width) continue;
+				double b = second.octave3D_01(wx, wy, wz, 2) - 0.5;
+				if (b > width || b < -width) continue;
+				chunk.set(x, y, z, BLOCK_AIR);
+			}
+		}
+	}
+}
@@ -0,0 +1,73 @@
+#ifndef WORLDGEN_H
+#define WORLDGEN_H
+
+#include "biome.h"
+#include "world.h"
+
+#include "../../include/PerlinNoise/PerlinNoise.hpp"
+
+// Builds terrain out of a greyscale heightmap (0..255 per pixel), shaped by the
+// biome of each column: the biome scales the height and picks the surface blocks
+// and how many trees grow. The heightmap tiles, so any chunk column can be
+// generated. Everything random comes from the seed and the chunk's position, so
+// generate() is safe to call from several threads at once and gives the same
+// chunk every time.
+class TerrainGenerator {
+public:
+	TerrainGenerator(const unsigned char* pixels, int width, int height, uint64_t seed);
+
+	void generate(Chunk& chunk) const;
+	uint64_t worldSeed() const { return seed; }
+	// height of the ground at a world column, the first air block above it
+	int heightAt(int x, int z) const;
+	uint8_t biomeAt(int x, int z) const { return climate.column(x, z).biome; }
+
+	// how far a tree's leaves reach out from its trunk
+	static const int TREE_REACH = 2;
+	// Sections of every column the terrain reaches into. The ones above are sky and
+	// the ones below void, generating them would only make air, so they're left
+	// missing until something is built there.
+	static constexpr int BOTTOM_SECTION = 0;
+	static constexpr int TOP_SECTION = 0;
+	static bool hasTerrain(int cy) { return cy >= BOTTOM_SECTION && cy <= TOP_SECTION; }
+
+private:
+	// columns of a chunk plus TREE_REACH on every side, row by row along x
+	static const int SPAN = CHUNK_SIZE + 2 * TREE_REACH;
+	struct ColumnCache {
+		std::array<int, SPAN * SPAN> heights;
+		std::array<uint8_t, SPAN * SPAN> biomes;
+	};
+
+	int columnHeight(int x, int z, const ColumnClimate& column) const;
+	void fillColumns(const Chunk& chunk, ColumnCache& columns) const;
+	void decorate(Chunk& chunk, const ColumnCache& columns) const;
+	void placeTree(Chunk& chunk, const glm::ivec3& base) const;
+
+	const unsigned char* heightmap;
+	int mapWidth;
+	int mapHeight;
+	uint64_t seed;
+	ClimateMap climate;
+};
+
+// Creates and generates the chunks in the inclusive box min..max, spread over
+// threads (0 = one per core). Chunks that already exist are left alone, and so
+// are sections outside the terrain's vertical range.
+void generateArea(World& world, const TerrainGenerator& generator, const glm::ivec3& min, const glm::ivec3& max, unsigned threads);
+
+// Hollows out spaghetti caves: a block turns to air where two 3D noise fields
+// both sit close to their midpoint, which traces out long winding tunnels.
+class CaveCarver {
+public:
+	CaveCarver(uint32_t seed, float tunnelWidth);
+
+	void carve(Chunk& chunk) const;
+
+private:
+	siv::PerlinNoise first;
+	siv::PerlinNoise second;
+	float width;
+};
+
+#endif
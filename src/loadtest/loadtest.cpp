@@ -0,0 +1,432 @@
+// Load test: a server and hundreds of simulated players on one machine.
+//
+//   scuffed_loadtest [--players count] [--seconds duration] [--join-rate players per second]
+//                    [--view chunks] [--heightmap file] [--connect address:port] [--keep-chunks]
+//                    [--memory MiB]
+//
+// Every player walks a scripted random walk away from spawn, so the server keeps
+// generating and streaming new terrain, and breaks or places a block every couple
+// of seconds. By default the server runs in this process on its own thread, which
+// is what lets us report its tick times. --connect points the players at a
+// scuffed_server somewhere else instead, then only the client side numbers show up.
+// --memory caps the block storage of our own server (0 = no cap), small by default
+// so it keeps evicting chunks behind the players and reading them back.
+
+#include "../../include/stb_image.h"
+
+#include "../engine/chunk_sync.h"
+#include "../engine/simulation.h"
+#include "../engine/timestep.h"
+#include "../engine/worldgen.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+typedef std::chrono::steady_clock Clock;
+
+const double REPORT_INTERVAL = 5.0;
+
+struct LoadTestOptions {
+	int players = 200;
+	double seconds = 60.0;
+	double joinRate = 50.0;
+	int view = 6;
+	std::string heightmapPath = "../include/PerlinNoise/f8o8_0.bmp";
+	std::string address = ""; // empty = run our own server
+	int port = 0;
+	bool keepChunks = false;
+	size_t memoryMiB = 1;
+};
+
+static bool parseOptions(int argc, char** argv, LoadTestOptions& options) {
+	for (int i = 1; i < argc; i++) {
+		const char* flag = argv[i];
+		if (std::strcmp(flag, "--keep-chunks") == 0) {
+			options.keepChunks = true;
+			continue;
+		}
+		if (i + 1 >= argc) {
+			std::cout << "Missing value for " << flag << std::endl;
+			return false;
+		}
+		const char* value = argv[++i];
+		if (std::strcmp(flag, "--players") == 0) options.players = std::atoi(value);
+		else if (std::strcmp(flag, "--seconds") == 0) options.seconds = std::atof(value);
+		else if (std::strcmp(flag, "--join-rate") == 0) options.joinRate = std::atof(value);
+		else if (std::strcmp(flag, "--view") == 0) options.view = std::atoi(value);
+		else if (std::strcmp(flag, "--heightmap") == 0) options.heightmapPath = value;
+		else if (std::strcmp(flag, "--memory") == 0) options.memoryMiB = std::strtoull(value, nullptr, 10);
+		else if (std::strcmp(flag, "--connect") == 0) {
+			const char* colon = std::strrchr(value, ':');
+			if (colon == nullptr) {
+				std::cout << "--connect wants address:port" << std::endl;
+				return false;
+			}
+			options.address.assign(value, colon);
+			options.port = std::atoi(colon + 1);
+		} else {
+			std::cout << "Unknown option " << flag << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+// resident set size of this process
+static double residentMiB() {
+	std::ifstream statm("/proc/self/statm");
+	long pages = 0, resident = 0;
+	statm >> pages >> resident;
+	return resident * (double)sysconf(_SC_PAGESIZE) / (1024.0 * 1024.0);
+}
+
+static double percentile(const std::vector<double>& sorted, double fraction) {
+	if (sorted.empty()) return 0.0;
+	size_t index = (size_t)(fraction * (sorted.size() - 1) + 0.5);
+	return sorted[index];
+}
+
+// What the server thread hands over for reporting, guarded by lock.
+struct ServerStats {
+	std::mutex lock;
+	std::vector<double> tickMs; // since the last report
+	std::vector<double> allTickMs;
+	uint64_t chunksSent = 0;
+	uint64_t chunksGenerated = 0;
+	uint64_t bytesSent = 0;
+	size_t clients = 0;
+	size_t worldChunks = 0;
+	size_t worldBytes = 0;
+	uint64_t evictions = 0;
+};
+
+// The same loop scuffed_server runs, with evicted chunks kept in memory instead
+// of saved to disk and its numbers collected.
+class ServerThread {
+public:
+	ServerThread(const TerrainGenerator& generator, size_t memoryBytes, ServerStats& stats)
+		: generator(generator), memoryBytes(memoryBytes), stats(stats), running(true), ready(false), port(0) {
+		thread = std::thread(&ServerThread::run, this);
+		while (!ready) std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+	~ServerThread() {
+		stop();
+	}
+	void stop() {
+		running = false;
+		if (thread.joinable()) thread.join();
+	}
+	uint16_t boundPort() const { return port; }
+	// after stop()
+	uint64_t heldEvictionCount() const { return heldEvictions; }
+
+	// After stop(): blocks that differ from freshly generated terrain without a player
+	// having edited them. Grass and dirt turning into each other is random ticks.
+	size_t strayBlocks(const std::vector<glm::ivec3>& edited) const {
+		std::unordered_set<uint64_t> editedKeys;
+		// chunkKey packs any coordinates that fit in 21 bits, block ones too
+		for (const glm::ivec3& position : edited) editedKeys.insert(chunkKey(position.x, position.y, position.z));
+		size_t stray = 0;
+		auto compare = [&](const Chunk& chunk) {
+			Chunk fresh(chunk.position.x, chunk.position.y, chunk.position.z);
+			if (TerrainGenerator::hasTerrain(chunk.position.y)) generator.generate(fresh);
+			for (int i = 0; i < CHUNK_VOLUME; i++) {
+				BlockID is = chunk.blockData()[i];
+				BlockID was = fresh.blockData()[i];
+				if (is == was) continue;
+				if ((is == BLOCK_GRASS || is == BLOCK_DIRT) && (was == BLOCK_GRASS || was == BLOCK_DIRT)) continue;
+				glm::ivec3 position = chunk.position * CHUNK_SIZE + glm::ivec3(i % CHUNK_SIZE, i / CHUNK_AREA, (i / CHUNK_SIZE) % CHUNK_SIZE);
+				if (editedKeys.count(chunkKey(position.x, position.y, position.z)) == 0) stray++;
+			}
+		};
+		for (const auto& entry : world.allChunks()) compare(*entry.chunk);
+		// and what was evicted without coming back
+		for (const auto& entry : store) {
+			const glm::ivec3& position = entry.second->position;
+			if (world.getChunk(position.x, position.y, position.z) == nullptr) compare(*entry.second);
+		}
+		return stray;
+	}
+
+private:
+	void run() {
+		generateArea(world, generator, glm::ivec3(-4, 0, -4), glm::ivec3(3, 0, 3), 0);
+		Simulation simulation(world, glm::vec3(0.5f, 2.0f * CHUNK_SIZE, 0.5f), generator.worldSeed());
+		NetServer net;
+		net.listen("127.0.0.1", 0);
+		ChunkSyncServer sync(world, simulation.edits(), net);
+		MemoryGovernor governor;
+		governor.setBudget(MEMORY_VOXELS, memoryBytes);
+		for (const auto& entry : world.allChunks()) {
+			governor.track(entry.chunk->position, MEMORY_VOXELS, entry.chunk->memoryBytes());
+			governor.setPinned(entry.chunk->position, true);
+		}
+		governor.setEvictor([&](const glm::ivec3& position, bool dirty) {
+			const Chunk* chunk = world.getChunk(position.x, position.y, position.z);
+			if (chunk != nullptr && dirty) store[chunkKey(position.x, position.y, position.z)].reset(new Chunk(*chunk));
+			if (sync.clientHolds(position)) heldEvictions++;
+			world.removeChunk(position.x, position.y, position.z);
+			return true;
+		});
+		sync.setGenerator([&](int cx, int cy, int cz) -> Chunk* {
+			auto stored = store.find(chunkKey(cx, cy, cz));
+			if (!TerrainGenerator::hasTerrain(cy) && stored == store.end()) return nullptr;
+			Chunk& chunk = world.createChunk(cx, cy, cz);
+			if (stored != store.end()) chunk = *stored->second;
+			else generator.generate(chunk);
+			governor.track(chunk.position, MEMORY_VOXELS, chunk.memoryBytes());
+			return &chunk;
+		});
+		sync.setMemoryGovernor(&governor);
+		port = net.port();
+		ready = true;
+
+		FixedTimestep timestep(Simulation::TICKS_PER_SECOND, 5);
+		std::vector<glm::ivec3> changedChunks;
+		Clock::time_point last = Clock::now();
+		while (running) {
+			Clock::time_point now = Clock::now();
+			int ticks = timestep.advance(std::chrono::duration<double>(now - last).count());
+			last = now;
+			// a tick here is everything the server does for it: client messages, simulation, sending
+			ScopedTimer tickTime;
+			sync.handleMessages();
+			for (int i = 0; i < ticks; i++) simulation.tick();
+			if (ticks > 0) sync.update((uint32_t)simulation.ticks());
+			simulation.takeChangedChunks(changedChunks);
+			for (const glm::ivec3& position : changedChunks) {
+				governor.markDirty(position);
+				const Chunk* chunk = world.getChunk(position.x, position.y, position.z);
+				if (chunk != nullptr) governor.track(position, MEMORY_VOXELS, chunk->memoryBytes());
+			}
+			if (ticks > 0) {
+				// like scuffed_server, only right after update() marked what players hold
+				governor.enforce(64);
+				governor.nextFrame();
+				double ms = tickTime.elapsedMs() / ticks;
+				std::lock_guard<std::mutex> guard(stats.lock);
+				for (int i = 0; i < ticks; i++) {
+					stats.tickMs.push_back(ms);
+					stats.allTickMs.push_back(ms);
+				}
+				stats.chunksSent = sync.chunksSent();
+				stats.chunksGenerated = sync.chunksGenerated();
+				stats.bytesSent = net.bytesSent();
+				stats.clients = sync.clientCount();
+				stats.worldChunks = world.chunkCount();
+				stats.worldBytes = 0;
+				for (const auto& entry : world.allChunks()) stats.worldBytes += entry.chunk->memoryBytes();
+				stats.evictions = governor.stats(MEMORY_VOXELS).evictions;
+			}
+			net.poll((int)(timestep.tickSeconds() * (1.0 - timestep.alpha()) * 1000.0));
+		}
+	}
+
+	const TerrainGenerator& generator;
+	size_t memoryBytes;
+	// only the server thread touches these while it runs
+	World world;
+	std::unordered_map<uint64_t, std::unique_ptr<Chunk>> store; // evicted chunks that were edited
+	uint64_t heldEvictions = 0;
+	ServerStats& stats;
+	std::atomic<bool> running;
+	std::atomic<bool> ready;
+	std::atomic<uint16_t> port;
+	std::thread thread;
+};
+
+// One simulated player.
+struct Player {
+	World mirror;
+	std::unique_ptr<ChunkSyncClient> client;
+	std::mt19937 rng;
+	glm::vec3 position;
+	glm::vec3 heading;
+	float speed;
+	int ticksUntilTurn;
+	int ticksUntilEdit;
+};
+
+// edited collects every block a player tried to change
+static void stepPlayer(Player& player, std::vector<glm::ivec3>& edited) {
+	std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+	if (--player.ticksUntilTurn <= 0) {
+		float yaw = unit(player.rng) * 6.2831853f;
+		player.heading = glm::vec3(std::cos(yaw), 0.0f, std::sin(yaw));
+		// mostly walking, sometimes running off into the distance
+		player.speed = unit(player.rng) < 0.2f ? 10.0f : 4.3f;
+		player.ticksUntilTurn = 40 + (int)(unit(player.rng) * 80.0f);
+	}
+	player.position += player.heading * (player.speed / Simulation::TICKS_PER_SECOND);
+	player.client->move(player.position);
+
+	if (--player.ticksUntilEdit <= 0) {
+		glm::ivec3 target = glm::ivec3(glm::floor(player.position + player.heading * 3.0f));
+		target.y = (int)(unit(player.rng) * 12.0f);
+		BlockID id = unit(player.rng) < 0.5f ? BLOCK_AIR : BLOCK_DIRT;
+		player.client->setBlock(target, id);
+		edited.push_back(target);
+		player.ticksUntilEdit = 20 + (int)(unit(player.rng) * 40.0f);
+	}
+}
+
+int main(int argc, char** argv) {
+	LoadTestOptions options;
+	if (!parseOptions(argc, argv, options)) return 1;
+
+	int width, height, channels;
+	unsigned char* pixels = nullptr;
+	std::unique_ptr<TerrainGenerator> generator;
+	ServerStats stats;
+	std::unique_ptr<ServerThread> server;
+	if (options.address.empty()) {
+		pixels = stbi_load(options.heightmapPath.c_str(), &width, &height, &channels, 1);
+		if (!pixels) {
+			std::cout << "Failed to load heightmap " << options.heightmapPath << std::endl;
+			return 1;
+		}
+		// fixed seed so runs can be compared with each other
+		generator.reset(new TerrainGenerator(pixels, width, height, 1));
+		server.reset(new ServerThread(*generator, options.memoryMiB * 1024 * 1024, stats));
+		options.address = "127.0.0.1";
+		options.port = server->boundPort();
+	}
+	std::cout << "Load testing " << options.address << ":" << options.port << " with " << options.players
+		<< " players for " << options.seconds << " s" << std::endl;
+
+	double baseMiB = residentMiB();
+	std::vector<std::unique_ptr<Player>> players;
+	std::vector<glm::ivec3> edited;
+	int failed = 0;
+	double tickSeconds = 1.0 / Simulation::TICKS_PER_SECOND;
+	Clock::time_point start = Clock::now();
+	Clock::time_point nextTick = start;
+	Clock::time_point lastReport = start;
+	uint64_t lastSent = 0;
+	uint64_t lastGenerated = 0;
+	uint64_t lastBytes = 0;
+	std::cout << std::fixed << std::setprecision(2);
+
+	while (true) {
+		double elapsed = std::chrono::duration<double>(Clock::now() - start).count();
+		if (elapsed >= options.seconds) break;
+
+		// players trickle in at the join rate
+		int wanted = std::min(options.players, (int)(elapsed * options.joinRate) + 1);
+		while ((int)players.size() + failed < wanted) {
+			std::unique_ptr<Player> player(new Player());
+			player->client.reset(new ChunkSyncClient(player->mirror));
+			player->client->setDiscardChunks(!options.keepChunks);
+			player->rng.seed((uint32_t)players.size() + 1);
+			player->position = glm::vec3(0.5f, 14.0f, 0.5f);
+			player->heading = glm::vec3(1.0f, 0.0f, 0.0f);
+			player->speed = 4.3f;
+			player->ticksUntilTurn = 0;
+			player->ticksUntilEdit = 40;
+			if (!player->client->connect(options.address.c_str(), (uint16_t)options.port, options.view)) {
+				failed++;
+				continue;
+			}
+			players.push_back(std::move(player));
+		}
+
+		for (std::unique_ptr<Player>& player : players) {
+			if (!player->client->connected()) continue;
+			stepPlayer(*player, edited);
+			player->client->update();
+		}
+
+		double sinceReport = std::chrono::duration<double>(Clock::now() - lastReport).count();
+		if (sinceReport >= REPORT_INTERVAL) {
+			lastReport = Clock::now();
+			size_t connected = 0;
+			for (std::unique_ptr<Player>& player : players) {
+				if (player->client->connected()) connected++;
+			}
+			std::cout << "[" << std::setw(6) << elapsed << " s] " << connected << " players";
+			if (server) {
+				std::lock_guard<std::mutex> guard(stats.lock);
+				std::sort(stats.tickMs.begin(), stats.tickMs.end());
+				std::cout << " | tick p50 " << percentile(stats.tickMs, 0.5) << " p90 " << percentile(stats.tickMs, 0.9)
+					<< " p99 " << percentile(stats.tickMs, 0.99) << " max " << percentile(stats.tickMs, 1.0) << " ms"
+					<< " | " << (stats.chunksSent - lastSent) / sinceReport << " chunks/s served, "
+					<< (stats.chunksGenerated - lastGenerated) / sinceReport << " generated/s, "
+					<< (stats.bytesSent - lastBytes) / sinceReport / (1024.0 * 1024.0) << " MiB/s out"
+					<< " | " << stats.worldChunks << " chunks loaded";
+				stats.tickMs.clear();
+				lastSent = stats.chunksSent;
+				lastGenerated = stats.chunksGenerated;
+				lastBytes = stats.bytesSent;
+			}
+			std::cout << " | " << residentMiB() << " MiB resident" << std::endl;
+		}
+
+		nextTick += std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(tickSeconds));
+		if (nextTick > Clock::now()) {
+			std::this_thread::sleep_until(nextTick);
+		} else {
+			// running behind, the players themselves are the bottleneck
+			nextTick = Clock::now();
+		}
+	}
+
+	size_t connected = 0;
+	uint64_t received = 0;
+	uint64_t chunks = 0;
+	for (std::unique_ptr<Player>& player : players) {
+		if (player->client->connected()) connected++;
+		received += player->client->bytesReceived();
+		chunks += player->client->chunksReceived();
+	}
+	double totalMiB = residentMiB();
+	std::cout << "\n" << players.size() << " players joined, " << failed << " failed to connect, "
+		<< (players.size() - connected) << " dropped" << std::endl;
+	std::cout << "players received " << chunks << " chunks, " << received / (1024.0 * 1024.0) << " MiB" << std::endl;
+	if (server) {
+		std::lock_guard<std::mutex> guard(stats.lock);
+		std::sort(stats.allTickMs.begin(), stats.allTickMs.end());
+		std::cout << "server tick p50 " << percentile(stats.allTickMs, 0.5) << " p90 " << percentile(stats.allTickMs, 0.9)
+			<< " p99 " << percentile(stats.allTickMs, 0.99) << " p99.9 " << percentile(stats.allTickMs, 0.999)
+			<< " max " << percentile(stats.allTickMs, 1.0) << " ms over " << stats.allTickMs.size() << " ticks" << std::endl;
+		std::cout << "server sent " << stats.chunksSent / options.seconds << " chunks/s, generated "
+			<< stats.chunksGenerated / options.seconds << " chunks/s, " << stats.worldChunks << " chunks loaded ("
+			<< stats.worldBytes / (1024.0 * 1024.0) << " MiB of blocks), " << stats.evictions << " evicted" << std::endl;
+	}
+	if (!players.empty()) {
+		// players and server share this process, so this is both sides together
+		std::cout << "memory: " << (totalMiB - baseMiB) / players.size() * 1024.0 << " KiB resident per player"
+			<< (options.keepChunks ? " (players keep their chunks)" : "") << std::endl;
+	}
+
+	players.clear();
+	size_t stray = 0;
+	uint64_t heldEvictions = 0;
+	if (server) {
+		// edits must land on the terrain that's there, never on a blank section in its place
+		server->stop();
+		stray = server->strayBlocks(edited);
+		std::cout << edited.size() << " edits, " << stray << " blocks differ from generated terrain without being edited" << std::endl;
+		// a player holding an evicted chunk would miss every edit made to it from then on
+		heldEvictions = server->heldEvictionCount();
+		std::cout << heldEvictions << " chunks evicted while a player held them" << std::endl;
+	}
+	server.reset();
+	if (pixels) stbi_image_free(pixels);
+	return stray == 0 && heldEvictions == 0 ? 0 : 1;
+}
@@ -0,0 +1,119 @@
+// Bakes the client's assets into one archive the client can map at startup
+// instead of decoding PNGs and reading loose shader files.
+//
+//   scuffed_pack [--assets directory] [--out file] [--threads count]
+//
+// The block textures go in decoded, scaled and mipmapped as the texture array
+// "textures/blocks", every shader under assets/shaders as "shaders/<file>". Block
+// compressed copies go next to it: "textures/blocks.s3tc" (BC1 when every texel is
+// opaque, BC3 otherwise), and "textures/blocks.bc7" when it comes out closer to
+// them than S3TC. The client picks the best one its driver can sample, falling
+// back to the uncompressed array.
+
+#include "../engine/asset_archive.h"
+#include "../engine/asset_loader.h"
+#include "../engine/mesher.h"
+#include "../engine/texture_compression.h"
+#include "../engine/timestep.h"
+
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+struct PackOptions {
+	std::string assetsPath = "../assets";
+	std::string outPath = "assets.pak";
+	unsigned threads = 0;
+};
+
+static bool parseOptions(int argc, char** argv, PackOptions& options) {
+	for (int i = 1; i < argc; i++) {
+		const char* flag = argv[i];
+		if (i + 1 >= argc) {
+			std::cout << "Missing value for " << flag << std::endl;
+			return false;
+		}
+		const char* value = argv[++i];
+		if (std::strcmp(flag, "--assets") == 0) options.assetsPath = value;
+		else if (std::strcmp(flag, "--out") == 0) options.outPath = value;
+		else if (std::strcmp(flag, "--threads") == 0) options.threads = (unsigned)std::atoi(value);
+		else {
+			std::cout << "Unknown option " << flag << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+static bool isShaderFile(const std::string& name) {
+	for (const char* extension : {".vs", ".fs", ".gs"}) {
+		size_t length = std::strlen(extension);
+		if (name.size() > length && name.compare(name.size() - length, length, extension) == 0) return true;
+	}
+	return false;
+}
+
+// sorted, so the same assets always make the same archive
+static std::vector<std::string> listShaders(const std::string& directory) {
+	std::vector<std::string> names;
+	DIR* dir = opendir(directory.c_str());
+	if (dir == nullptr) return names;
+	while (dirent* entry = readdir(dir)) {
+		if (isShaderFile(entry->d_name)) names.push_back(entry->d_name);
+	}
+	closedir(dir);
+	std::sort(names.begin(), names.end());
+	return names;
+}
+
+int main(int argc, char** argv) {
+	PackOptions options;
+	if (!parseOptions(argc, argv, options)) return 1;
+	ScopedTimer packTime;
+	AssetArchiveWriter writer;
+
+	std::vector<std::string> texturePaths;
+	for (int slot = 0; slot < TEXTURE_COUNT; slot++) {
+		texturePaths.push_back(options.assetsPath + "/textures/blocks/" + TEXTURE_FILES[slot]);
+	}
+	TextureArrayData textures;
+	if (!loadTextureArray(texturePaths, BLOCK_TEXTURE_SIZE, options.threads, textures)) {
+		std::cout << "Not packing, some block textures failed to load" << std::endl;
+		return 1;
+	}
+	writer.addTextureArray("textures/blocks", textures.view());
+
+	bool opaque = true;
+	for (size_t i = 3; i < textures.levels[0].size(); i += 4) {
+		if (textures.levels[0][i] != 255) opaque = false;
+	}
+	TextureArrayData bc7, s3tc;
+	compressTextureArray(textures.view(), opaque ? TEXTURE_BC1 : TEXTURE_BC3, options.threads, s3tc);
+	writer.addTextureArray("textures/blocks.s3tc", s3tc.view());
+	// the client takes BC7 over S3TC whenever it's there, so it only goes in when it's better
+	compressTextureArray(textures.view(), TEXTURE_BC7, options.threads, bc7);
+	double bc7Error = compressionError(textures.view(), bc7);
+	double s3tcError = compressionError(textures.view(), s3tc);
+	if (bc7Error <= s3tcError) writer.addTextureArray("textures/blocks.bc7", bc7.view());
+	else std::cout << "Leaving BC7 out, its error " << bc7Error << " is above S3TC's " << s3tcError << std::endl;
+
+	std::string shaderDirectory = options.assetsPath + "/shaders";
+	std::vector<std::string> shaders = listShaders(shaderDirectory);
+	for (const std::string& name : shaders) {
+		std::ifstream file(shaderDirectory + "/" + name, std::ios::binary);
+		std::stringstream source;
+		source << file.rdbuf();
+		writer.addText("shaders/" + name, source.str());
+	}
+
+	if (!writer.write(options.outPath.c_str())) return 1;
+	std::cout << "Packed " << TEXTURE_COUNT << " block textures and " << shaders.size() << " shaders into "
+		<< options.outPath << " in " << packTime.elapsedMs() << " ms" << std::endl;
+	return 0;
+}
@@ -0,0 +1,238 @@
+// Dedicated server: generates or loads a world and keeps it ticking, no window or GPU needed.
+//
+//   scuffed_server [--radius chunks] [--mobs count] [--world file] [--heightmap file]
+//                  [--ticks count] [--autosave seconds] [--bind address] [--port port]
+//                  [--seed number] [--memory MiB]
+//
+// Ctrl+C saves the world and quits. --ticks runs that many ticks as fast as
+// possible and then exits, handy for timing the simulation. --port 0 turns
+// networking off. --memory caps the block storage of loaded chunks (0 = no cap):
+// past it the chunks no player has seen for longest are dropped, edited ones
+// saved next to the world file in <world>.chunks first, and they come back from
+// there when someone walks up to them again.
+
+#include "../../include/stb_image.h"
+
+#include "../engine/chunk_sync.h"
+#include "../engine/simulation.h"
+#include "../engine/timestep.h"
+#include "../engine/world_io.h"
+#include "../engine/worldgen.h"
+
+#include <chrono>
+#include <csignal>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <random>
+#include <string>
+#include <thread>
+#include <unordered_set>
+
+// most ticks we'll run to catch up after a stall before dropping time
+const int MAX_TICKS_PER_STEP = 5;
+const double STATUS_INTERVAL = 10.0;
+// chunks dropped per tick at most when over the memory budget
+const size_t EVICTIONS_PER_TICK = 64;
+
+static volatile std::sig_atomic_t running = 1;
+
+static void stopServer(int) {
+	running = 0;
+}
+
+struct ServerOptions {
+	int radius = 24;
+	int mobs = 0;
+	std::string worldPath = "world.scfw";
+	std::string heightmapPath = "../include/PerlinNoise/f8o8_0.bmp";
+	long ticks = 0; // 0 = run until stopped
+	double autosaveSeconds = 300.0;
+	std::string bindAddress = "0.0.0.0";
+	int port = 25565;
+	uint64_t seed = 20240601;
+	size_t memoryMiB = 1024;
+};
+
+static bool parseOptions(int argc, char** argv, ServerOptions& options) {
+	for (int i = 1; i < argc; i++) {
+		const char* flag = argv[i];
+		if (i + 1 >= argc) {
+			std::cout << "Missing value for " << flag << std::endl;
+			return false;
+		}
+		const char* value = argv[++i];
+		if (std::strcmp(flag, "--radius") == 0) options.radius = std::atoi(value);
+		else if (std::strcmp(flag, "--mobs") == 0) options.mobs = std::atoi(value);
+		else if (std::strcmp(flag, "--world") == 0) options.worldPath = value;
+		else if (std::strcmp(flag, "--heightmap") == 0) options.heightmapPath = value;
+		else if (std::strcmp(flag, "--ticks") == 0) options.ticks = std::atol(value);
+		else if (std::strcmp(flag, "--autosave") == 0) options.autosaveSeconds = std::atof(value);
+		else if (std::strcmp(flag, "--bind") == 0) options.bindAddress = value;
+		else if (std::strcmp(flag, "--port") == 0) options.port = std::atoi(value);
+		else if (std::strcmp(flag, "--seed") == 0) options.seed = std::strtoull(value, nullptr, 10);
+		else if (std::strcmp(flag, "--memory") == 0) options.memoryMiB = std::strtoull(value, nullptr, 10);
+		else {
+			std::cout << "Unknown option " << flag << std::endl;
+			return false;
+		}
+	}
+	return true;
+}
+
+static void save(const World& world, const ServerOptions& options) {
+	ScopedTimer saveTime;
+	if (saveWorld(world, options.worldPath.c_str())) {
+		std::cout << "Saved " << world.chunkCount() << " chunks to " << options.worldPath
+			<< " in " << saveTime.elapsedMs() << " ms" << std::endl;
+	}
+}
+
+int main(int argc, char** argv) {
+	ServerOptions options;
+	if (!parseOptions(argc, argv, options)) return 1;
+	std::signal(SIGINT, stopServer);
+	std::signal(SIGTERM, stopServer);
+
+	ScopedTimer startup;
+	int width, height, channels;
+	unsigned char* pixels = stbi_load(options.heightmapPath.c_str(), &width, &height, &channels, 1);
+	if (!pixels) {
+		std::cout << "Failed to load heightmap " << options.heightmapPath << std::endl;
+		return 1;
+	}
+	TerrainGenerator generator(pixels, width, height, options.seed);
+	World world;
+	MemoryGovernor governor;
+	governor.setBudget(MEMORY_VOXELS, options.memoryMiB * 1024 * 1024);
+	bool loaded = loadWorld(world, options.worldPath.c_str());
+	if (loaded) {
+		std::cout << "Loaded " << world.chunkCount() << " chunks from " << options.worldPath << std::endl;
+	} else {
+		generateArea(world, generator, glm::ivec3(-options.radius, 0, -options.radius), glm::ivec3(options.radius - 1, 0, options.radius - 1), 0);
+		std::cout << "Generated " << world.chunkCount() << " chunks" << std::endl;
+	}
+	for (const auto& entry : world.allChunks()) {
+		const glm::ivec3& position = entry.chunk->position;
+		governor.track(position, MEMORY_VOXELS, entry.chunk->memoryBytes());
+		// the chunk store only has what was evicted, anything from the world file may differ from it
+		if (loaded) governor.markDirty(position);
+		// mobs live in the starting area, it stays loaded so they always have ground
+		bool start = position.x >= -options.radius && position.x < options.radius && position.z >= -options.radius && position.z < options.radius;
+		if (start) governor.setPinned(position, true);
+	}
+	std::string chunkDirectory = options.worldPath + ".chunks";
+	// sky and void are never generated, the store is the only place a section built
+	// there comes back from, so keep track of which are in it instead of asking the disk
+	std::unordered_set<uint64_t> storedOutsideTerrain;
+	std::vector<glm::ivec3> stored;
+	listStoredChunks(chunkDirectory.c_str(), stored);
+	for (const glm::ivec3& position : stored) {
+		if (!TerrainGenerator::hasTerrain(position.y)) storedOutsideTerrain.insert(chunkKey(position.x, position.y, position.z));
+	}
+	governor.setEvictor([&](const glm::ivec3& position, bool dirty) {
+		const Chunk* chunk = world.getChunk(position.x, position.y, position.z);
+		if (chunk != nullptr && dirty) {
+			if (!saveChunk(*chunk, chunkDirectory.c_str())) return false;
+			if (!TerrainGenerator::hasTerrain(position.y)) storedOutsideTerrain.insert(chunkKey(position.x, position.y, position.z));
+		}
+		world.removeChunk(position.x, position.y, position.z);
+		return true;
+	});
+
+	// nobody is connected yet, the player just stands at spawn
+	Simulation simulation(world, glm::vec3(0.5f, 2.0f * CHUNK_SIZE, 0.5f), options.seed);
+	std::mt19937 rng(1);
+	float spread = options.radius * CHUNK_SIZE * 0.9f;
+	std::uniform_real_distribution<float> coord(-spread, spread);
+	for (int i = 0; i < options.mobs; i++) {
+		spawnMob(simulation.entityRegistry(), glm::vec3(coord(rng), 2.0f * CHUNK_SIZE, coord(rng)), (uint32_t)i + 1);
+	}
+
+	NetServer net;
+	ChunkSyncServer sync(world, simulation.edits(), net);
+	// past the starting area, terrain is made as players walk into it, or read
+	// back if it was edited and then evicted
+	sync.setGenerator([&](int cx, int cy, int cz) -> Chunk* {
+		if (!TerrainGenerator::hasTerrain(cy) && storedOutsideTerrain.count(chunkKey(cx, cy, cz)) == 0) return nullptr;
+		Chunk& chunk = world.createChunk(cx, cy, cz);
+		if (!loadChunk(chunk, chunkDirectory.c_str())) generator.generate(chunk);
+		governor.track(chunk.position, MEMORY_VOXELS, chunk.memoryBytes());
+		return &chunk;
+	});
+	sync.setMemoryGovernor(&governor);
+	bool networked = options.port > 0;
+	if (networked) {
+		if (!net.listen(options.bindAddress.c_str(), (uint16_t)options.port)) return 1;
+		std::cout << "Listening on " << options.bindAddress << ":" << net.port() << std::endl;
+	}
+	std::cout << "Ready in " << startup.elapsedMs() << " ms" << std::endl;
+
+	typedef std::chrono::steady_clock Clock;
+	FixedTimestep timestep(Simulation::TICKS_PER_SECOND, MAX_TICKS_PER_STEP);
+	RollingTimer tickTimer(Simulation::TICKS_PER_SECOND * 10);
+	std::vector<glm::ivec3> changedChunks;
+	Clock::time_point last = Clock::now();
+	Clock::time_point lastStatus = last;
+	Clock::time_point lastSave = last;
+
+	while (running) {
+		Clock::time_point now = Clock::now();
+		int ticks = 1;
+		if (options.ticks == 0) {
+			ticks = timestep.advance(std::chrono::duration<double>(now - last).count());
+		}
+		last = now;
+		if (networked) sync.handleMessages();
+		for (int i = 0; i < ticks; i++) {
+			ScopedTimer tickTime;
+			simulation.tick();
+			tickTimer.add(tickTime.elapsedMs());
+		}
+		// everything that changed over these ticks goes out in one batch
+		if (networked && ticks > 0) sync.update((uint32_t)simulation.ticks());
+		// nothing to remesh here, but edited chunks have to be saved before they're evicted,
+		// and a uniform section that got its first odd block now holds storage
+		simulation.takeChangedChunks(changedChunks);
+		for (const glm::ivec3& position : changedChunks) {
+			governor.markDirty(position);
+			const Chunk* chunk = world.getChunk(position.x, position.y, position.z);
+			if (chunk != nullptr) governor.track(position, MEMORY_VOXELS, chunk->memoryBytes());
+		}
+		// only once held chunks were marked visible: update() runs on ticks, and an
+		// iteration cut short by network traffic would see them all as unused
+		if (ticks > 0) {
+			governor.enforce(EVICTIONS_PER_TICK);
+			governor.nextFrame();
+		}
+
+		if (options.ticks > 0 && (long)simulation.ticks() >= options.ticks) break;
+		if (std::chrono::duration<double>(now - lastStatus).count() > STATUS_INTERVAL) {
+			lastStatus = now;
+			std::cout << "tick " << simulation.ticks() << ": " << tickTimer.average() << " ms (max " << tickTimer.max() << ")"
+				<< ", " << simulation.entityRegistry().size() << " entities"
+				<< ", " << sync.clientCount() << " clients"
+				<< ", " << world.chunkCount() << " chunks (" << (governor.stats(MEMORY_VOXELS).bytes >> 20) << " MiB, "
+				<< governor.stats(MEMORY_VOXELS).evictions << " evicted)"
+				<< ", dropped " << timestep.droppedSeconds() << " s" << std::endl;
+		}
+		if (options.autosaveSeconds > 0.0 && std::chrono::duration<double>(now - lastSave).count() > options.autosaveSeconds) {
+			lastSave = now;
+			save(world, options);
+		}
+		if (options.ticks == 0 || networked) {
+			// wait for the next tick, handling network traffic as it comes in
+			double wait = options.ticks == 0 ? timestep.tickSeconds() * (1.0 - timestep.alpha()) : 0.0;
+			if (networked) {
+				net.poll((int)(wait * 1000.0));
+			} else {
+				std::this_thread::sleep_for(std::chrono::duration<double>(wait));
+			}
+		}
+	}
+
+	std::cout << "Stopping after " << simulation.ticks() << " ticks, average " << tickTimer.average() << " ms per tick" << std::endl;
+	save(world, options);
+	stbi_image_free(pixels);
+	return 0;
+}